@@ -17,9 +17,10 @@
 #include <Box2D/Collision/Shapes/b2CircleShape.h>
 
 #include "b2draw/DebugDraw.h"
+#include "b2draw/ProgramLibrary.h"
+#include "b2draw/Transport.h"
 
-#include "./util/deleters.h"
-#include "./util/gl.h"
+#include "./util/window.h"
 
 
 constexpr int screenWidth{640};
@@ -31,15 +32,6 @@ constexpr unsigned velocityIterations{8};
 constexpr unsigned positionIterations{3};
 
 
-constexpr char const* const pPositionAttribName = "position";
-constexpr char const* const pColourAttribName = "colour";
-
-
-using sdl_window_ptr = std::unique_ptr<SDL_Window, demo::WindowDeleter>;
-
-using gl_context_ptr = std::unique_ptr<void, demo::GLContextDeleter>;
-
-
 void logBodies(b2World const* pWorld)
 {
 	for (
@@ -56,162 +48,36 @@ void logBodies(b2World const* pWorld)
 }
 
 
-/**
- * Initialise SDL and the window.
- *
- * @returns a unique_ptr to the window.
- */
-sdl_window_ptr initSDL()
-{
-	// Initialise SDL with video and events.
-	atexit(SDL_Quit); // SDL_Quit is safe to call even if SDL_Init failed.
-	if (SDL_Init(SDL_INIT_VIDEO) < 0)
-	{
-		std::cerr << "SDL_Init failed!" << std::endl;
-		throw std::runtime_error{SDL_GetError()};
-	}
-
-	// Initialise the window.
-	sdl_window_ptr pWindow{
-		SDL_CreateWindow(
-			"Debug draw demo",
-			SDL_WINDOWPOS_UNDEFINED,
-			SDL_WINDOWPOS_UNDEFINED,
-			screenWidth,
-			screenHeight,
-			SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN
-		)
-	};
-	if (not pWindow)
-	{
-		std::cerr << "SDL_CreateWindow failed!" << std::endl;
-		throw std::runtime_error{SDL_GetError()};
-	}
-
-	return pWindow;
-}
-
-
-/**
- * Initialise OpenGL and GLEW.
- *
- * @returns a unique_ptr to the GL context.
- */
-gl_context_ptr initGL(SDL_Window* pWindow)
-{
-	// Set OpenGL version to 3.1, and use Core profile.
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 1);
-	SDL_GL_SetAttribute(
-		SDL_GL_CONTEXT_PROFILE_MASK,
-		SDL_GL_CONTEXT_PROFILE_CORE
-	);
-
-	// Initialise the OpenGL context.
-	gl_context_ptr pGLContext{SDL_GL_CreateContext(pWindow)};
-	if (!pGLContext)
-	{
-		std::cerr << "SDL_GL_CreateContext failed: " << SDL_GetError()
-			<< std::endl;
-		throw std::runtime_error{"SDL_GL_CreateContext failed"};
-	}
-
-	// Initialise GLEW.
-	glewExperimental = GL_TRUE;
-	{
-		GLenum glewError = glewInit();
-		if (glewError != GLEW_OK)
-		{
-			std::cerr << "GLEW error: " << glewGetErrorString(glewError)
-				<< std::endl;
-			throw std::runtime_error{"glewInit failed"};
-		}
-	}
-
-	// Try to set VSync; failure is OK here.
-	if (SDL_GL_SetSwapInterval(1) < 0)
-	{
-		std::cout << "[Warning] Failed to set VSync: " << SDL_GetError()
-			<< std::endl;
-	}
-
-	return pGLContext;
-}
-
-
-/**
- * Create a GL program and add compiled shaders.
- *
- * @returns the ID of the created program.
- */
-GLuint const createProgram()
-{
-	// Create OpenGL shaders and program.
-	GLuint const vertShaderID{demo::compileShader(GL_VERTEX_SHADER, R"GLS(\
-#version 330 core
-
-layout(location = 0) in vec2 position;
-layout(location = 1) in vec4 colour;
-
-out vec4 fsColour;
-uniform mat4 MVP;
-
-
-void main() {
-	gl_Position =  MVP * vec4(position.x, position.y, 0, 1);
-	fsColour = colour;
-}
-
-	)GLS")};
-
-	GLuint const fragShaderID{demo::compileShader(GL_FRAGMENT_SHADER, R"GLS(\
-#version 330 core
-
-in vec4 fsColour;
-out vec4 fragColour;
-
-void main() {
-	fragColour = fsColour;
-}
-	)GLS")};
-
-	GLuint const programID{glCreateProgram()};
-	glAttachShader(programID, vertShaderID);
-	glAttachShader(programID, fragShaderID);
-	glLinkProgram(programID);
-	{
-		GLint success{GL_FALSE};
-		glGetProgramiv(programID, GL_LINK_STATUS, &success);
-		if (success != GL_TRUE)
-		{
-			std::cout << "Failed to link program: "
-				<< demo::getProgramLog(programID) << std::endl;
-			throw std::runtime_error{"Program link failed"};
-		}
-	}
-
-	return programID;
-}
-
-
 void run(int argc, char const* const argv[])
 {
-	auto pWindow{initSDL()};
-	auto pGLContext{initGL(pWindow.get())};
-	auto programID{createProgram()};
+	auto pWindow{demo::initSDL("Debug draw demo", screenWidth, screenHeight)};
+	auto pGLContext{demo::initGL(pWindow.get())};
+
+	// Cache program binaries in the directory given on the command line, if any.
+	char const* const pCacheDir = argc > 1 ? argv[1] : "";
+	b2draw::ProgramLibrary programs{pCacheDir};
 
 	// Set up scene for rendering.
 	glClearColor(0.3f, 0.3f, 0.3f, 1.f);
 
 	b2draw::DebugDraw debugDraw{
-		glGetAttribLocation(programID, pPositionAttribName),
-		glGetAttribLocation(programID, pColourAttribName),
+		b2draw::ProgramLibrary::s_positionLocation,
+		b2draw::ProgramLibrary::s_colourLocation,
 		16,
 		0.01f,
 		4.f
 	};
 	debugDraw.SetFlags(0xff);
 
+	// Publish frames for b2draw-viewer under the shared-memory name given on
+	// the command line, if any.
+	std::unique_ptr<b2draw::SharedMemoryPublisher> pPublisher;
+	if (argc > 2)
+	{
+		pPublisher.reset(new b2draw::SharedMemoryPublisher{argv[2]});
+		debugDraw.SetFrameSink(pPublisher.get());
+	}
+
 	b2Vec2 const gravity{0.0f, -9.8f};
 	b2World world{gravity};
 	world.SetDebugDraw(&debugDraw);
@@ -286,12 +152,13 @@ void run(int argc, char const* const argv[])
 	glm::mat4 const modelMat{1.0f};
 
 	auto const mvpMat{projMat * viewMat * modelMat};
-	auto const pMvpMatStart{&mvpMat[0][0]};
-	auto const mvpAttribLoc{glGetUniformLocation(programID, "MVP")};
-	if (mvpAttribLoc < 0)
-	{
-		throw std::runtime_error{"Unable to locate uniform 'MVP'"};
-	}
+	programs.setMatrix(&mvpMat[0][0]);
+
+	// Pick the fastest way of submitting geometry on this driver.
+	programs.use(b2draw::ProgramKind::plain);
+	auto const calibration = debugDraw.Calibrate();
+	std::cout << "Submission strategy: "
+		<< b2draw::toString(calibration.strategy) << std::endl;
 
 
 	auto const update = [&debugDraw, &world] {
@@ -305,14 +172,11 @@ void run(int argc, char const* const argv[])
 
 	auto const render = [
 		&debugDraw,
-		programID,
-		pSDLWindow = pWindow.get(),
-		mvpAttribLoc,
-		pMvpMatStart
+		&programs,
+		pSDLWindow = pWindow.get()
 	] {
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glUseProgram(programID);
-		glUniformMatrix4fv(mvpAttribLoc, 1, GL_FALSE, pMvpMatStart);
+		programs.use(b2draw::ProgramKind::plain);
 		debugDraw.Render();
 		SDL_GL_SwapWindow(pSDLWindow);
 	};
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <stdexcept>
+
+#include <GL/glew.h>
+#include <SDL2/SDL_opengl.h>
+
+#include "./window.h"
+
+
+namespace demo {
+
+
+sdl_window_ptr
+initSDL(char const* const pTitle, int const width, int const height)
+{
+	// Initialise SDL with video and events.
+	atexit(SDL_Quit); // SDL_Quit is safe to call even if SDL_Init failed.
+	if (SDL_Init(SDL_INIT_VIDEO) < 0)
+	{
+		std::cerr << "SDL_Init failed!" << std::endl;
+		throw std::runtime_error{SDL_GetError()};
+	}
+
+	// Initialise the window.
+	sdl_window_ptr pWindow{
+		SDL_CreateWindow(
+			pTitle,
+			SDL_WINDOWPOS_UNDEFINED,
+			SDL_WINDOWPOS_UNDEFINED,
+			width,
+			height,
+			SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN
+		)
+	};
+	if (not pWindow)
+	{
+		std::cerr << "SDL_CreateWindow failed!" << std::endl;
+		throw std::runtime_error{SDL_GetError()};
+	}
+
+	return pWindow;
+}
+
+
+gl_context_ptr
+initGL(SDL_Window* const pWindow)
+{
+	// Set OpenGL version to 3.3, and use Core profile.
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+	SDL_GL_SetAttribute(
+		SDL_GL_CONTEXT_PROFILE_MASK,
+		SDL_GL_CONTEXT_PROFILE_CORE
+	);
+
+	// Initialise the OpenGL context.
+	gl_context_ptr pGLContext{SDL_GL_CreateContext(pWindow)};
+	if (!pGLContext)
+	{
+		std::cerr << "SDL_GL_CreateContext failed: " << SDL_GetError()
+			<< std::endl;
+		throw std::runtime_error{"SDL_GL_CreateContext failed"};
+	}
+
+	// Initialise GLEW.
+	glewExperimental = GL_TRUE;
+	{
+		GLenum glewError = glewInit();
+		if (glewError != GLEW_OK)
+		{
+			std::cerr << "GLEW error: " << glewGetErrorString(glewError)
+				<< std::endl;
+			throw std::runtime_error{"glewInit failed"};
+		}
+	}
+
+	// Try to set VSync; failure is OK here.
+	if (SDL_GL_SetSwapInterval(1) < 0)
+	{
+		std::cout << "[Warning] Failed to set VSync: " << SDL_GetError()
+			<< std::endl;
+	}
+
+	return pGLContext;
+}
+
+
+} // namespace demo
@@ -0,0 +1,35 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__DEMO__WINDOW__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__DEMO__WINDOW__H
+#include <memory>
+
+#include <SDL2/SDL.h>
+
+#include "./deleters.h"
+
+
+namespace demo {
+
+
+using sdl_window_ptr = std::unique_ptr<SDL_Window, WindowDeleter>;
+
+using gl_context_ptr = std::unique_ptr<void, GLContextDeleter>;
+
+
+/**
+ * Initialise SDL and the window.
+ *
+ * @returns a unique_ptr to the window.
+ */
+sdl_window_ptr initSDL(char const* pTitle, int width, int height);
+
+
+/**
+ * Initialise OpenGL and GLEW.
+ *
+ * @returns a unique_ptr to the GL context.
+ */
+gl_context_ptr initGL(SDL_Window* pWindow);
+
+
+} // namespace demo
+#endif // #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__DEMO__WINDOW__H
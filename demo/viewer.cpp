@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+
+#include <SDL2/SDL.h>
+#include <GL/glew.h>
+#include <SDL2/SDL_opengl.h>
+
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "b2draw/DebugDraw.h"
+#include "b2draw/ProgramLibrary.h"
+#include "b2draw/Transport.h"
+
+#include "./util/window.h"
+
+
+constexpr int screenWidth{800};
+constexpr int screenHeight{600};
+
+// Reattach if the publisher goes quiet for this long, in case it restarted.
+constexpr std::chrono::seconds reattachTimeout{2};
+
+
+void usage()
+{
+	std::cout << "Usage: b2draw-viewer [SHM_NAME | --socket PATH]\n"
+		"Views frames published by a b2draw::SharedMemoryPublisher (default\n"
+		"name /b2draw) or b2draw::SocketPublisher." << std::endl;
+}
+
+
+/** @returns the source, or null if the publisher isn't available yet. */
+std::unique_ptr<b2draw::FrameSource> attach(
+	std::string const& name,
+	bool useSocket
+)
+{
+	try
+	{
+		if (useSocket) {
+			return std::unique_ptr<b2draw::FrameSource>{
+				new b2draw::SocketSubscriber{name}};
+		}
+		return std::unique_ptr<b2draw::FrameSource>{
+			new b2draw::SharedMemorySubscriber{name}};
+	}
+	catch (std::runtime_error const&)
+	{
+		return nullptr;
+	}
+}
+
+
+/** Fit an orthographic projection around all of a frame's vertices. */
+glm::mat4 fitFrame(b2draw::FrameView const& frame, float aspectRatio)
+{
+	float constexpr inf{std::numeric_limits<float>::infinity()};
+	b2Vec2 lower{inf, inf};
+	b2Vec2 upper{-inf, -inf};
+	for (std::size_t i = 0; i < frame.sectionCount; ++i)
+	{
+		auto const& primitives = frame.sections[i].primitives;
+		for (std::size_t j = 0; j < primitives.vertexCount; ++j)
+		{
+			lower = b2Min(lower, primitives.pVertices[j].first);
+			upper = b2Max(upper, primitives.pVertices[j].first);
+		}
+	}
+	if (lower.x > upper.x) {
+		return glm::mat4{1.0f};
+	}
+
+	b2Vec2 const centre{0.5f * (lower + upper)};
+	b2Vec2 extents{0.55f * (upper - lower)};
+	extents.x = std::max({extents.x, extents.y * aspectRatio, 1.0f});
+	extents.y = extents.x / aspectRatio;
+	return glm::ortho(
+		centre.x - extents.x,
+		centre.x + extents.x,
+		centre.y - extents.y,
+		centre.y + extents.y
+	);
+}
+
+
+void run(int argc, char const* const argv[])
+{
+	std::string name{"/b2draw"};
+	bool useSocket{false};
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--socket") == 0 && i + 1 < argc)
+		{
+			useSocket = true;
+			name = argv[++i];
+		}
+		else if (argv[i][0] == '-')
+		{
+			usage();
+			return;
+		}
+		else {
+			name = argv[i];
+		}
+	}
+
+	auto pWindow{demo::initSDL("b2draw viewer", screenWidth, screenHeight)};
+	auto pGLContext{demo::initGL(pWindow.get())};
+
+	b2draw::ProgramLibrary programs;
+	glClearColor(0.3f, 0.3f, 0.3f, 1.f);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	b2draw::DebugDraw debugDraw{
+		b2draw::ProgramLibrary::s_positionLocation,
+		b2draw::ProgramLibrary::s_colourLocation
+	};
+	debugDraw.SetPointSizeAttribLocation(
+		b2draw::ProgramLibrary::s_pointSizeLocation);
+
+	using Clock = std::chrono::steady_clock;
+	std::unique_ptr<b2draw::FrameSource> pSource;
+	auto lastFrameTime = Clock::now();
+	bool haveFrame{false};
+
+	SDL_Event event;
+	bool userQuit{false};
+	while (not userQuit)
+	{
+		while (SDL_PollEvent(&event) != 0)
+		{
+			if (
+				event.type == SDL_QUIT ||
+				(
+					event.type == SDL_KEYDOWN &&
+					event.key.keysym.sym == SDLK_ESCAPE
+				)
+			)
+			{
+				userQuit = true;
+			}
+		}
+
+		auto const now = Clock::now();
+		if (!pSource || now - lastFrameTime > reattachTimeout)
+		{
+			if (auto pNewSource = attach(name, useSocket))
+			{
+				pSource = std::move(pNewSource);
+				haveFrame = false;
+			}
+			lastFrameTime = now;
+		}
+
+		// Buffer the newest frame straight from the source. Shared memory may
+		// be overwritten meanwhile, in which case skip it until the next.
+		b2draw::FrameView frame;
+		if (pSource && pSource->poll(frame))
+		{
+			lastFrameTime = now;
+			auto const mvp = fitFrame(
+				frame, float(screenWidth) / float(screenHeight));
+			programs.setMatrix(&mvp[0][0]);
+			debugDraw.BufferData(frame);
+			haveFrame = pSource->intact();
+		}
+
+		glClear(GL_COLOR_BUFFER_BIT);
+		if (haveFrame && pSource->intact())
+		{
+			programs.use(b2draw::ProgramKind::plain);
+			debugDraw.Render();
+		}
+		else {
+			haveFrame = false;
+		}
+		SDL_GL_SwapWindow(pWindow.get());
+	}
+}
+
+
+int main(int argc, char const* const argv[])
+{
+	try
+	{
+		run(argc, argv);
+	}
+	catch (std::exception const& err)
+	{
+		std::cout << "[Fatal] " << err.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
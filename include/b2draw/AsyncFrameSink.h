@@ -0,0 +1,86 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__ASYNCFRAMESINK__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__ASYNCFRAMESINK__H
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "b2draw/Frame.h"
+
+
+namespace b2draw {
+
+
+/**
+ * A frame sink which processes frames on a background thread.
+ *
+ * Each frame is serialised by @ref write into a recycled record (see @ref
+ * writeFrameRecord) and queued for the background thread, which passes it to
+ * @ref consume. If the queue is full, frames are dropped and counted rather
+ * than blocking the caller.
+ *
+ * Derived classes must call @ref start once constructed, and @ref stop
+ * before they are destroyed.
+ */
+class AsyncFrameSink
+	:	public FrameSink
+{
+public:
+	AsyncFrameSink(AsyncFrameSink const&) = delete;
+	AsyncFrameSink& operator=(AsyncFrameSink const&) = delete;
+
+	virtual ~AsyncFrameSink() noexcept override;
+
+	virtual void write(FrameView const& frame) override final;
+
+	inline std::size_t framesWritten() const noexcept
+	{ return m_framesWritten; }
+
+	inline std::size_t framesDropped() const noexcept
+	{ return m_framesDropped; }
+
+protected:
+	explicit AsyncFrameSink(std::size_t maxQueuedFrames);
+
+	/** Start the background thread. */
+	void start();
+
+	/** Process any queued frames, then stop the background thread. */
+	void stop() noexcept;
+
+	/**
+	 * Process a frame on the background thread.
+	 *
+	 * @param pRecord an 8-byte aligned frame record.
+	 * @returns false on failure, after which no more frames are consumed.
+	 */
+	virtual bool consume(void const* pRecord, std::size_t size) = 0;
+
+	/** Whether @ref consume has failed. Safe to call once stopped. */
+	inline bool failed() const noexcept
+	{ return m_failed; }
+
+private:
+	using Record = std::vector<std::uint64_t>;
+
+	void run() noexcept;
+
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::deque<Record> m_queue;
+	std::vector<Record> m_spareRecords;
+	std::size_t m_maxQueuedFrames;
+	bool m_stopping;
+	bool m_failed;
+
+	std::atomic<std::size_t> m_framesWritten;
+	std::atomic<std::size_t> m_framesDropped;
+	std::thread m_thread;
+};
+
+
+} // namespace b2draw
+#endif // #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__ASYNCFRAMESINK__H
@@ -0,0 +1,102 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__CAPTURE__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__CAPTURE__H
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "b2draw/AsyncFrameSink.h"
+
+
+namespace b2draw {
+
+
+/**
+ * Records frames to a capture file on a background thread.
+ *
+ * Install with DebugDraw::SetFrameSink. Frames are written out on a
+ * background thread, so recording never waits on I/O; see @ref
+ * AsyncFrameSink.
+ *
+ * The file consists of a header, the frame records, and a footer holding a
+ * table of frame offsets, which @ref CaptureReader uses to seek.
+ */
+class CaptureWriter
+	:	public AsyncFrameSink
+{
+public:
+	/** @throws std::runtime_error if the file can't be opened. */
+	explicit CaptureWriter(
+		std::string const& path,
+		std::size_t maxQueuedFrames = 8u
+	);
+
+	CaptureWriter(CaptureWriter const&) = delete;
+	CaptureWriter& operator=(CaptureWriter const&) = delete;
+
+	/** Close the file, discarding any error. */
+	virtual ~CaptureWriter() noexcept override;
+
+	/**
+	 * Write any queued frames and the footer, then close the file.
+	 *
+	 * @throws std::runtime_error if writing failed at any point.
+	 */
+	void close();
+
+protected:
+	virtual bool consume(void const* pRecord, std::size_t size) override;
+
+private:
+	std::FILE* m_pFile;
+
+	// Only touched by the writer thread until it has been stopped.
+	std::vector<std::uint64_t> m_frameOffsets;
+	std::uint64_t m_offset;
+};
+
+
+/**
+ * Memory-maps a capture file for replay.
+ *
+ * Frames are viewed directly in the mapping, so they can be passed straight
+ * to DebugDraw::BufferData(FrameView const&) with no parsing or copying.
+ * Seeking to a frame is a lookup in the file's frame offset table. Files whose
+ * footer is missing, e.g. because the recording process crashed, are indexed
+ * by scanning their records instead.
+ */
+class CaptureReader
+{
+public:
+	/** @throws std::runtime_error if the file can't be mapped or is invalid. */
+	explicit CaptureReader(std::string const& path);
+
+	CaptureReader(CaptureReader const&) = delete;
+	CaptureReader& operator=(CaptureReader const&) = delete;
+
+	~CaptureReader() noexcept;
+
+	inline std::size_t frameCount() const noexcept
+	{ return m_frameCount; }
+
+	/**
+	 * View a frame, valid for as long as the reader.
+	 *
+	 * @throws std::out_of_range if @p index is not less than @ref frameCount.
+	 * @throws std::runtime_error if the frame is corrupt.
+	 */
+	FrameView frame(std::size_t index) const;
+
+private:
+	void scanFrames();
+
+	char const* m_pData;
+	std::size_t m_size;
+	std::uint64_t const* m_pFrameOffsets;
+	std::vector<std::uint64_t> m_scannedOffsets;
+	std::size_t m_frameCount;
+};
+
+
+} // namespace b2draw
+#endif // #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__CAPTURE__H
@@ -0,0 +1,137 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__CIRCLERENDERER__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__CIRCLERENDERER__H
+#include <array>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <Box2D/Common/b2Draw.h>
+
+#include "b2draw/ResourcePool.h"
+
+
+namespace b2draw {
+
+
+/**
+ * Buffers circles and renders them in one instanced draw.
+ *
+ * Each circle is stored once, as its centre, radius and colour, rather than
+ * as a ring of vertices, and drawn as an instance of as many vertices as it
+ * has segments. The vertices are generated in the vertex shader of
+ * ProgramKind::instancedCircle, which must be bound to render; the segment
+ * count is a constant attribute, so changing it needs no upload.
+ */
+class CircleRenderer
+{
+public:
+	/** A circle, as uploaded to the GPU. */
+	struct Circle
+	{
+		b2Vec2 centre;
+		float32 radius;
+		b2Color colour;
+	};
+
+	/**
+	 * Create an empty renderer.
+	 *
+	 * No GL calls are made until the first @ref bufferData, when a vertex
+	 * buffer is taken from @p pool; it is returned on destruction.
+	 */
+	CircleRenderer(
+		GLint circleAttribLocation,
+		GLint colourAttribLocation,
+		GLint segmentsAttribLocation,
+		unsigned numSegments = 16u,
+		ResourcePool& pool = ResourcePool::shared()
+	);
+
+	CircleRenderer(CircleRenderer const&) = delete;
+	CircleRenderer& operator=(CircleRenderer const&) = delete;
+
+	CircleRenderer(CircleRenderer&& other) noexcept;
+	CircleRenderer& operator=(CircleRenderer&& other) noexcept;
+
+	~CircleRenderer() noexcept;
+
+	inline void addCircle(
+		b2Vec2 const& centre,
+		float32 radius,
+		b2Color const& colour
+	)
+	{
+		m_circles.push_back(Circle{centre, radius, colour});
+	}
+
+	inline std::size_t circleCount() const noexcept
+	{ return m_circles.size(); }
+
+	/** The number of circles drawn by @ref render. */
+	inline std::size_t bufferedCount() const noexcept
+	{ return std::size_t(m_bufferedCount); }
+
+	inline Circle const* circles() const noexcept
+	{ return m_circles.data(); }
+
+	inline void clear() noexcept
+	{ m_circles.clear(); }
+
+	/**
+	 * Upload the circles added since the last clear.
+	 *
+	 * @throws std::runtime_error if GL objects can't be created.
+	 */
+	void bufferData();
+
+	/**
+	 * Draw the uploaded circles with the bound program, e.g. as
+	 * `GL_LINE_LOOP` outlines or `GL_TRIANGLE_FAN` fills.
+	 */
+	void render(GLenum mode) noexcept;
+
+	/** Set the number of vertices each circle is drawn with. */
+	inline void setSegments(unsigned count) noexcept
+	{ m_numSegments = count < 3u ? 3u : count; }
+
+	inline unsigned segments() const noexcept
+	{ return m_numSegments; }
+
+	/** Set the locations used from the next @ref bufferData. */
+	inline void setAttribLocations(
+		GLint circle,
+		GLint colour,
+		GLint segments
+	) noexcept
+	{
+		m_circleLocation = circle;
+		m_colourLocation = colour;
+		m_segmentsLocation = segments;
+	}
+
+private:
+	/** Point the vertex array's per-instance attributes at the buffer. */
+	void applyAttribLocations() noexcept;
+
+	void releaseBuffer() noexcept;
+
+	std::vector<Circle> m_circles;
+
+	ResourcePool* m_pPool;
+	VertexBuffer m_buffer;
+	bool m_hasBuffer;
+	GLsizei m_bufferedCount;
+	unsigned m_numSegments;
+
+	GLint m_circleLocation;
+	GLint m_colourLocation;
+	GLint m_segmentsLocation;
+
+	/** The per-instance locations enabled in the vertex array. */
+	std::array<GLint, 2> m_enabledLocations;
+};
+
+
+} // namespace b2draw
+#endif // #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__CIRCLERENDERER__H
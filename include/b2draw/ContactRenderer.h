@@ -0,0 +1,156 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__CONTACTRENDERER__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__CONTACTRENDERER__H
+#include <array>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <Box2D/Common/b2Draw.h>
+
+#include "b2draw/ResourcePool.h"
+
+
+namespace b2draw {
+
+
+/**
+ * Buffers contact points and renders them in one instanced draw.
+ *
+ * Each point is stored once, as a compact record of its position, normal and
+ * impulse, and drawn as an instance of six `GL_LINES` vertices: its normal,
+ * long in proportion to the impulse, and a cross on the point. The lines are
+ * generated in the vertex shader of ProgramKind::contact, which must be bound
+ * to render; the colour and scales are constant attributes, so changing them
+ * needs no upload.
+ */
+class ContactRenderer
+{
+public:
+	/** A contact point, as uploaded to the GPU. */
+	struct Contact
+	{
+		b2Vec2 point;
+
+		/** The unit normal, from the first shape to the second. */
+		b2Vec2 normal;
+
+		float32 impulse;
+	};
+
+	/**
+	 * Create an empty renderer.
+	 *
+	 * No GL calls are made until the first @ref bufferData, when a vertex
+	 * buffer is taken from @p pool; it is returned on destruction.
+	 */
+	ContactRenderer(
+		GLint contactAttribLocation,
+		GLint impulseAttribLocation,
+		GLint colourAttribLocation,
+		GLint scaleAttribLocation,
+		ResourcePool& pool = ResourcePool::shared()
+	);
+
+	ContactRenderer(ContactRenderer const&) = delete;
+	ContactRenderer& operator=(ContactRenderer const&) = delete;
+
+	ContactRenderer(ContactRenderer&& other) noexcept;
+	ContactRenderer& operator=(ContactRenderer&& other) noexcept;
+
+	~ContactRenderer() noexcept;
+
+	inline void addContact(
+		b2Vec2 const& point,
+		b2Vec2 const& normal,
+		float32 impulse
+	)
+	{
+		m_contacts.push_back(Contact{point, normal, impulse});
+	}
+
+	inline std::size_t contactCount() const noexcept
+	{ return m_contacts.size(); }
+
+	inline Contact const* contacts() const noexcept
+	{ return m_contacts.data(); }
+
+	inline void clear() noexcept
+	{ m_contacts.clear(); }
+
+	/**
+	 * Upload the contacts added since the last clear.
+	 *
+	 * @throws std::runtime_error if GL objects can't be created.
+	 */
+	void bufferData();
+
+	/** Draw the uploaded contacts with the bound program. */
+	void render() noexcept;
+
+	/** Set the colour of the normals and crosses. */
+	inline void setColour(b2Color const& colour) noexcept
+	{ m_colour = colour; }
+
+	inline b2Color const& colour() const noexcept
+	{ return m_colour; }
+
+	/**
+	 * Set the length of normals per unit of impulse, and the half-width of
+	 * the crosses, in world units.
+	 */
+	inline void setScale(float32 lengthPerImpulse, float32 crossSize) noexcept
+	{
+		m_lengthPerImpulse = lengthPerImpulse;
+		m_crossSize = crossSize;
+	}
+
+	inline float32 lengthPerImpulse() const noexcept
+	{ return m_lengthPerImpulse; }
+
+	inline float32 crossSize() const noexcept
+	{ return m_crossSize; }
+
+	/** Set the locations used from the next @ref bufferData. */
+	inline void setAttribLocations(
+		GLint contact,
+		GLint impulse,
+		GLint colour,
+		GLint scale
+	) noexcept
+	{
+		m_contactLocation = contact;
+		m_impulseLocation = impulse;
+		m_colourLocation = colour;
+		m_scaleLocation = scale;
+	}
+
+private:
+	/** Point the vertex array's per-instance attributes at the buffer. */
+	void applyAttribLocations() noexcept;
+
+	void releaseBuffer() noexcept;
+
+	std::vector<Contact> m_contacts;
+
+	ResourcePool* m_pPool;
+	VertexBuffer m_buffer;
+	bool m_hasBuffer;
+	GLsizei m_bufferedCount;
+
+	b2Color m_colour;
+	float32 m_lengthPerImpulse;
+	float32 m_crossSize;
+
+	GLint m_contactLocation;
+	GLint m_impulseLocation;
+	GLint m_colourLocation;
+	GLint m_scaleLocation;
+
+	/** The per-instance locations enabled in the vertex array. */
+	std::array<GLint, 2> m_enabledLocations;
+};
+
+
+} // namespace b2draw
+#endif // #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__CONTACTRENDERER__H
@@ -1,10 +1,24 @@
 #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__DEBUGDRAW__H
 #define HEADER_INCLUDE__RECURSION__PHYSICS__B2__DEBUGDRAW__H
+#include <array>
+#include <chrono>
+#include <memory>
+#include <utility>
 #include <vector>
 
 #include <Box2D/Common/b2Draw.h>
 
+#include "b2draw/CircleRenderer.h"
+#include "b2draw/ContactRenderer.h"
+#include "b2draw/DensityGrid.h"
+#include "b2draw/Frame.h"
+#include "b2draw/PointRenderer.h"
 #include "b2draw/PrimitiveRenderer.h"
+#include "b2draw/ProgramLibrary.h"
+
+class b2Contact;
+class b2World;
+struct b2ContactImpulse;
 
 namespace b2draw {
 
@@ -35,21 +49,201 @@ class DebugDraw
 public:
 	static constexpr uint32 s_drawAll = 0xff;
 
+	/** The outcome of @ref Calibrate. */
+	struct CalibrationResult
+	{
+		/** The fastest strategy, now in use. */
+		SubmissionStrategy strategy;
+
+		/** Time taken by each strategy; zero for unsupported strategies. */
+		std::array<
+			std::chrono::nanoseconds,
+			static_cast<std::size_t>(SubmissionStrategy::count)
+		> timings;
+	};
+
+	/** Ceilings on the geometry buffered each frame; zero means no limit. */
+	struct Budget
+	{
+		/** The most vertices to buffer, across all primitives. */
+		std::size_t maxVertices{0};
+
+		/** The most vertex data to upload, in bytes. */
+		std::size_t maxBytesPerFrame{0};
+	};
+
+	/**
+	 * The steps taken, in order, to bring a frame within its @ref Budget.
+	 *
+	 * Each step includes those before it.
+	 */
+	enum class Degradation : unsigned
+	{
+		none,
+
+		/** Circles of 12 or more segments drawn with half as many. */
+		circleDetail,
+
+		/** AABBs, broad-phase pairs and centres of mass dropped. */
+		overlays,
+
+		/** Static, sleeping and inactive bodies dropped. */
+		restingBodies,
+
+		/** Only every `sampleStride`th remaining primitive kept. */
+		sampling
+	};
+
+	/** The shape of the broad-phase tree; see DrawBroadPhase. */
+	struct TreeStats
+	{
+		/** Levels below the root, so zero for a lone proxy. */
+		int32 height{0};
+
+		/**
+		 * The summed perimeters of every node over the root's, as Box2D's
+		 * `b2World::GetTreeQuality`; high ratios point to fat or overlapping
+		 * AABBs. Zero unless measured.
+		 */
+		float32 areaRatio{0.0f};
+
+		/** Nodes drawn, within the depth and size cutoffs. */
+		std::size_t nodesDrawn{0};
+	};
+
+	/** What was buffered in the last frame, and what was dropped. */
+	struct FrameStats
+	{
+		/** Vertices drawn before any degradation. */
+		std::size_t requestedVertices{0};
+
+		/** Vertices buffered, including those of retained layers. */
+		std::size_t vertices{0};
+
+		/** Bytes of vertex data buffered. */
+		std::size_t bytes{0};
+
+		/** Primitives dropped entirely. */
+		std::size_t droppedPrimitives{0};
+
+		Degradation degradation{Degradation::none};
+		std::size_t sampleStride{1};
+
+		/** The broad-phase tree, if drawn since the frame's Clear. */
+		TreeStats tree{};
+
+		/** Contact points buffered; see DrawContact. */
+		std::size_t contacts{0};
+	};
+
+	/** When to draw body shapes as a density map; see SetDensityMode. */
+	struct DensityMode
+	{
+		/**
+		 * Solid shapes per pixel of the density view above which to switch
+		 * to a density map, or zero never to switch.
+		 */
+		float32 bodiesPerPixel{0.0f};
+
+		/** Count only awake bodies, rather than all of them. */
+		bool awakeOnly{false};
+	};
+
+	/** One of several views of the same frame; see @ref Render. */
+	struct Viewport
+	{
+		/** The area drawn to, in pixels, as passed to `glViewport`. */
+		GLint x{0};
+		GLint y{0};
+		GLsizei width{0};
+		GLsizei height{0};
+
+		/** The world area shown, stretched to fill the viewport. */
+		b2Vec2 lower{0.0f, 0.0f};
+		b2Vec2 upper{0.0f, 0.0f};
+
+		/**
+		 * Shapes smaller than this many pixels across are skipped, e.g. to
+		 * leave out small bodies in a minimap.
+		 */
+		float32 minPixels{0.0f};
+	};
+
+	/** Which contact points DrawContact keeps, and how they're drawn. */
+	struct ContactMode
+	{
+		/** Points with smaller normal impulses are skipped. */
+		float32 impulseThreshold{0.0f};
+
+		/** The length of normals per unit of impulse, in world units. */
+		float32 lengthPerImpulse{0.1f};
+
+		/** The half-width of the cross on each point, in world units. */
+		float32 crossSize{0.1f};
+
+		b2Color colour{1.0f, 0.3f, 0.1f, 1.0f};
+	};
+
+	/** How much of the broad-phase tree DrawBroadPhase draws. */
+	struct TreeDetail
+	{
+		/** The deepest level drawn, the root being level zero. */
+		unsigned maxDepth{10u};
+
+		/**
+		 * Nodes less than this many pixels across are skipped, along with
+		 * their children, which lie inside them.
+		 */
+		float32 minPixels{2.0f};
+
+		/** The view's scale, in pixels per world unit. */
+		float32 pixelsPerUnit{1.0f};
+
+		/**
+		 * Measure TreeStats::areaRatio, which visits every node of the tree
+		 * however few are drawn.
+		 */
+		bool measureAreaRatio{true};
+	};
+
 	inline DebugDraw(
 		unsigned numCircleSegments = 16,
 		float32 fillAlpha = 0.5f,
-		float32 axisScale = 4.0f
+		float32 axisScale = 4.0f,
+		unsigned numBuffers = PrimitiveRenderer::s_defaultBufferCount,
+		Arena* pArena = nullptr,
+		ResourcePool* pPool = nullptr
 	)
-		:	DebugDraw(-1, -1, numCircleSegments, fillAlpha, axisScale)
+		:	DebugDraw(
+				-1,
+				-1,
+				numCircleSegments,
+				fillAlpha,
+				axisScale,
+				numBuffers,
+				pArena,
+				pPool
+			)
 	{
 	}
 
+	/**
+	 * @param pArena where the renderers keep each frame's primitives, e.g. a
+	 * FrameArena shared with other DebugDraws; if null, the heap. See
+	 * PrimitiveRenderer::clear.
+	 * @param pPool the pool from which to take GL objects, e.g. one shared
+	 * with other DebugDraws on the same context, which must outlive this one.
+	 * If null, the DebugDraw has a pool of its own, freed along with it.
+	 */
 	DebugDraw(
 		GLint positionAttribLocation,
 		GLint colourAttribLocation,
 		unsigned numCircleSegments = 16,
 		float32 fillAlpha = 0.5f,
-		float32 axisScale = 4.0f
+		float32 axisScale = 4.0f,
+		unsigned numBuffers = PrimitiveRenderer::s_defaultBufferCount,
+		Arena* pArena = nullptr,
+		ResourcePool* pPool = nullptr
 	);
 
 	DebugDraw(DebugDraw const&) = delete;
@@ -85,12 +279,28 @@ public:
 		b2Color const& colour
 	) override;
 
+	/**
+	 * Draw a segment.
+	 *
+	 * A segment starting where the previous one ended, in the same colour,
+	 * extends it into a polyline, so chain shapes cost one primitive per
+	 * chain rather than one per edge.
+	 */
 	virtual void DrawSegment(
 		b2Vec2 const& begin,
 		b2Vec2 const& end,
 		b2Color const& colour
 	) override;
 
+	/**
+	 * Draw a point as a single vertex, @p size across.
+	 *
+	 * Sizes are in pixels unless the program scales them otherwise; see
+	 * ProgramLibrary::setPointScale. Requires a point size attribute location
+	 * to honour @p size; see SetPointSizeAttribLocation. Points aren't
+	 * interpolated by Render(float32), and are buffered from frames at
+	 * PointRenderer::s_defaultSize, as frames don't record sizes.
+	 */
 	virtual void DrawPoint(
 		b2Vec2 const& point,
 		float32 size,
@@ -99,36 +309,703 @@ public:
 
 	virtual void DrawTransform(b2Transform const& xf) override;
 
+	/**
+	 * Send geometry to the GPU.
+	 *
+	 * If a frame sink is installed, the frame is also passed to it.
+	 */
 	void BufferData();
 
+	/**
+	 * Buffer a recorded frame in place of this DebugDraw's own geometry.
+	 *
+	 * Sections are matched to renderers by draw mode, and further sections
+	 * of a mode to the retained layers in order, as laid out by GetFrame.
+	 * The frame's memory must remain valid until the next call to
+	 * BufferData.
+	 */
+	void BufferData(FrameView const& frame);
+
+	/**
+	 * Pass the geometry drawn since the last Clear to the frame sink, if any,
+	 * without sending it to the GPU.
+	 *
+	 * For headless processes which only publish their geometry, e.g. with a
+	 * SharedMemoryPublisher; no GL context is needed.
+	 */
+	void Publish();
+
 	void Render();
 
+	/**
+	 * Render, blending from the previously buffered frame to the latest.
+	 *
+	 * For stepping physics at a lower rate than the display: buffer each step
+	 * as usual, then render every display frame with @p alpha the fraction of
+	 * the step elapsed since the latest. Blending happens in the vertex
+	 * shader, so the geometry is only generated and uploaded once per step.
+	 * Lines and fills whose primitives changed since the previous frame, e.g.
+	 * because a body was created, are drawn from the latest frame.
+	 *
+	 * Requires the world transform and previous position attribute locations
+	 * to be set; otherwise equivalent to Render().
+	 */
+	void Render(float32 alpha);
+
+	/**
+	 * Render only the lines, fills and segments overlapping a view, culled on
+	 * the GPU by @p cullProgram and drawn with @p drawProgram; points are all
+	 * drawn, with whichever program is bound.
+	 *
+	 * For drawing one buffered frame in several viewports: each call costs the
+	 * CPU the same however many shapes there are. Needs a context for which
+	 * PrimitiveRenderer::supportsCulling; see PrimitiveRenderer::renderCulled,
+	 * also for @p minSize.
+	 */
+	void RenderCulled(
+		b2Vec2 const& lower,
+		b2Vec2 const& upper,
+		GLuint cullProgram,
+		GLuint drawProgram,
+		float32 minSize = 0.0f
+	);
+
+	/**
+	 * Render the buffered frame into several viewports, e.g. a main view, a
+	 * minimap and picture-in-picture cameras, without buffering it again.
+	 *
+	 * Each viewport is drawn with @p kind, and any instanced circles with
+	 * ProgramKind::instancedCircle, with its matrix set to show the
+	 * viewport's world area. Where PrimitiveRenderer::supportsCulling, shapes
+	 * outside each area, or smaller than its Viewport::minPixels, are culled
+	 * on the GPU, so each extra view costs only its draw calls; otherwise
+	 * everything is drawn in every view.
+	 *
+	 * The GL viewport and the library's matrix are left as those of the last
+	 * view; the caller restores its own, which it knows without querying GL.
+	 */
+	void Render(
+		Viewport const* pViewports,
+		std::size_t count,
+		ProgramLibrary& programs,
+		ProgramKind kind = ProgramKind::plain
+	);
+
+	/**
+	 * View the geometry drawn since the last Clear: outlines, fills,
+	 * segments and points, followed by each retained layer's last drawing;
+	 * see SetRefreshInterval.
+	 */
+	FrameView GetFrame() const noexcept;
+
+	/**
+	 * Install a sink to receive every buffered frame, e.g. a CaptureWriter.
+	 *
+	 * Pass `nullptr` to stop. The sink must outlive its installation.
+	 */
+	inline void SetFrameSink(FrameSink* pSink) noexcept
+	{
+		m_pFrameSink = pSink;
+	}
+
 	void Clear();
 
+	/**
+	 * Limit the geometry buffered each frame, taking effect from the next
+	 * Clear.
+	 *
+	 * Frames over budget are degraded in the steps of @ref Degradation, in
+	 * order, until they fit; if sampling still leaves too much, the last
+	 * primitives are dropped. Layers are told apart by the colours Box2D
+	 * draws them in, so custom colours count as awake bodies.
+	 *
+	 * Layers dropped in one frame are skipped as they're drawn in the next,
+	 * so that memory use stays near the budget, and are restored as soon as
+	 * the frame would fit without dropping them.
+	 */
+	inline void SetBudget(Budget const& budget) noexcept
+	{
+		m_nextBudget = budget;
+	}
+
+	inline Budget const& GetBudget() const noexcept
+	{
+		return m_nextBudget;
+	}
+
+	/** Get the statistics of the last buffered or published frame. */
+	inline FrameStats const& GetFrameStats() const noexcept
+	{
+		return m_frameStats;
+	}
+
+	/**
+	 * Replace body shapes with a density map when zoomed far out.
+	 *
+	 * After a frame with more solid shapes per pixel of the density view
+	 * than `bodiesPerPixel`, solid polygons and circles are only counted into
+	 * a DensityGrid, at their centres, rather than tessellated and uploaded;
+	 * outlines, segments and overlays are drawn as usual. The map is dropped
+	 * once density falls below three quarters of the threshold, so that views
+	 * near it don't flicker. Takes effect from the next Clear.
+	 *
+	 * Draw the map with RenderDensity. Frames passed to the frame sink don't
+	 * include it.
+	 */
+	inline void SetDensityMode(DensityMode const& mode) noexcept
+	{
+		m_densityMode = mode;
+	}
+
+	inline DensityMode const& GetDensityMode() const noexcept
+	{
+		return m_densityMode;
+	}
+
+	/**
+	 * Set the area covered by the density map, which should be the area in
+	 * view, and its size in pixels.
+	 */
+	inline void SetDensityView(
+		b2Vec2 const& lower,
+		b2Vec2 const& upper,
+		unsigned width,
+		unsigned height
+	)
+	{
+		m_densityGrid.setView(lower, upper, width, height);
+	}
+
+	/** Whether solid shapes are being counted into the density map. */
+	inline bool IsDrawingDensity() const noexcept
+	{
+		return m_drawingDensity;
+	}
+
+	inline DensityGrid const& GetDensityGrid() const noexcept
+	{
+		return m_densityGrid;
+	}
+
+	/**
+	 * Draw the density map over the whole viewport, if in use, with
+	 * ProgramKind::density bound.
+	 */
+	void RenderDensity();
+
+	/**
+	 * Draw the following geometry, until the next call or Clear, scaled by
+	 * @p scale and then offset by @p offset.
+	 *
+	 * Lets several worlds share one DebugDraw, and so one upload per frame:
+	 * call BeginWorld before each world's DrawDebugData. Requires a world
+	 * transform attribute location; see SetWorldTransformAttribLocation.
+	 * Captured and published frames do not record the transforms.
+	 */
+	inline void BeginWorld(b2Vec2 const& offset, float32 scale = 1.0f)
+	{
+		m_worldOffset = offset;
+		m_worldScale = scale;
+		m_lineRenderer.beginGroup(offset, scale);
+		m_fillRenderer.beginGroup(offset, scale);
+		m_segmentRenderer.beginGroup(offset, scale);
+		for (std::size_t i = 0; i < m_retainedRenderers.size(); ++i)
+		{
+			if (m_refreshingLayers & (1u << i)) {
+				m_retainedRenderers[i].beginGroup(offset, scale);
+			}
+		}
+	}
+
+	/**
+	 * Redraw a diagnostic flag's geometry only every @p frames frames, and
+	 * render its last upload in between; zero or one redraws it every frame.
+	 *
+	 * For `e_jointBit`, `e_aabbBit`, `e_pairBit` and `e_centerOfMassBit`;
+	 * other flags, including `e_shapeBit`, are redrawn every frame. On frames
+	 * when a flag isn't due, its geometry is skipped as it's drawn and costs
+	 * no upload; DrawWorld also spares the world traversing it. The flags
+	 * themselves are never changed.
+	 *
+	 * Flags refreshed less often are drawn into their own retained layers,
+	 * told apart by the colours Box2D draws them in. These layers are drawn
+	 * after the rest, and follow GetFrame's four sections in frames. They
+	 * count towards the budget every frame, and when dropped to meet it are
+	 * left empty until next redrawn. They aren't picked or interpolated.
+	 * Takes effect from the next Clear.
+	 */
+	void SetRefreshInterval(uint32 flag, unsigned frames) noexcept;
+
+	/** The frames between redraws of a flag's geometry; see above. */
+	unsigned GetRefreshInterval(uint32 flag) const noexcept;
+
+	/**
+	 * Outline the nodes of a world's broad-phase tree, coloured by depth from
+	 * blue at the root to red at TreeDetail::maxDepth.
+	 *
+	 * Where `e_aabbBit` only draws the leaves, this shows how they're grouped,
+	 * to diagnose slow broad phases: deep or lopsided trees, and fat or
+	 * overlapping nodes. Only nodes within the depth and size cutoffs are
+	 * visited, so large trees cost no more than what's drawn. The tree's
+	 * height and area ratio are reported in FrameStats::tree. The outlines
+	 * are overlays, dropped as such to meet a budget.
+	 *
+	 * Box2D keeps the tree private, so this relies on Box2D 2.3's internals.
+	 *
+	 * @throws std::runtime_error if the Box2D library isn't version 2.3.
+	 */
+	void DrawBroadPhase(b2World const& world, TreeDetail const& detail);
+
+	/**
+	 * Record a solved contact's manifold points, e.g. from
+	 * `b2ContactListener::PostSolve`, to draw with RenderContacts.
+	 *
+	 * Box2D doesn't draw contacts itself. Each point is kept as one compact
+	 * record of its position, normal and normal impulse, unless its impulse
+	 * is below ContactMode::impulseThreshold, and all are drawn in a single
+	 * instanced call. As contacts are solved during the step, before the
+	 * frame's Clear, they're kept until the next BufferData rather than
+	 * cleared. They're in world coordinates, ignoring BeginWorld, and aren't
+	 * passed to the frame sink or counted towards the budget.
+	 */
+	void DrawContact(
+		b2Contact const* pContact,
+		b2ContactImpulse const* pImpulse
+	);
+
+	inline void SetContactMode(ContactMode const& mode) noexcept
+	{
+		m_contactMode = mode;
+		m_contactRenderer.setColour(mode.colour);
+		m_contactRenderer.setScale(mode.lengthPerImpulse, mode.crossSize);
+	}
+
+	inline ContactMode const& GetContactMode() const noexcept
+	{
+		return m_contactMode;
+	}
+
+	/** Draw the buffered contacts, with ProgramKind::contact bound. */
+	inline void RenderContacts() noexcept
+	{
+		m_contactRenderer.render();
+	}
+
+	/**
+	 * Set whether circles are kept as one record each, and drawn with
+	 * RenderCircles in an instanced call for outlines and one for fills,
+	 * rather than as polygons; off by default.
+	 *
+	 * Saves generating and uploading a ring of vertices per circle; the
+	 * axes of solid circles are still drawn as segments. Instanced circles
+	 * are placed in their world as they're drawn, and are dropped with
+	 * their layer to meet the budget but never thinned. They aren't picked,
+	 * interpolated, culled or included in frames.
+	 */
+	inline void SetCircleInstancing(bool enable) noexcept
+	{
+		m_instancingCircles = enable;
+	}
+
+	inline bool IsCircleInstancing() const noexcept
+	{
+		return m_instancingCircles;
+	}
+
+	/**
+	 * Draw the buffered instanced circles, outlines then fills, with
+	 * ProgramKind::instancedCircle bound.
+	 */
+	inline void RenderCircles() noexcept
+	{
+		m_circleLineRenderer.render(GL_LINE_LOOP);
+		m_circleFillRenderer.render(GL_TRIANGLE_FAN);
+	}
+
+	/**
+	 * Set whether outlines, fills and segments record the tag set by SetTag,
+	 * so that Pick can identify them; off by default.
+	 */
+	inline void SetTagging(bool enable)
+	{
+		m_lineRenderer.setTagging(enable);
+		m_fillRenderer.setTagging(enable);
+		m_segmentRenderer.setTagging(enable);
+	}
+
+	inline bool IsTagging() const noexcept
+	{
+		return m_lineRenderer.tagging();
+	}
+
+	/**
+	 * Tag the following geometry, until the next call or Clear, e.g. with
+	 * the fixture about to be drawn.
+	 */
+	inline void SetTag(PrimitiveRenderer::Tag tag) noexcept
+	{
+		m_lineRenderer.setTag(tag);
+		m_fillRenderer.setTag(tag);
+		m_segmentRenderer.setTag(tag);
+	}
+
+	/**
+	 * Draw a world as `world.DrawDebugData()` does, tagging each fixture's
+	 * shape with its `b2Fixture`, so that Pick finds fixtures once tagging
+	 * is on. Makes this the world's debug draw.
+	 */
+	void DrawWorld(b2World& world);
+
+	/**
+	 * Find what's drawn within @p radius of a point, e.g. under the cursor.
+	 *
+	 * Searches the outlines, fills and segments drawn since the last Clear;
+	 * points aren't tagged. Each is indexed on the first Pick after it's
+	 * drawn, so repeated picks in a frame only test shapes nearby. See
+	 * PrimitiveRenderer::pick.
+	 *
+	 * @param tags set to the non-null tags of the shapes hit, each once,
+	 * topmost first.
+	 * @returns the number of tags found.
+	 */
+	std::size_t Pick(
+		b2Vec2 const& point,
+		float32 radius,
+		std::vector<PrimitiveRenderer::Tag>& tags
+	);
+
+	/**
+	 * Time each supported submission strategy and adopt the fastest.
+	 *
+	 * Uploads and renders a synthetic batch of outlined and filled circles
+	 * and boxes @p iterations times per strategy, waiting for the GPU to
+	 * finish each run, so that the work each strategy does after every
+	 * upload is timed too, with as many buffers as this DebugDraw's
+	 * renderers. Colour writes are disabled meanwhile, and restored along
+	 * with the indirect buffer binding even if it throws. The program used
+	 * for rendering, e.g. ProgramKind::plain, must be bound.
+	 *
+	 * @throws std::runtime_error if no program is bound.
+	 *
+	 * The chosen strategy can be persisted with @ref toString and restored
+	 * on later runs with @ref SetSubmissionStrategy, skipping calibration.
+	 */
+	CalibrationResult Calibrate(
+		unsigned numPrimitives = 4096,
+		unsigned iterations = 16
+	);
+
+	inline void SetSubmissionStrategy(SubmissionStrategy strategy) noexcept
+	{
+		m_lineRenderer.setSubmissionStrategy(strategy);
+		m_fillRenderer.setSubmissionStrategy(strategy);
+		m_segmentRenderer.setSubmissionStrategy(strategy);
+		for (auto& renderer: m_retainedRenderers)
+		{
+			renderer.setSubmissionStrategy(strategy);
+		}
+	}
+
+	inline SubmissionStrategy GetSubmissionStrategy() const noexcept
+	{
+		return m_lineRenderer.submissionStrategy();
+	}
+
+	/** Get the combined upload statistics of the primitive renderers. */
+	PrimitiveRenderer::UploadStats GetUploadStats() const noexcept;
+
+	inline void ResetUploadStats() noexcept
+	{
+		m_lineRenderer.resetUploadStats();
+		m_fillRenderer.resetUploadStats();
+		m_segmentRenderer.resetUploadStats();
+		for (auto& renderer: m_retainedRenderers)
+		{
+			renderer.resetUploadStats();
+		}
+	}
+
 	inline void SetPositionAttribLocation(GLint location) noexcept
 	{
 		m_lineRenderer.setPositionAttribLocation(location);
 		m_fillRenderer.setPositionAttribLocation(location);
+		m_segmentRenderer.setPositionAttribLocation(location);
+		m_pointRenderer.setPositionAttribLocation(location);
+		for (auto& renderer: m_retainedRenderers)
+		{
+			renderer.setPositionAttribLocation(location);
+		}
 	}
 
 	inline void SetColourAttribLocation(GLint location) noexcept
 	{
 		m_lineRenderer.setColourAttribLocation(location);
 		m_fillRenderer.setColourAttribLocation(location);
+		m_segmentRenderer.setColourAttribLocation(location);
+		m_pointRenderer.setColourAttribLocation(location);
+		for (auto& renderer: m_retainedRenderers)
+		{
+			renderer.setColourAttribLocation(location);
+		}
 	}
 
 	inline void SetAttribLocations(GLint position, GLint colour) noexcept
 	{
 		m_lineRenderer.setAttribLocations(position, colour);
 		m_fillRenderer.setAttribLocations(position, colour);
+		m_segmentRenderer.setAttribLocations(position, colour);
+		m_pointRenderer.setPositionAttribLocation(position);
+		m_pointRenderer.setColourAttribLocation(colour);
+		for (auto& renderer: m_retainedRenderers)
+		{
+			renderer.setAttribLocations(position, colour);
+		}
+	}
+
+	/** E.g. ProgramLibrary::s_pointSizeLocation. */
+	inline void SetPointSizeAttribLocation(GLint location) noexcept
+	{
+		m_pointRenderer.setSizeAttribLocation(location);
+	}
+
+	/** E.g. ProgramLibrary::s_worldTransformLocation. */
+	inline void SetWorldTransformAttribLocation(GLint location) noexcept
+	{
+		m_lineRenderer.setWorldTransformAttribLocation(location);
+		m_fillRenderer.setWorldTransformAttribLocation(location);
+		m_segmentRenderer.setWorldTransformAttribLocation(location);
+		for (auto& renderer: m_retainedRenderers)
+		{
+			renderer.setWorldTransformAttribLocation(location);
+		}
+	}
+
+	/** E.g. ProgramLibrary::s_previousPositionLocation. */
+	inline void SetPreviousPositionAttribLocation(GLint location) noexcept
+	{
+		m_lineRenderer.setPreviousPositionAttribLocation(location);
+		m_fillRenderer.setPreviousPositionAttribLocation(location);
+		m_segmentRenderer.setPreviousPositionAttribLocation(location);
+	}
+
+	/**
+	 * Upload the fixed colours Box2D draws with as indices into
+	 * GetPalette, e.g. at ProgramLibrary::s_paletteIndexLocation, for a
+	 * program such as ProgramKind::paletteColour that looks them up. Any
+	 * upload with another colour is sent with its colours as before, so
+	 * the program must also read the colour attribute.
+	 */
+	void SetPaletteIndexAttribLocation(GLint location);
+
+	/** The colours, indexed from one, that palette indices refer to. */
+	inline std::vector<b2Color> const& GetPalette() const noexcept
+	{
+		return m_palette;
 	}
 
 private:
+	/** Layers of geometry, in the order they are dropped to meet a budget. */
+	enum Layer : unsigned char
+	{
+		e_bodyLayer,
+		e_overlayLayer,
+		e_restingLayer,
+		e_layerCount,
+
+		/** Flags a circle primitive in the per-primitive tags. */
+		e_circleTag = 0x80
+	};
+
+	/**
+	 * Layers for flags redrawn less often than every frame, in the order
+	 * they're drawn; see SetRefreshInterval.
+	 */
+	enum RetainedLayer : unsigned char
+	{
+		e_jointLayer,
+		e_aabbLayer,
+		e_pairLayer,
+		e_centreOfMassLayer,
+		e_retainedLayerCount
+	};
+
+	/** The vertices drawn in a layer, including those skipped. */
+	struct Demand
+	{
+		std::size_t vertices;
+
+		/** How many vertices halving circle detail would save. */
+		std::size_t circleSaving;
+	};
+
+	/** Tell which layer a primitive belongs to from its colour. */
+	static Layer Classify(b2Color const& colour) noexcept;
+
+	inline bool HasBudget() const noexcept
+	{
+		return m_budget.maxVertices || m_budget.maxBytesPerFrame;
+	}
+
+	/**
+	 * Count a primitive towards this frame's demand.
+	 *
+	 * @returns false if the primitive's layer was dropped last frame, in
+	 * which case it should be skipped.
+	 */
+	bool Admit(Layer layer, std::size_t vertexCount, bool circle) noexcept;
+
+	/**
+	 * Count a primitive drawn into a retained layer towards its demand
+	 * until the layer is next redrawn.
+	 *
+	 * @returns false if the layer's budget layer was dropped last frame, in
+	 * which case this redraw should be skipped.
+	 */
+	bool AdmitRetained(RetainedLayer layer, std::size_t vertexCount) noexcept;
+
+	/** Whether a layer is dropped at a level of degradation. */
+	static inline bool Drops(Degradation level, Layer layer) noexcept
+	{
+		return
+			(layer == e_overlayLayer && level >= Degradation::overlays) ||
+			(layer == e_restingLayer && level >= Degradation::restingBodies);
+	}
+
+	/** The layer a retained layer is budgeted as. */
+	static inline Layer BudgetLayer(RetainedLayer layer) noexcept
+	{
+		return layer == e_jointLayer ? e_bodyLayer : e_overlayLayer;
+	}
+
+	/** Tag a renderer's newest primitive, unless it extended an older one. */
+	void Tag(
+		PrimitiveRenderer const& renderer,
+		std::vector<unsigned char>& tags,
+		Layer layer,
+		bool circle
+	);
+
+	/**
+	 * Get a retained layer's renderer if it's being redrawn this frame, or
+	 * null if its geometry belongs with everything else.
+	 */
+	inline PrimitiveRenderer* Refreshing(RetainedLayer layer) noexcept
+	{
+		return m_refreshingLayers & (1u << layer)
+			? &m_retainedRenderers[layer]
+			: nullptr;
+	}
+
+	/** Draw every retained layer from its last upload. */
+	void RenderRetained();
+
+	/** Whether a retained layer's geometry is skipped this frame. */
+	inline bool Paused(RetainedLayer layer) const noexcept
+	{
+		return m_pausedLayers & (1u << layer);
+	}
+
+	/** Degrade this frame to fit the budget, once, and gather statistics. */
+	void ApplyBudget();
+
+	/**
+	 * Count a solid shape towards the density map, at the mean of its
+	 * points.
+	 *
+	 * @returns true if the map is in use, so the shape shouldn't be drawn.
+	 */
+	bool CountDensity(
+		b2Vec2 const* pPoints,
+		int32 count,
+		b2Color const& colour
+	);
+
+	/**
+	 * The pool the renderers take from: an owned one, unless given one.
+	 *
+	 * An owned pool is cleared once the renderers have returned their
+	 * buffers, so it's declared before them. Assignment swaps pools, so each
+	 * lives as long as the renderers which took from it.
+	 */
+	struct PoolOwner
+	{
+		explicit PoolOwner(ResourcePool* pBorrowed);
+
+		PoolOwner(PoolOwner const&) = delete;
+		PoolOwner& operator=(PoolOwner const&) = delete;
+
+		PoolOwner(PoolOwner&& other) noexcept;
+		PoolOwner& operator=(PoolOwner&& other) noexcept;
+
+		~PoolOwner() noexcept;
+
+		std::unique_ptr<ResourcePool> pOwned;
+		ResourcePool* pPool;
+	};
+
+	PoolOwner m_pool;
+
 	PrimitiveRenderer m_lineRenderer;
 	PrimitiveRenderer m_fillRenderer;
 
+	/** Segments, drawn as strips so that chains coalesce into polylines. */
+	PrimitiveRenderer m_segmentRenderer;
+
+	PointRenderer m_pointRenderer;
+	ContactRenderer m_contactRenderer;
+	ContactMode m_contactMode;
+
+	/** Circles drawn while instancing; see SetCircleInstancing. */
+	CircleRenderer m_circleLineRenderer;
+	CircleRenderer m_circleFillRenderer;
+	bool m_instancingCircles;
+
+	/** One renderer per RetainedLayer. */
+	std::vector<PrimitiveRenderer> m_retainedRenderers;
+	std::array<unsigned, e_retainedLayerCount> m_refreshIntervals;
+
+	/** The frames until each retained layer is next redrawn. */
+	std::array<unsigned, e_retainedLayerCount> m_refreshCountdowns;
+
+	/** Each retained layer's vertices, including those skipped, when drawn. */
+	std::array<std::size_t, e_retainedLayerCount> m_retainedDemand;
+
+	/** Retained layers being redrawn this frame, one bit per layer. */
+	unsigned m_refreshingLayers;
+
+	/** Retained layers not due this frame, one bit per layer. */
+	unsigned m_pausedLayers;
+
 	float32 m_fillAlpha;
 	float32 m_axisScale;
+
+	/** Box2D's fixed colours; see SetPaletteIndexAttribLocation. */
+	std::vector<b2Color> m_palette;
+
+	FrameSink* m_pFrameSink;
+
+	Budget m_budget;
+	Budget m_nextBudget;
+	FrameStats m_frameStats;
+	std::array<Demand, e_layerCount> m_demand;
+	std::vector<unsigned char> m_lineTags;
+	std::vector<unsigned char> m_fillTags;
+	std::vector<unsigned char> m_segmentTags;
+	std::size_t m_skippedPrimitives;
+	Degradation m_skipLevel;
+	bool m_budgetApplied;
+
+	DensityGrid m_densityGrid;
+	DensityMode m_densityMode;
+	b2Vec2 m_worldOffset;
+	float32 m_worldScale;
+	std::size_t m_solidShapes;
+	bool m_drawingDensity;
+
+	TreeStats m_treeStats;
+	std::vector<std::pair<int32, unsigned>> m_tmpTreeStack;
+
+	std::vector<std::size_t> m_tmpPicks;
 };
 
 
@@ -0,0 +1,142 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__DELTASTREAM__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__DELTASTREAM__H
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "b2draw/AsyncFrameSink.h"
+
+
+namespace b2draw {
+
+
+class DeltaEncoder;
+class DeltaDecoder;
+
+
+/**
+ * Records frames to a compact, delta-compressed stream on a background thread.
+ *
+ * Install with DebugDraw::SetFrameSink, as for @ref CaptureWriter. Positions
+ * are quantised to a multiple of `quantum` metres and colours to 8 bits per
+ * channel. Every `keyframeInterval` frames, or whenever the frame's sections
+ * change, a self-contained keyframe is written; other frames store only what
+ * changed since the previous frame:
+ * - primitives added or removed, found by matching the longest common prefix
+ *   and suffix of the primitive lists, are written out in full;
+ * - matched vertices store their movement, predicted from the previous
+ *   vertex of the same primitive, so resting bodies cost almost nothing and
+ *   moving bodies little more than one vertex each.
+ *
+ * Each packet is entropy coded with an adaptive binary range coder.
+ *
+ * Packets are written as they're encoded, so a stream which was never closed
+ * is readable up to its last complete frame.
+ */
+class DeltaStreamWriter
+	:	public AsyncFrameSink
+{
+public:
+	/** The default position quantum, just under a millimetre. */
+	static constexpr float s_defaultQuantum = 1.0f / 1024.0f;
+
+	/** The default number of frames between keyframes. */
+	static constexpr unsigned s_defaultKeyframeInterval = 300u;
+
+	/** @throws std::runtime_error if the file can't be opened. */
+	explicit DeltaStreamWriter(
+		std::string const& path,
+		float quantum = s_defaultQuantum,
+		unsigned keyframeInterval = s_defaultKeyframeInterval,
+		std::size_t maxQueuedFrames = 8u
+	);
+
+	DeltaStreamWriter(DeltaStreamWriter const&) = delete;
+	DeltaStreamWriter& operator=(DeltaStreamWriter const&) = delete;
+
+	/** Close the file, discarding any error. */
+	virtual ~DeltaStreamWriter() noexcept override;
+
+	/**
+	 * Write any queued frames, then close the file.
+	 *
+	 * @throws std::runtime_error if writing failed at any point.
+	 */
+	void close();
+
+	/** The number of bytes written to the stream so far. */
+	inline std::uint64_t bytesWritten() const noexcept
+	{ return m_bytesWritten; }
+
+protected:
+	virtual bool consume(void const* pRecord, std::size_t size) override;
+
+private:
+	std::FILE* m_pFile;
+	std::unique_ptr<DeltaEncoder> m_pEncoder;
+	std::vector<unsigned char> m_payload;
+	unsigned m_keyframeInterval;
+	unsigned m_framesSinceKeyframe;
+	std::atomic<std::uint64_t> m_bytesWritten;
+};
+
+
+/**
+ * Reads a stream written by @ref DeltaStreamWriter.
+ *
+ * The file is memory-mapped and indexed on construction. Any frame can be
+ * requested: it's decoded from the nearest preceding keyframe, or from the
+ * last frame decoded if that's closer, so playing forwards decodes each frame
+ * once.
+ */
+class DeltaStreamReader
+{
+public:
+	/** @throws std::runtime_error if the file can't be mapped or is invalid. */
+	explicit DeltaStreamReader(std::string const& path);
+
+	DeltaStreamReader(DeltaStreamReader const&) = delete;
+	DeltaStreamReader& operator=(DeltaStreamReader const&) = delete;
+
+	~DeltaStreamReader() noexcept;
+
+	inline std::size_t frameCount() const noexcept
+	{ return m_packets.size(); }
+
+	/** The position quantum the stream was written with. */
+	inline float quantum() const noexcept
+	{ return m_quantum; }
+
+	/**
+	 * Decode a frame.
+	 *
+	 * The frame is valid until the next call, or the reader is destroyed.
+	 *
+	 * @throws std::out_of_range if @p index is not less than @ref frameCount.
+	 * @throws std::runtime_error if the stream is corrupt.
+	 */
+	FrameView frame(std::size_t index);
+
+private:
+	struct Packet
+	{
+		std::uint64_t offset;
+		bool keyframe;
+	};
+
+	void decode(std::size_t index);
+
+	char const* m_pData;
+	std::size_t m_size;
+	float m_quantum;
+	std::vector<Packet> m_packets;
+	std::unique_ptr<DeltaDecoder> m_pDecoder;
+	std::size_t m_decodedIndex;
+};
+
+
+} // namespace b2draw
+#endif // #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__DELTASTREAM__H
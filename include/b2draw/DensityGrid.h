@@ -0,0 +1,136 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__DENSITYGRID__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__DENSITYGRID__H
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <Box2D/Common/b2Math.h>
+
+#include "b2draw/ResourcePool.h"
+#include "b2draw/WorkerPool.h"
+
+
+namespace b2draw {
+
+
+/**
+ * Counts points per cell of a grid over a view, and draws the counts as a
+ * heat map.
+ *
+ * Points are collected with @ref add, then binned on a WorkerPool's threads by
+ * @ref bufferData, which uploads one level per cell, on a logarithmic scale
+ * from zero to the fullest cell, as a single-channel texture. @ref render
+ * draws the texture over the whole viewport, so the view set with @ref
+ * setView should be the one being rendered, with one cell per pixel.
+ *
+ * Render with ProgramKind::density, which maps levels to colours and leaves
+ * empty cells transparent.
+ */
+class DensityGrid
+{
+public:
+	/**
+	 * Create an empty grid.
+	 *
+	 * No GL calls are made until the first @ref bufferData, when a vertex
+	 * array is taken from @p pool and a texture created. Points are binned
+	 * on @p workers.
+	 */
+	explicit DensityGrid(
+		ResourcePool& pool = ResourcePool::shared(),
+		WorkerPool& workers = WorkerPool::shared()
+	);
+
+	DensityGrid(DensityGrid const&) = delete;
+	DensityGrid& operator=(DensityGrid const&) = delete;
+
+	DensityGrid(DensityGrid&& other) noexcept;
+	DensityGrid& operator=(DensityGrid&& other) noexcept;
+
+	~DensityGrid() noexcept;
+
+	/**
+	 * Set the area of the world covered, and the grid's size in cells.
+	 *
+	 * Row zero is at the bottom of the view, as in GL textures.
+	 */
+	void setView(
+		b2Vec2 const& lower,
+		b2Vec2 const& upper,
+		unsigned width,
+		unsigned height
+	);
+
+	inline unsigned width() const noexcept
+	{ return m_width; }
+
+	inline unsigned height() const noexcept
+	{ return m_height; }
+
+	inline std::size_t cellCount() const noexcept
+	{ return std::size_t(m_width) * m_height; }
+
+	/** Count a point; points outside the view are ignored when binned. */
+	inline void add(b2Vec2 const& point)
+	{ m_points.push_back(point); }
+
+	inline std::size_t pointCount() const noexcept
+	{ return m_points.size(); }
+
+	/** Forget the points added so far. */
+	inline void clear() noexcept
+	{ m_points.clear(); }
+
+	/** Bin the points into levels, without uploading them. */
+	void bin();
+
+	/**
+	 * Bin the points and upload the levels.
+	 *
+	 * @throws std::runtime_error if GL objects can't be created.
+	 */
+	void bufferData();
+
+	/** Draw a full-viewport quad, with the levels bound to texture unit 0. */
+	void render() noexcept;
+
+	/** The levels last binned, one byte per cell in rows from the bottom. */
+	inline std::vector<unsigned char> const& levels() const noexcept
+	{ return m_levels; }
+
+	/** The number of points in the fullest cell when last binned. */
+	inline std::uint32_t maxCount() const noexcept
+	{ return m_maxCount; }
+
+private:
+	void releaseResources() noexcept;
+
+	ResourcePool* m_pPool;
+	WorkerPool* m_pWorkers;
+	VertexBuffer m_buffer;
+	bool m_hasBuffer;
+	GLuint m_texture;
+	unsigned m_textureWidth;
+	unsigned m_textureHeight;
+
+	b2Vec2 m_lower;
+	b2Vec2 m_upper;
+	unsigned m_width;
+	unsigned m_height;
+
+	std::vector<b2Vec2> m_points;
+
+	/** Per-cell counts, incremented concurrently; kept zeroed when idle. */
+	std::unique_ptr<std::atomic<std::uint32_t>[]> m_pCounts;
+	std::size_t m_countCapacity;
+	std::vector<unsigned char> m_levels;
+	std::uint32_t m_maxCount;
+};
+
+
+} // namespace b2draw
+#endif // #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__DENSITYGRID__H
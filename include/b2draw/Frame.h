@@ -0,0 +1,116 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__FRAME__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__FRAME__H
+#include <array>
+
+#include "b2draw/PrimitiveRenderer.h"
+
+
+namespace b2draw {
+
+
+/** One renderer's share of a frame: its primitives and draw mode. */
+struct FrameSection
+{
+	GLenum mode;
+	PrimitiveView primitives;
+};
+
+
+/**
+ * A read-only view of everything a DebugDraw buffered for one frame.
+ *
+ * Frames are what DebugDraw hands to a @ref FrameSink, and what capture
+ * readers and transports hand back for replay.
+ */
+struct FrameView
+{
+	/** The most sections a frame may have. */
+	static constexpr std::size_t s_maxSections = 8u;
+
+	/** The b2Draw flags in effect when the frame was recorded. */
+	uint32 flags;
+
+	std::size_t sectionCount;
+	std::array<FrameSection, s_maxSections> sections;
+};
+
+
+/**
+ * Get the size in bytes of a frame's serialised record.
+ *
+ * A record is a small header followed by, for each section, a section header
+ * and the raw vertex, first index and size arrays. Everything is 8-byte
+ * aligned and in native byte order, so a record in memory can be viewed by
+ * @ref readFrameRecord without copying.
+ */
+std::size_t frameRecordSize(FrameView const& frame) noexcept;
+
+
+/**
+ * Serialise a frame.
+ *
+ * @param pOut 8-byte aligned storage of at least @ref frameRecordSize bytes.
+ */
+void writeFrameRecord(FrameView const& frame, void* pOut) noexcept;
+
+
+/**
+ * View a serialised frame in place.
+ *
+ * @param pRecord 8-byte aligned record data, which must outlive any use of
+ * @p frame.
+ * @returns false if the record is malformed or larger than @p size.
+ */
+bool readFrameRecord(
+	void const* pRecord,
+	std::size_t size,
+	FrameView& frame
+) noexcept;
+
+
+/** Receives each frame buffered by a DebugDraw. */
+class FrameSink
+{
+public:
+	virtual ~FrameSink() noexcept = default;
+
+	/**
+	 * Consume a frame.
+	 *
+	 * Called from DebugDraw::BufferData on the rendering thread, so should
+	 * return quickly. The frame's memory is only valid during the call.
+	 */
+	virtual void write(FrameView const& frame) = 0;
+};
+
+
+/** Supplies frames for replay, e.g. from another process. */
+class FrameSource
+{
+public:
+	virtual ~FrameSource() noexcept = default;
+
+	/**
+	 * Get the newest frame, if there's one newer than the last returned.
+	 *
+	 * @returns false if there's no new frame. Otherwise, @p frame is valid
+	 * until the next call to poll, but see @ref intact.
+	 */
+	virtual bool poll(FrameView& frame) = 0;
+
+	/**
+	 * Whether the frame last returned by @ref poll is still intact.
+	 *
+	 * Sources which hand out frames in memory shared with their producer
+	 * return false once it has been overwritten, after which the frame must
+	 * not be used.
+	 */
+	virtual bool intact() const noexcept
+	{
+		return true;
+	}
+};
+
+
+} // namespace b2draw
+#endif // #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__FRAME__H
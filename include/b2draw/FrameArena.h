@@ -0,0 +1,230 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__FRAMEARENA__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__FRAMEARENA__H
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+
+namespace b2draw {
+
+
+/**
+ * A source of memory for renderers' per-frame storage; see ArenaAllocator.
+ *
+ * Implement to route PrimitiveRenderer storage to an application's own
+ * allocator, or use FrameArena.
+ */
+class Arena
+{
+public:
+	virtual ~Arena() noexcept;
+
+	/**
+	 * Allocate @p bytes aligned to @p alignment, a power of two.
+	 *
+	 * @throws std::bad_alloc if out of memory.
+	 */
+	virtual void* allocate(std::size_t bytes, std::size_t alignment) = 0;
+
+	/** Return memory from an @ref allocate call with the same arguments. */
+	virtual void deallocate(
+		void* pMemory,
+		std::size_t bytes,
+		std::size_t alignment
+	) noexcept = 0;
+
+	/**
+	 * Mark the start of a new frame of one owner's allocations, as
+	 * DebugDraw::Clear does before giving its last frame back. Does nothing
+	 * unless overridden.
+	 */
+	virtual void reset() noexcept;
+};
+
+
+/**
+ * A standard allocator drawing from an Arena, or from the heap when given
+ * none, for containers whose memory should come from one region.
+ *
+ * The arena moves and swaps along with a container's contents.
+ */
+template <typename T>
+class ArenaAllocator
+{
+public:
+	using value_type = T;
+	using propagate_on_container_copy_assignment = std::true_type;
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_swap = std::true_type;
+
+	inline ArenaAllocator(Arena* pArena = nullptr) noexcept
+		:	m_pArena{pArena}
+	{
+	}
+
+	template <typename U>
+	inline ArenaAllocator(ArenaAllocator<U> const& other) noexcept
+		:	m_pArena{other.arena()}
+	{
+	}
+
+	inline T* allocate(std::size_t const count)
+	{
+		return static_cast<T*>(m_pArena
+			? m_pArena->allocate(count * sizeof(T), alignof(T))
+			: ::operator new(count * sizeof(T)));
+	}
+
+	inline void deallocate(T* const pMemory, std::size_t const count) noexcept
+	{
+		if (m_pArena) {
+			m_pArena->deallocate(pMemory, count * sizeof(T), alignof(T));
+		}
+		else {
+			::operator delete(pMemory);
+		}
+	}
+
+	inline Arena* arena() const noexcept
+	{ return m_pArena; }
+
+private:
+	Arena* m_pArena;
+};
+
+
+template <typename T, typename U>
+inline bool
+operator==(ArenaAllocator<T> const& lhs, ArenaAllocator<U> const& rhs) noexcept
+{
+	return lhs.arena() == rhs.arena();
+}
+
+
+template <typename T, typename U>
+inline bool
+operator!=(ArenaAllocator<T> const& lhs, ArenaAllocator<U> const& rhs) noexcept
+{
+	return lhs.arena() != rhs.arena();
+}
+
+
+/** A vector whose storage comes from an Arena. */
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+
+/**
+ * A monotonic arena for debug-draw geometry, shareable between renderers.
+ *
+ * Memory is handed out by bumping an offset through large chunks, so many
+ * renderers' growing arrays make a few big heap allocations rather than
+ * dozens of small ones. Freeing memory only counts it off its chunk; once a
+ * chunk has nothing left allocated from it, it's rewound as a whole and
+ * reused. PrimitiveRenderer gives up its storage on every clear, so each
+ * frame's geometry replaces the last in the same chunks.
+ *
+ * Each @ref reset starts a new chunk, so that DebugDraws sharing an arena
+ * begin their frames in chunks of their own rather than after each other's
+ * live geometry. Each chunk then empties once every owner has cleared again,
+ * and the arena stays within about twice the largest frame of all the owners
+ * together, plus a chunk per owner.
+ *
+ * Not thread-safe: share an arena only between renderers used on one thread.
+ * It must outlive everything allocated from it.
+ *
+ * @code
+ * b2draw::FrameArena arena;
+ * b2draw::DebugDraw mainView{position, colour, 16, 0.5f, 4.0f, 3, &arena};
+ * b2draw::DebugDraw minimap{position, colour, 8, 0.5f, 4.0f, 3, &arena};
+ * // ...
+ * log(arena.usedBytes(), arena.peakBytes());
+ * @endcode
+ */
+class FrameArena
+	:	public Arena
+{
+public:
+	/** The default size of each chunk, in bytes. */
+	static constexpr std::size_t s_defaultChunkSize = 1u << 20;
+
+	/**
+	 * Create an empty arena; no memory is allocated until first used.
+	 *
+	 * @param chunkSize the size of each chunk; larger requests get a chunk
+	 * of their own.
+	 */
+	explicit FrameArena(std::size_t chunkSize = s_defaultChunkSize);
+
+	FrameArena(FrameArena const&) = delete;
+	FrameArena& operator=(FrameArena const&) = delete;
+
+	virtual ~FrameArena() noexcept override;
+
+	virtual void* allocate(std::size_t bytes, std::size_t alignment) override;
+
+	virtual void deallocate(
+		void* pMemory,
+		std::size_t bytes,
+		std::size_t alignment
+	) noexcept override;
+
+	/** Make the next allocation in an empty chunk, or a new one. */
+	virtual void reset() noexcept override;
+
+	/**
+	 * The bytes taken from chunks and not yet rewound, including memory
+	 * freed from chunks still in use.
+	 */
+	inline std::size_t usedBytes() const noexcept
+	{ return m_usedBytes; }
+
+	/** The most bytes ever used at once, since creation or @ref resetPeak. */
+	inline std::size_t peakBytes() const noexcept
+	{ return m_peakBytes; }
+
+	inline void resetPeak() noexcept
+	{ m_peakBytes = m_usedBytes; }
+
+	/** The bytes held from the heap, in chunks, whether used or not. */
+	inline std::size_t reservedBytes() const noexcept
+	{ return m_reservedBytes; }
+
+	inline std::size_t chunkSize() const noexcept
+	{ return m_chunkSize; }
+
+	/** Return chunks with nothing allocated from them to the heap. */
+	void trim() noexcept;
+
+private:
+	struct Chunk
+	{
+		std::unique_ptr<unsigned char[]> pMemory;
+		std::size_t size;
+
+		/** The offset of the chunk's free space. */
+		std::size_t used;
+
+		/** Allocations not yet freed. */
+		std::size_t live;
+	};
+
+	/** Move on to an empty chunk with room for @p bytes, or a new one. */
+	void nextChunk(std::size_t bytes);
+
+	std::vector<Chunk> m_chunks;
+	std::size_t m_current;
+	std::size_t m_chunkSize;
+	std::size_t m_usedBytes;
+	std::size_t m_peakBytes;
+	std::size_t m_reservedBytes;
+
+	/** Whether the next allocation moves on to an empty chunk. */
+	bool m_resetting;
+};
+
+
+} // namespace b2draw
+#endif // #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__FRAMEARENA__H
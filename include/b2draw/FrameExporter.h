@@ -0,0 +1,226 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__FRAMEEXPORTER__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__FRAMEEXPORTER__H
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+
+namespace b2draw {
+
+
+/**
+ * Renders offscreen and saves each frame, without stalling the render thread.
+ *
+ * Drawing between @ref begin and @ref end goes to an RGBA8 framebuffer object.
+ * @ref end starts an asynchronous read into the next of a ring of pixel buffer
+ * objects, guarded by a fence, and collects any earlier reads which have
+ * since completed. Collected frames are encoded and written by a background
+ * thread; if it falls behind by more than its queue, frames are dropped and
+ * counted rather than blocking the caller, unless @ref setDropFrames is
+ * turned off.
+ *
+ * Needs no window, so works on e.g. an EGL surfaceless context. The context
+ * must be current whenever the exporter is created, used or destroyed.
+ *
+ * @code
+ * b2draw::FrameExporter exporter{
+ *     "overlay.y4m", b2draw::FrameExporter::Format::y4m, 1280, 720};
+ * // Render loop:
+ * exporter.begin();
+ * glClear(GL_COLOR_BUFFER_BIT);
+ * debugDraw.Render();
+ * exporter.end();
+ * @endcode
+ */
+class FrameExporter
+{
+public:
+	/** How frames are saved. */
+	enum class Format : unsigned
+	{
+		/**
+		 * A sequence of RGBA PNG files, named by appending e.g. `-000042.png`
+		 * to the path. Image data is stored uncompressed, keeping encoding
+		 * cheap; recompress with other tools if needed.
+		 */
+		png,
+
+		/** One raw YUV4MPEG2 4:4:4 video, e.g. for `ffmpeg -i`. */
+		y4m
+	};
+
+	/** The number of pixel buffers cycled through by default. */
+	static constexpr std::size_t s_defaultRingSize = 3u;
+
+	/** The number of collected frames which may wait to be encoded. */
+	static constexpr std::size_t s_defaultQueueSize = 8u;
+
+	/**
+	 * Create the framebuffer and pixel buffers, and start the encoder.
+	 *
+	 * @param framesPerSecond the frame rate recorded in Y4M headers.
+	 * @param ringSize the number of frames read back concurrently; more
+	 * tolerate a slower GPU, at the cost of latency and memory.
+	 * @throws std::runtime_error if GL objects can't be created, or the Y4M
+	 * file can't be opened.
+	 */
+	FrameExporter(
+		std::string path,
+		Format format,
+		GLsizei width,
+		GLsizei height,
+		unsigned framesPerSecond = 60u,
+		std::size_t ringSize = s_defaultRingSize,
+		std::size_t maxQueuedFrames = s_defaultQueueSize
+	);
+
+	FrameExporter(FrameExporter const&) = delete;
+	FrameExporter& operator=(FrameExporter const&) = delete;
+
+	/** Finish, then delete the GL objects. */
+	~FrameExporter() noexcept;
+
+	/**
+	 * Direct drawing to the exporter's framebuffer, sized to the frame.
+	 *
+	 * The framebuffer is not cleared.
+	 */
+	void begin() noexcept;
+
+	/**
+	 * Start reading back the frame drawn since @ref begin, and restore the
+	 * previous framebuffers and viewport.
+	 *
+	 * Only waits on the GPU if the read started @ref ringSize frames ago
+	 * hasn't completed, which is counted in @ref stalls.
+	 */
+	void end();
+
+	/**
+	 * Collect every pending frame, waiting if need be, and wait for them to
+	 * be written. No more frames can be exported afterwards.
+	 */
+	void finish() noexcept;
+
+	inline GLuint framebuffer() const noexcept
+	{ return m_framebuffer; }
+
+	inline GLsizei width() const noexcept
+	{ return m_width; }
+
+	inline GLsizei height() const noexcept
+	{ return m_height; }
+
+	inline std::size_t ringSize() const noexcept
+	{ return m_readbacks.size(); }
+
+	/** Frames read back by @ref end. */
+	inline std::size_t framesCaptured() const noexcept
+	{ return m_framesCaptured; }
+
+	inline std::size_t framesWritten() const noexcept
+	{ return m_framesWritten; }
+
+	/** Frames dropped because the encoder was behind. */
+	inline std::size_t framesDropped() const noexcept
+	{ return m_framesDropped; }
+
+	/** Times @ref end had to wait for a read to complete. */
+	inline std::size_t stalls() const noexcept
+	{ return m_stalls; }
+
+	/**
+	 * Set whether frames are dropped when the encoder falls behind, the
+	 * default, or @ref end waits for it; e.g. to keep every frame in CI.
+	 */
+	inline void setDropFrames(bool drop) noexcept
+	{ m_dropFrames = drop; }
+
+	inline bool dropsFrames() const noexcept
+	{ return m_dropFrames; }
+
+	/** Whether writing a frame has failed, after which none are written. */
+	inline bool failed() const noexcept
+	{ return m_failed; }
+
+private:
+	/** A frame being read into a pixel buffer. */
+	struct Readback
+	{
+		GLuint buffer;
+		GLsync fence;
+		std::size_t frame;
+	};
+
+	/** A collected frame: RGBA rows, bottom first, as read by GL. */
+	struct Image
+	{
+		std::vector<unsigned char> pixels;
+		std::size_t frame;
+	};
+
+	/**
+	 * Map a completed read, copy its frame and queue it for encoding.
+	 *
+	 * @param wait whether to wait for the read to complete.
+	 * @returns false if the read hadn't completed and @p wait was false.
+	 */
+	bool collect(Readback& readback, bool wait);
+
+	void run() noexcept;
+
+	bool encode(Image const& image);
+
+	bool writePng(Image const& image);
+
+	bool writeY4m(Image const& image);
+
+	void releaseResources() noexcept;
+
+	std::string m_path;
+	Format m_format;
+	GLsizei m_width;
+	GLsizei m_height;
+	unsigned m_framesPerSecond;
+
+	GLuint m_framebuffer;
+	GLuint m_renderbuffer;
+	std::vector<Readback> m_readbacks;
+	std::size_t m_nextReadback;
+	std::size_t m_framesCaptured;
+	std::size_t m_stalls;
+	bool m_finished;
+
+	/** The bindings replaced by @ref begin. */
+	GLint m_previousDrawFramebuffer;
+	GLint m_previousReadFramebuffer;
+	GLint m_previousViewport[4];
+
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::deque<Image> m_queue;
+	std::vector<Image> m_spareImages;
+	std::size_t m_maxQueuedFrames;
+	bool m_stopping;
+	bool m_dropFrames;
+	std::atomic<bool> m_failed;
+	std::atomic<std::size_t> m_framesWritten;
+	std::atomic<std::size_t> m_framesDropped;
+
+	/** Encoder scratch space, only used by the background thread. */
+	std::vector<unsigned char> m_encoded;
+	std::ofstream m_video;
+	std::thread m_thread;
+};
+
+
+} // namespace b2draw
+#endif // #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__FRAMEEXPORTER__H
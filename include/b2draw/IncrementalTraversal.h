@@ -0,0 +1,224 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__INCREMENTALTRAVERSAL__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__INCREMENTALTRAVERSAL__H
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <Box2D/Collision/b2Collision.h>
+#include <Box2D/Common/b2Draw.h>
+#include <Box2D/Dynamics/b2WorldCallbacks.h>
+
+#include "b2draw/PrimitiveRenderer.h"
+#include "b2draw/ResourcePool.h"
+
+
+class b2Body;
+class b2World;
+
+
+namespace b2draw {
+
+
+/**
+ * Draws a world's bodies a few at a time, for worlds too large to traverse
+ * within a frame.
+ *
+ * Bodies are split into chunks of consecutive bodies in the world's body
+ * list. Each call to @ref update re-records as many chunks as fit in the time
+ * budget, continuing where the last call stopped, and uploads only those
+ * chunks. Each chunk keeps its geometry in its own vertex buffers, so @ref
+ * render draws the whole world from what's already on the GPU, and neither
+ * call costs time in proportion to the world. Chunks lag behind by up to one
+ * full pass.
+ *
+ * Only shapes and centres of mass are drawn, as a DebugDraw would draw them;
+ * draw joints and other layers separately if needed.
+ *
+ * The traversal resumes from a body it holds on to between calls, so call
+ * @ref removeBody before destroying any body, or set a DestructionListener
+ * as the world's to do so. Debug builds check that the body is still in the
+ * world before resuming from it. Bodies created mid-pass are drawn from the
+ * next pass.
+ */
+class IncrementalTraversal
+{
+public:
+	struct Settings
+	{
+		/** Time allowed per call for re-recording chunks. */
+		std::chrono::microseconds budget{2000};
+
+		/** Bodies per chunk; the budget is checked between chunks. */
+		std::size_t bodiesPerChunk{1024u};
+
+		/** As given to DebugDraw. */
+		unsigned numCircleSegments{16u};
+		float32 fillAlpha{0.5f};
+		float32 axisScale{4.0f};
+
+		/**
+		 * Whether to outline each chunk's bounds, shading from green when
+		 * just recorded to red when @ref staleAfter calls old.
+		 */
+		bool showRegions{false};
+		unsigned staleAfter{60u};
+	};
+
+	/**
+	 * Calls @ref removeBody as `b2World::DestroyBody` destroys each body's
+	 * fixtures, passing every call on to the listener it chains to, if any.
+	 *
+	 * Box2D says goodbye only to fixtures, so call @ref removeBody for
+	 * bodies without fixtures.
+	 *
+	 * @code
+	 * b2draw::IncrementalTraversal::DestructionListener listener{
+	 *     traversal, &gameListener};
+	 * world.SetDestructionListener(&listener);
+	 * @endcode
+	 */
+	class DestructionListener
+		:	public b2DestructionListener
+	{
+	public:
+		explicit DestructionListener(
+			IncrementalTraversal& traversal,
+			b2DestructionListener* pChained = nullptr
+		) noexcept;
+
+		DestructionListener(DestructionListener const&) = delete;
+		DestructionListener& operator=(DestructionListener const&) = delete;
+
+		virtual void SayGoodbye(b2Joint* pJoint) override;
+		virtual void SayGoodbye(b2Fixture* pFixture) override;
+
+	private:
+		IncrementalTraversal& m_traversal;
+		b2DestructionListener* m_pChained;
+	};
+
+	/** The area covered by a chunk, and when it was last recorded. */
+	struct Region
+	{
+		b2AABB bounds;
+
+		/** The value of @ref updateCount when the chunk was recorded. */
+		std::uint64_t recordedAt;
+	};
+
+	/**
+	 * Create a traversal with no chunks.
+	 *
+	 * No GL calls are made until the first @ref update; vertex buffers are
+	 * taken from @p pool, and returned as chunks are dropped.
+	 */
+	IncrementalTraversal(
+		GLint positionAttribLoc,
+		GLint colourAttribLoc,
+		ResourcePool& pool = ResourcePool::shared()
+	);
+
+	IncrementalTraversal(
+		GLint positionAttribLoc,
+		GLint colourAttribLoc,
+		Settings const& settings,
+		ResourcePool& pool = ResourcePool::shared()
+	);
+
+	IncrementalTraversal(IncrementalTraversal const&) = delete;
+	IncrementalTraversal& operator=(IncrementalTraversal const&) = delete;
+
+	~IncrementalTraversal() noexcept;
+
+	/**
+	 * Re-record and upload chunks for up to the time budget.
+	 *
+	 * At least one chunk is recorded per call, so passes always progress.
+	 *
+	 * @param flags which of `e_shapeBit` and `e_centerOfMassBit` to draw,
+	 * e.g. a DebugDraw's flags.
+	 * @throws std::runtime_error if GL objects can't be created.
+	 */
+	void update(b2World& world, uint32 flags);
+
+	/**
+	 * Draw every chunk's last upload, with the bound program: outlines, then
+	 * fills, then segments, then any regions.
+	 */
+	void render();
+
+	/**
+	 * Let go of a body about to be destroyed, e.g. just before calling
+	 * `b2World::DestroyBody`, so that the traversal doesn't resume from it.
+	 * Its shapes are dropped when its chunk is next recorded.
+	 */
+	void removeBody(b2Body const& body) noexcept;
+
+	/** Start the next pass from the head of the body list. */
+	void restart() noexcept;
+
+	inline Settings const& settings() const noexcept
+	{ return m_settings; }
+
+	/** Change the settings; circle segments apply to new chunks only. */
+	inline void setSettings(Settings const& settings) noexcept
+	{ m_settings = settings; }
+
+	/** The number of calls to @ref update so far. */
+	inline std::uint64_t updateCount() const noexcept
+	{ return m_updateCount; }
+
+	/** The number of complete passes over the world so far. */
+	inline std::uint64_t passCount() const noexcept
+	{ return m_passCount; }
+
+	/** The number of chunks uploaded by the last @ref update. */
+	inline std::size_t uploadCount() const noexcept
+	{ return m_uploadCount; }
+
+	inline std::size_t regionCount() const noexcept
+	{ return m_chunks.size(); }
+
+	inline Region const& region(std::size_t index) const noexcept
+	{ return m_chunks[index].region; }
+
+private:
+	class Recorder;
+
+	/** A chunk's geometry, drawn as DebugDraw draws it. */
+	struct Chunk
+	{
+		PrimitiveRenderer lines;
+		PrimitiveRenderer fills;
+		PrimitiveRenderer segments;
+		Region region;
+	};
+
+	/** Record and upload the next chunk of bodies, advancing the cursor. */
+	void recordChunk(uint32 flags);
+
+	/** Outline each chunk's bounds, shaded by age, and upload them. */
+	void updateRegions();
+
+	Settings m_settings;
+	ResourcePool* m_pPool;
+	GLint m_positionLocation;
+	GLint m_colourLocation;
+	std::vector<Chunk> m_chunks;
+	PrimitiveRenderer m_regionRenderer;
+
+	/** The world last traversed, and the next body to record from it. */
+	b2World const* m_pWorld;
+	b2Body* m_pNextBody;
+	std::size_t m_nextChunk;
+	std::uint64_t m_updateCount;
+	std::uint64_t m_passCount;
+	std::size_t m_uploadCount;
+};
+
+
+} // namespace b2draw
+#endif // #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__INCREMENTALTRAVERSAL__H
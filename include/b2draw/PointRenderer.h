@@ -0,0 +1,146 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__POINTRENDERER__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__POINTRENDERER__H
+#include <array>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include "b2draw/PrimitiveRenderer.h"
+#include "b2draw/ResourcePool.h"
+
+
+namespace b2draw {
+
+
+/**
+ * Buffers and renders points as a single `GL_POINTS` draw.
+ *
+ * Each point is one vertex, with a position, colour and size. Sizes are read
+ * by the vertex shader through the size attribute and written to
+ * `gl_PointSize`; the plain program scales them by
+ * ProgramLibrary::setPointScale, so they can be in pixels or metres. Without
+ * a size attribute, points are drawn at the context's `glPointSize`.
+ *
+ * Positions and colours are stored as for PrimitiveRenderer, so that the
+ * points can be viewed as a single primitive, e.g. in a frame; sizes are
+ * stored alongside them.
+ */
+class PointRenderer
+{
+public:
+	/** The size of points buffered from a view, which carries no sizes. */
+	static constexpr float32 s_defaultSize = 4.0f;
+
+	/**
+	 * Create an empty renderer.
+	 *
+	 * No GL calls are made until the first @ref bufferData, when a vertex
+	 * buffer is taken from @p pool; it is returned on destruction.
+	 */
+	PointRenderer(
+		GLint positionAttribLocation,
+		GLint colourAttribLocation,
+		GLint sizeAttribLocation = -1,
+		ResourcePool& pool = ResourcePool::shared()
+	);
+
+	PointRenderer(PointRenderer const&) = delete;
+	PointRenderer& operator=(PointRenderer const&) = delete;
+
+	PointRenderer(PointRenderer&& other) noexcept;
+	PointRenderer& operator=(PointRenderer&& other) noexcept;
+
+	~PointRenderer() noexcept;
+
+	inline void addPoint(
+		b2Vec2 const& position,
+		float32 size,
+		b2Color const& colour
+	)
+	{
+		m_vertices.emplace_back(position, colour);
+		m_sizes.push_back(size);
+		++m_viewSize;
+	}
+
+	inline std::size_t pointCount() const noexcept
+	{ return m_vertices.size(); }
+
+	void clear() noexcept;
+
+	/**
+	 * Upload the points added since the last clear.
+	 *
+	 * @throws std::runtime_error if GL objects can't be created.
+	 */
+	void bufferData();
+
+	/**
+	 * Replace the points with a view's vertices, each drawn at @p size, and
+	 * upload them.
+	 *
+	 * @throws std::runtime_error if GL objects can't be created.
+	 */
+	void bufferData(PrimitiveView const& points, float32 size = s_defaultSize);
+
+	/** Draw the uploaded points with the bound program. */
+	void render() noexcept;
+
+	/** View the points as a single primitive, or none if there are none. */
+	PrimitiveView view() const noexcept;
+
+	inline GLint sizeAttribLocation() const noexcept
+	{ return m_sizeLocation; }
+
+	/** Set the locations used from the next @ref bufferData. */
+	inline void setAttribLocations(
+		GLint position,
+		GLint colour,
+		GLint size
+	) noexcept
+	{
+		m_positionLocation = position;
+		m_colourLocation = colour;
+		m_sizeLocation = size;
+	}
+
+	inline void setPositionAttribLocation(GLint location) noexcept
+	{ m_positionLocation = location; }
+
+	inline void setColourAttribLocation(GLint location) noexcept
+	{ m_colourLocation = location; }
+
+	/** E.g. ProgramLibrary::s_pointSizeLocation. */
+	inline void setSizeAttribLocation(GLint location) noexcept
+	{ m_sizeLocation = location; }
+
+private:
+	/** Point the vertex array at the buffer, whose sizes follow @p count. */
+	void applyAttribLocations(std::size_t count) noexcept;
+
+	void releaseBuffer() noexcept;
+
+	std::vector<Vertex> m_vertices;
+	std::vector<float32> m_sizes;
+
+	/** The first index and size of the single primitive in @ref view. */
+	GLint m_viewFirst;
+	GLsizei m_viewSize;
+
+	ResourcePool* m_pPool;
+	VertexBuffer m_buffer;
+	bool m_hasBuffer;
+	GLsizei m_bufferedCount;
+
+	GLint m_positionLocation;
+	GLint m_colourLocation;
+	GLint m_sizeLocation;
+
+	/** The locations enabled in the vertex array, to disable on change. */
+	std::array<GLint, 3> m_enabledLocations;
+};
+
+
+} // namespace b2draw
+#endif // #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__POINTRENDERER__H
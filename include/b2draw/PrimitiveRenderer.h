@@ -1,5 +1,6 @@
 #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__PRIMITIVERENDERER__H
 #define HEADER_INCLUDE__RECURSION__PHYSICS__B2__PRIMITIVERENDERER__H
+#include <chrono>
 #include <vector>
 #include <utility>
 
@@ -8,16 +9,96 @@
 
 #include <Box2D/Common/b2Draw.h> // For b2Color.
 
+#include "b2draw/FrameArena.h"
+#include "b2draw/ResourcePool.h"
+#include "b2draw/SpatialIndex.h"
+
 
 namespace b2draw {
 
 
 using Vertex = std::pair<b2Vec2, b2Color>;
 
+static_assert(
+	sizeof(Vertex) == 6 * sizeof(float32),
+	"Vertices must be tightly packed, as they are uploaded and saved as-is");
+
+
+/**
+ * A read-only view of a set of primitives.
+ *
+ * Primitive `i` consists of the `pPolygonSizes[i]` vertices starting at
+ * `pVertices[pFirstIndices[i]]`.
+ */
+struct PrimitiveView
+{
+	Vertex const* pVertices;
+	std::size_t vertexCount;
+	GLint const* pFirstIndices;
+	GLsizei const* pPolygonSizes;
+	std::size_t polygonCount;
+};
+
+
+/** Ways in which a PrimitiveRenderer can submit its primitives. */
+enum class SubmissionStrategy : unsigned
+{
+	/** One `glMultiDrawArrays` call over the primitives' vertex ranges. */
+	multiDraw,
+
+	/**
+	 * One `glDrawElements` call, with fans converted to indexed triangles and
+	 * loops and strips to indexed lines.
+	 */
+	indexed,
+
+	/** One `glMultiDrawArraysIndirect` call, reading a command buffer. */
+	indirect,
+
+	count
+};
+
+
+/** Get the name of a submission strategy, e.g. for persisting it. */
+char const* toString(SubmissionStrategy strategy) noexcept;
+
+
+/**
+ * Parse a submission strategy name, as returned by @ref toString.
+ *
+ * @returns true if @p pName was recognised, in which case @p strategy is set.
+ */
+bool fromString(char const* pName, SubmissionStrategy& strategy) noexcept;
+
 
 class PrimitiveRenderer
 {
 public:
+	/** The number of vertex buffers cycled through by default. */
+	static constexpr unsigned s_defaultBufferCount = 3u;
+
+	/** The most palette colours used, as ProgramLibrary::s_paletteSize. */
+	static constexpr std::size_t s_maxPaletteSize = 64u;
+
+	/** A value identifying a primitive's source, e.g. a `b2Fixture*`. */
+	using Tag = void const*;
+
+	/** Statistics gathered by @ref bufferData. */
+	struct UploadStats
+	{
+		/** Total time spent polling fences for a free vertex buffer. */
+		std::chrono::nanoseconds fenceWaitTime{0};
+
+		/** Number of uploads performed. */
+		std::size_t uploads{0};
+
+		/**
+		 * Number of uploads which found every vertex buffer still in use by
+		 * the GPU, and so fell back to orphaning the next buffer.
+		 */
+		std::size_t busyUploads{0};
+	};
+
 	/**
 	 * Create an uninitialised PrimitiveRenderer.
 	 *
@@ -30,10 +111,31 @@ public:
 	{
 	}
 
+	/**
+	 * Create a PrimitiveRenderer.
+	 *
+	 * No GL calls are made until the first @ref bufferData, when vertex
+	 * buffers are taken from @p pool; they are returned to it on destruction.
+	 *
+	 * When GL 4.5 or ARB_direct_state_access is available, buffers and vertex
+	 * arrays are set up and filled through direct state access, so that
+	 * attribute changes and uploads do not disturb the global bindings.
+	 *
+	 * @param numBuffers the number of vertex buffers to rotate through. Each
+	 * upload goes to a buffer the GPU has finished reading from, so that @ref
+	 * bufferData need not wait on the previous frame's @ref render.
+	 * @param pool the pool from which to take vertex buffers.
+	 * @param pArena where to keep vertices and primitive ranges, e.g. a
+	 * FrameArena shared with other renderers; if null, the heap. When set,
+	 * @ref clear gives the storage back to it.
+	 */
 	PrimitiveRenderer(
 		GLint vertexAttribLocation,
 		GLint colourAttribLocation,
-		unsigned numCircleSegments = 16u
+		unsigned numCircleSegments = 16u,
+		unsigned numBuffers = s_defaultBufferCount,
+		ResourcePool& pool = ResourcePool::shared(),
+		Arena* pArena = nullptr
 	);
 
 	// PrimitiveRenderer is non-copyable.
@@ -58,27 +160,204 @@ public:
 		float32 const initialAngle = 0.0f
 	);
 
+	/**
+	 * Add a segment.
+	 *
+	 * If coalescing segments, and @p begin and @p colour match the end of the
+	 * last primitive, extends that primitive instead. Only meaningful when
+	 * drawing strips.
+	 */
 	void addSegment(
 		b2Vec2 const& begin,
 		b2Vec2 const& end,
 		b2Color const& colour
 	);
 
-	/** Buffer data. */
+	/**
+	 * Start a group of primitives to be drawn with their own transform.
+	 *
+	 * Primitives added until the next call, or @ref clear, are placed at
+	 * `offset + scale * position`, e.g. to tile several worlds in one view.
+	 * Groups share one vertex upload; @ref render draws each with the
+	 * transform set as the constant value of the world transform attribute,
+	 * so it costs one draw call per group rather than per primitive.
+	 *
+	 * Has no effect unless a world transform attribute location is set.
+	 */
+	void beginGroup(b2Vec2 const& offset, float32 scale = 1.0f);
+
+	inline std::size_t groupCount() const noexcept
+	{ return m_groups.size(); }
+
+	/**
+	 * Set whether each primitive added records the current tag; see @ref
+	 * setTag. Primitives already added are given null tags.
+	 */
+	void setTagging(bool enable);
+
+	inline bool tagging() const noexcept
+	{ return m_tagging; }
+
+	/**
+	 * Tag the primitives added until the next call, or @ref clear, e.g. with
+	 * the fixture being drawn, to be found by @ref pick.
+	 */
+	inline void setTag(Tag tag) noexcept
+	{ m_tag = tag; }
+
+	inline Tag currentTag() const noexcept
+	{ return m_tag; }
+
+	/** Get a primitive's tag, or null if not tagging. */
+	inline Tag tag(std::size_t primitive) const noexcept
+	{ return primitive < m_tags.size() ? m_tags[primitive] : nullptr; }
+
+	/**
+	 * Find the primitives added since the last @ref clear within a distance
+	 * of a point, e.g. to identify what's under the cursor.
+	 *
+	 * Fans and loops are hit anywhere inside, as well as near their edges.
+	 * Positions are in scene space, after any group transform. The first
+	 * pick after primitives are added or removed indexes their bounds in a
+	 * SpatialIndex, so that later picks only test primitives nearby.
+	 *
+	 * @param mode the mode the primitives are drawn with.
+	 * @param primitives appended with the index of each primitive hit, in
+	 * drawing order; see @ref tag.
+	 */
+	void pick(
+		GLenum mode,
+		b2Vec2 const& point,
+		float32 radius,
+		std::vector<std::size_t>& primitives
+	);
+
+	/**
+	 * Drop or thin out primitives added since the last @ref clear.
+	 *
+	 * @param strides one per primitive: 0 drops the primitive, and `n` keeps
+	 * every `n`th of its vertices, e.g. 2 to halve a circle's segments.
+	 */
+	void compact(std::vector<unsigned char> const& strides);
+
+	/**
+	 * Buffer data.
+	 *
+	 * Writes to the next vertex buffer whose fence has been signalled, never
+	 * blocking on the GPU. If all buffers are still in use, the next one is
+	 * orphaned instead and the upload is counted in @ref UploadStats.
+	 */
 	void bufferData();
 
-	/** Render data. */
+	/**
+	 * Buffer externally owned primitives in place of the renderer's own.
+	 *
+	 * The vertices are uploaded directly from @p primitives, and subsequent
+	 * calls to @ref render draw its primitive ranges, so the viewed memory
+	 * must outlive those calls. The next call to @ref bufferData() reverts to
+	 * the renderer's own primitives.
+	 */
+	void bufferData(PrimitiveView const& primitives);
+
+	/**
+	 * Render data.
+	 *
+	 * Index and command buffers needed by the current @ref
+	 * SubmissionStrategy are built on the first render after each upload.
+	 */
 	void render(GLenum const mode);
 
+	/**
+	 * Render data, blending each vertex from its position in the previous
+	 * upload to its position in the latest.
+	 *
+	 * Lets geometry buffered at the physics rate be drawn smoothly at the
+	 * display rate: blending is done in the vertex shader, which reads the
+	 * previous upload's vertex buffer as a second position attribute. If the
+	 * two uploads' primitives differ in number or size, the latest is drawn
+	 * as-is.
+	 *
+	 * Requires both a previous position and a world transform attribute
+	 * location, and at least two vertex buffers.
+	 *
+	 * @param alpha how far to blend, from 0 for the previous upload to 1 for
+	 * the latest.
+	 */
+	void render(GLenum const mode, float32 alpha);
+
+	/**
+	 * Whether the latest two uploads have matching primitives, and so can be
+	 * blended by @ref render(GLenum, float32).
+	 */
+	inline bool canInterpolate() const noexcept
+	{ return m_canInterpolate; }
+
+	/**
+	 * Render only the primitives whose bounds overlap a view, culled on the
+	 * GPU.
+	 *
+	 * On the first culled render after each upload, every primitive's bounds
+	 * are computed and uploaded along with its draw command. Each call then
+	 * runs a compute pass testing the bounds against the view and writing the
+	 * survivors' commands to an indirect draw list, which is drawn without
+	 * reading it back, so the CPU cost of a view doesn't grow with the number
+	 * of primitives; e.g. to draw one upload in several viewports.
+	 *
+	 * With GL 4.6 or ARB_indirect_parameters, survivors are compacted and
+	 * drawn with `glMultiDrawArraysIndirectCount`, in no particular order
+	 * within a group. Otherwise, e.g. on GL 4.5, every command is kept in
+	 * place and culled ones are given no instances.
+	 *
+	 * The view is in scene space, after any group transform. Uploads are
+	 * drawn as-is, without interpolation.
+	 *
+	 * @param cullProgram the ProgramKind::cullPrimitives program.
+	 * @param drawProgram the program to draw with, bound after the compute
+	 * pass; given rather than queried, as reading it back would stall.
+	 * @param minSize primitives narrower and shorter than this, in scene
+	 * units, are skipped too; e.g. a pixel's width, to skip unseen detail.
+	 */
+	void renderCulled(
+		GLenum mode,
+		b2Vec2 const& lower,
+		b2Vec2 const& upper,
+		GLuint cullProgram,
+		GLuint drawProgram,
+		float32 minSize = 0.0f
+	);
+
+	/** Whether the current context supports a submission strategy. */
+	static bool isSupported(SubmissionStrategy strategy) noexcept;
+
+	/** Whether the current context supports @ref renderCulled. */
+	static bool supportsCulling() noexcept;
+
+	/**
+	 * Set how primitives are submitted.
+	 *
+	 * Unsupported strategies, and indexed submission of modes other than
+	 * fans, loops and strips, fall back to @ref SubmissionStrategy::multiDraw.
+	 */
+	void setSubmissionStrategy(SubmissionStrategy strategy) noexcept;
+
+	inline SubmissionStrategy submissionStrategy() const noexcept
+	{ return m_submissionStrategy; }
+
 	/**
 	 * Clear internally buffered data.
 	 *
-	 * Should be called after every b2World::DrawDebugData call.
+	 * Should be called after every b2World::DrawDebugData call. If using an
+	 * arena, the primitives' storage is returned to it, and the next frame's
+	 * is reserved at once, sized after this one's.
 	 */
 	void clear();
 
+	/** The arena primitives are kept in, or null if the heap. */
+	inline Arena* arena() const noexcept
+	{ return m_vertices.get_allocator().arena(); }
+
 	inline std::size_t const numCircleSegments() const noexcept
-	{ return m_tmpCircleBuffer.size(); }
+	{ return m_numCircleSegments; }
 
 	inline std::size_t vertexCount() const noexcept
 	{ return m_vertices.size(); }
@@ -89,56 +368,416 @@ public:
 	inline bool empty() const noexcept
 	{ return m_firstIndices.empty(); }
 
+	/** View the primitives added since the last @ref clear. */
+	inline PrimitiveView view() const noexcept
+	{
+		return PrimitiveView{
+			m_vertices.data(),
+			m_vertices.size(),
+			m_firstIndices.data(),
+			m_polygonSizes.data(),
+			m_polygonSizes.size()
+		};
+	}
+
+	inline std::size_t bufferCount() const noexcept
+	{ return m_numBuffers; }
+
+	/**
+	 * Whether the direct state access code path is in use.
+	 *
+	 * Always false before the first upload.
+	 */
+	inline bool usesDirectStateAccess() const noexcept
+	{ return m_useDirectStateAccess; }
+
+	inline UploadStats const& uploadStats() const noexcept
+	{ return m_uploadStats; }
+
+	inline void resetUploadStats() noexcept
+	{ m_uploadStats = UploadStats{}; }
+
+	/**
+	 * Set whether consecutive segments sharing an endpoint and colour are
+	 * merged into one polyline; see @ref addSegment.
+	 */
+	inline void setSegmentCoalescing(bool enable) noexcept
+	{ m_coalesceSegments = enable; }
+
+	inline bool coalescesSegments() const noexcept
+	{ return m_coalesceSegments; }
+
 	/** Set the number of circle segments. */
 	void setCircleSegments(unsigned count);
 
+	inline GLint positionAttribLocation() const noexcept
+	{ return m_positionLocation; }
+
+	inline GLint colourAttribLocation() const noexcept
+	{ return m_colourLocation; }
+
 	/** Set the position attribute location. */
-	inline void
-	setPositionAttribLocation(GLint location) noexcept
+	void setPositionAttribLocation(GLint location) noexcept;
+
+	/** Set the colour attribute location. */
+	void setColourAttribLocation(GLint location) noexcept;
+
+	void setAttribLocations(
+		GLint positionLocation,
+		GLint colourLocation
+	) noexcept;
+
+	inline GLint worldTransformAttribLocation() const noexcept
+	{ return m_worldTransformLocation; }
+
+	/**
+	 * Set the location of the vec4 world transform attribute: an offset in
+	 * `xy`, the weight of the previous position in `z`, and a scale in `w`.
+	 * Only needed for @ref beginGroup and interpolation.
+	 */
+	inline void setWorldTransformAttribLocation(GLint location) noexcept
+	{ m_worldTransformLocation = location; }
+
+	inline GLint previousPositionAttribLocation() const noexcept
+	{ return m_previousPositionLocation; }
+
+	/**
+	 * Set the location of the vec2 previous position attribute, enabling
+	 * interpolation; see @ref render(GLenum, float32). Pass -1 to disable.
+	 */
+	void setPreviousPositionAttribLocation(GLint location) noexcept;
+
+	/**
+	 * Upload palette indices in place of colours whenever every vertex's
+	 * colour is in the palette, halving the size of each vertex.
+	 *
+	 * Such uploads hold each vertex's position and the index of its colour
+	 * plus one, for ProgramKind::paletteColour to look up, so give that the
+	 * same colours with ProgramLibrary::setPalette. Uploads with any other
+	 * colour are made as usual, with the index attribute left disabled, and
+	 * the program draws them from their own colours. Colours must match
+	 * exactly. At most @ref s_maxPaletteSize colours are used; pass none to
+	 * stop. Needs a palette index attribute location.
+	 */
+	void setPalette(b2Color const* pColours, std::size_t count);
+
+	inline std::vector<b2Color> const& palette() const noexcept
+	{ return m_palette; }
+
+	inline GLint paletteIndexAttribLocation() const noexcept
+	{ return m_paletteIndexLocation; }
+
+	/** Set the location of the float palette index attribute. */
+	void setPaletteIndexAttribLocation(GLint location) noexcept;
+
+	/** Whether the latest upload was made of palette indices. */
+	inline bool usesPalette() const noexcept
 	{
-		glBindVertexArray(m_vao);
-		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-		glEnableVertexAttribArray(location);
-		glVertexAttribPointer(
-			location, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), nullptr);
+		return !m_paletteBuffers.empty() && m_paletteBuffers[m_currentBuffer];
 	}
 
-	/** Set the colour attribute location. */
-	inline void
-	setColourAttribLocation(GLint location) noexcept
+private:
+	/** Primitives drawn with their own transform; see @ref beginGroup. */
+	struct Group
+	{
+		std::size_t firstPrimitive;
+		b2Vec2 offset;
+		float32 scale;
+	};
+
+	/** A vertex as uploaded when its colour is in the palette. */
+	struct PaletteVertex
+	{
+		b2Vec2 position;
+
+		/** The index of the vertex's colour in the palette, plus one. */
+		GLuint index;
+	};
+
+	/** The primitive layout of an upload, to check interpolation is valid. */
+	struct Topology
+	{
+		std::vector<GLint> firstIndices;
+		std::vector<GLsizei> polygonSizes;
+	};
+
+	ArenaVector<Vertex> m_vertices;
+	ArenaVector<GLint> m_firstIndices;
+	ArenaVector<GLsizei> m_polygonSizes;
+	ArenaVector<b2Vec2> m_tmpCircleBuffer;
+	unsigned m_numCircleSegments;
+
+	/** The vertex and primitive counts last cleared, when using an arena. */
+	std::size_t m_vertexHint;
+	std::size_t m_polygonHint;
+
+	/**
+	 * Make room for @p vertices more vertices in a new primitive, growing
+	 * storage geometrically.
+	 */
+	void reservePrimitive(std::size_t vertices);
+
+	/** Each primitive's tag, when tagging. */
+	std::vector<Tag> m_tags;
+	Tag m_tag;
+	bool m_tagging;
+
+	/** Add the current tag for a new primitive, if tagging. */
+	inline void addTag()
+	{
+		if (m_tagging) {
+			m_tags.push_back(m_tag);
+		}
+	}
+
+	/** Index the primitives' scene-space bounds for @ref pick. */
+	void buildIndex();
+
+	/**
+	 * Get the transform drawn with one of this renderer's own primitives,
+	 * which is the identity unless grouped.
+	 */
+	void groupTransform(
+		std::size_t primitive,
+		b2Vec2& offset,
+		float32& scale
+	) const noexcept;
+
+	SpatialIndex m_index;
+	std::vector<SpatialIndex::Bounds> m_tmpBounds;
+	std::vector<std::size_t> m_tmpPicks;
+	bool m_indexed;
+
+	/** The vertex buffer binding index used for direct state access. */
+	static constexpr GLuint s_vertexBindingIndex = 0u;
+
+	/** The binding index of the previous upload's vertex buffer. */
+	static constexpr GLuint s_previousBindingIndex = 1u;
+
+	/** Whether uploads keep the previous one around for interpolation. */
+	inline bool keepsPrevious() const noexcept
+	{ return m_previousPositionLocation >= 0 && m_numBuffers > 1; }
+
+	/** Compare the drawn primitives to those of the previous upload. */
+	void updateTopology();
+
+	/**
+	 * Enable or disable the previous position attribute in the current
+	 * buffer's vertex array, pointing it at the previous buffer.
+	 */
+	void bindPreviousPositions(VertexBuffer& buffer, bool enable) noexcept;
+
+	/**
+	 * Draw with the previous position weighted by @p previousWeight, which is
+	 * only used when interpolating.
+	 */
+	void draw(GLenum mode, float32 previousWeight);
+
+	/** Fence the buffer just drawn from, so it isn't overwritten early. */
+	void fence(VertexBuffer& buffer) noexcept;
+
+	/** Set the world transform attribute's constant value. */
+	inline void setWorldTransform(
+		b2Vec2 const& offset,
+		float32 const previousWeight,
+		float32 const scale
+	) const noexcept
 	{
-		glBindVertexArray(m_vao);
-		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-		glEnableVertexAttribArray(location);
-		glVertexAttribPointer(
-			location, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-			reinterpret_cast<void const*>(offsetof(Vertex, second)));
+		glVertexAttrib4f(
+			m_worldTransformLocation,
+			offset.x,
+			offset.y,
+			previousWeight,
+			scale
+		);
 	}
 
-	inline void
-	setAttribLocations(GLint positionLocation, GLint colourLocation) noexcept
+	/** The primitives drawn by @ref render. */
+	inline PrimitiveView drawnPrimitives() const noexcept
+	{ return m_useExternalPrimitives ? m_externalPrimitives : view(); }
+
+	/** Upload vertices to the next free vertex buffer. */
+	void uploadVertices(Vertex const* pVertices, std::size_t count);
+
+	/** Take this renderer's vertex buffers from the pool. */
+	void acquireBuffers();
+
+	/** Return this renderer's vertex buffers to the pool. */
+	void releaseBuffers() noexcept;
+
+	/** Whether the buffer's last draw has completed; never blocks. */
+	bool isAvailable(VertexBuffer& buffer) noexcept;
+
+	/**
+	 * Point a vertex array's attributes at its buffer, which holds palette
+	 * vertices if @p palette, or full ones.
+	 */
+	void applyAttribLocations(
+		VertexBuffer const& buffer,
+		bool palette
+	) const noexcept;
+
+	/** Re-point every vertex array's attributes, e.g. after a change. */
+	void applyAttribLocations() const noexcept;
+
+	/** The size of each vertex in a buffer. */
+	inline GLsizei vertexStride(std::size_t buffer) const noexcept
 	{
-		glBindVertexArray(m_vao);
-		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+		return m_paletteBuffers[buffer]
+			? GLsizei(sizeof(PaletteVertex))
+			: GLsizei(sizeof(Vertex));
+	}
 
-		glEnableVertexAttribArray(positionLocation);
-		glVertexAttribPointer(
-			positionLocation, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), nullptr);
+	/**
+	 * Look up each vertex's colour in the palette, filling @ref
+	 * m_tmpPaletteVertices.
+	 *
+	 * @returns false if there's no palette, or a colour isn't in it.
+	 */
+	bool indexPalette(Vertex const* pVertices, std::size_t count);
 
-		glEnableVertexAttribArray(colourLocation);
-		glVertexAttribPointer(
-			colourLocation, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-			reinterpret_cast<void const*>(offsetof(Vertex, second)));
+	void disableAttribLocations(VertexBuffer const& buffer) const noexcept;
+
+	/** Whether @ref render should draw each group separately. */
+	inline bool isGrouped() const noexcept
+	{
+		return m_worldTransformLocation >= 0 && !m_groups.empty() &&
+			!m_useExternalPrimitives;
 	}
 
-private:
-	std::vector<Vertex> m_vertices;
-	std::vector<GLint> m_firstIndices;
-	std::vector<GLsizei> m_polygonSizes;
-	std::vector<b2Vec2> m_tmpCircleBuffer;
+	/** Where a group's indices start; only meaningful when indexed. */
+	inline GLsizei groupElementOffset(std::size_t group) const noexcept
+	{
+		return m_submissionStrategy == SubmissionStrategy::indexed &&
+			m_elementMode
+			? m_groupElementOffsets[group]
+			: 0;
+	}
 
-	GLuint m_vbo;
-	GLuint m_vao;
+	/**
+	 * Draw primitives [@p begin, @p end), which are indices
+	 * [@p beginElement, @p endElement) when drawing indexed.
+	 */
+	void drawRange(
+		GLenum mode,
+		std::size_t begin,
+		std::size_t end,
+		GLsizei beginElement,
+		GLsizei endElement
+	) noexcept;
+
+	void multiDraw(GLenum mode, std::size_t begin, std::size_t end) noexcept;
+
+	/**
+	 * Build and upload triangle or line indices for the current buffer.
+	 *
+	 * @returns the mode with which to draw the indices, or 0 if @p mode can't
+	 * be indexed.
+	 */
+	GLenum prepareIndices(VertexBuffer& buffer, GLenum mode);
+
+	/** Build and upload indirect draw commands for the current buffer. */
+	void prepareCommands(VertexBuffer& buffer);
+
+	/**
+	 * Build and upload draw commands and bounds for culling the current
+	 * buffer, and lay out its cull buffer.
+	 */
+	void prepareCulling(VertexBuffer& buffer);
+
+	/** Fill a buffer object, reallocating as needed. */
+	void uploadBuffer(
+		GLuint buffer,
+		GLenum target,
+		GLsizeiptr size,
+		void const* pData
+	) const noexcept;
+
+	/** Layout of `glMultiDrawArraysIndirect` commands. */
+	struct DrawArraysCommand
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint first;
+		GLuint baseInstance;
+	};
+
+	/**
+	 * A primitive's bounds in scene space, as laid out in the culling shader.
+	 *
+	 * Primitives drawn with one transform share a slot, whose surviving
+	 * commands are written from @ref slotStart on and counted separately.
+	 */
+	struct Cullable
+	{
+		b2Vec2 lower;
+		b2Vec2 upper;
+		GLuint slot;
+		GLuint slotStart;
+		GLuint padding[2];
+	};
+
+	/**
+	 * The alignment of each part of a cull buffer, which is bound in parts as
+	 * shader storage; no implementation may require more.
+	 */
+	static constexpr GLintptr s_cullAlignment = 256;
+
+	/** The culling shader's work group size. */
+	static constexpr std::size_t s_cullGroupSize = 64u;
+
+	ResourcePool* m_pPool;
+	std::vector<VertexBuffer> m_buffers;
+	std::size_t m_numBuffers;
+	std::size_t m_currentBuffer;
+	GLint m_positionLocation;
+	GLint m_colourLocation;
+	bool m_useFences;
+	bool m_useDirectStateAccess;
+	UploadStats m_uploadStats;
+
+	SubmissionStrategy m_submissionStrategy;
+	std::vector<GLuint> m_tmpIndices;
+	std::vector<DrawArraysCommand> m_tmpCommands;
+	GLenum m_elementMode;
+	GLsizei m_elementCount;
+
+	/** Where each group's indices start, then the total index count. */
+	std::vector<GLsizei> m_groupElementOffsets;
+	GLenum m_preparedMode;
+	bool m_prepared;
+
+	PrimitiveView m_externalPrimitives;
+	bool m_useExternalPrimitives;
+
+	std::vector<Group> m_groups;
+	GLint m_worldTransformLocation;
+
+	/**
+	 * The first primitive in each cull slot, then the primitive count. The
+	 * cull buffer holds each slot's count, the culled commands from @ref
+	 * m_culledCommandOffset, then the cullables from @ref m_cullableOffset.
+	 */
+	std::vector<std::size_t> m_cullSlots;
+	std::vector<Cullable> m_tmpCullables;
+	GLintptr m_culledCommandOffset;
+	GLintptr m_cullableOffset;
+	bool m_cullPrepared;
+
+	GLint m_previousPositionLocation;
+	std::size_t m_previousBuffer;
+	Topology m_topology;
+	Topology m_previousTopology;
+	bool m_canInterpolate;
+
+	bool m_coalesceSegments;
+
+	std::vector<b2Color> m_palette;
+	GLint m_paletteIndexLocation;
+	std::vector<PaletteVertex> m_tmpPaletteVertices;
+
+	/** Whether each vertex buffer holds palette vertices. */
+	std::vector<unsigned char> m_paletteBuffers;
 };
 
 
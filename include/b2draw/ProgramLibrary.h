@@ -0,0 +1,236 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__PROGRAMLIBRARY__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__PROGRAMLIBRARY__H
+#include <array>
+#include <string>
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <Box2D/Common/b2Draw.h> // For b2Color.
+
+
+namespace b2draw {
+
+
+/** The shader programs shipped with b2draw. */
+enum class ProgramKind : unsigned
+{
+	/** Per-vertex position and colour, as buffered by PrimitiveRenderer. */
+	plain,
+
+	/**
+	 * Circles generated in the vertex shader from per-instance centre, radius
+	 * and colour; draw with `glDrawArraysInstanced`, using as many vertices
+	 * per instance as the constant segment count attribute. See
+	 * CircleRenderer.
+	 */
+	instancedCircle,
+
+	/**
+	 * As plain, except that vertices with a non-zero palette index take their
+	 * colour from the palette instead; see @ref ProgramLibrary::setPalette
+	 * and PrimitiveRenderer::setPalette.
+	 */
+	paletteColour,
+
+	/**
+	 * A heat map over the whole viewport, from a single-channel texture on
+	 * unit 0; see DensityGrid.
+	 */
+	density,
+
+	/**
+	 * A compute program which culls primitives to a view; see
+	 * PrimitiveRenderer::renderCulled. Needs GL 4.3 or ARB_compute_shader.
+	 */
+	cullPrimitives,
+
+	/**
+	 * Contact points, each drawn from per-instance attributes as a cross and
+	 * a normal scaled by its impulse; draw six `GL_LINES` vertices per
+	 * instance. See ContactRenderer.
+	 */
+	contact,
+
+	count
+};
+
+
+/**
+ * Owns b2draw's built-in shader programs and their uniforms.
+ *
+ * Programs are compiled lazily on first use. If a cache directory is given and
+ * the context supports ARB_get_program_binary, linked programs are saved there
+ * and reloaded with `glProgramBinary` on later runs, skipping GLSL
+ * compilation. Cache entries are keyed by the GL vendor, renderer and version
+ * strings and by the shader source, so driver updates invalidate them.
+ *
+ * A ProgramLibrary belongs to a single GL context, which must be current
+ * whenever it is used or destroyed.
+ *
+ * @code
+ * b2draw::ProgramLibrary programs{"/tmp/b2draw-cache"};
+ * b2draw::DebugDraw debugDraw{
+ *     b2draw::ProgramLibrary::s_positionLocation,
+ *     b2draw::ProgramLibrary::s_colourLocation
+ * };
+ * // ...
+ * programs.setMatrix(&mvp[0][0]);
+ * programs.use(b2draw::ProgramKind::plain);
+ * debugDraw.Render();
+ * @endcode
+ */
+class ProgramLibrary
+{
+public:
+	/** Vertex position (vec2) in the plain and palette programs. */
+	static constexpr GLint s_positionLocation = 0;
+
+	/**
+	 * Vertex colour (vec4); per-instance for instanced circles, and constant
+	 * for contacts.
+	 */
+	static constexpr GLint s_colourLocation = 1;
+
+	/** Per-instance circle centre and radius (vec3). */
+	static constexpr GLint s_circleLocation = 2;
+
+	/**
+	 * Per-vertex palette index (float) in the palette program: zero for the
+	 * colour attribute, or `i` for palette entry `i - 1`.
+	 */
+	static constexpr GLint s_paletteIndexLocation = 3;
+
+	/**
+	 * Transform (vec4) from world to scene space in all programs: an offset
+	 * in `xy` and a uniform scale in `w`. When the attribute isn't enabled,
+	 * its default value of (0, 0, 0, 1) is the identity; see
+	 * PrimitiveRenderer::beginGroup.
+	 *
+	 * In programs with per-vertex positions, `z` is the weight given to the
+	 * previous position; see @ref s_previousPositionLocation.
+	 */
+	static constexpr GLint s_worldTransformLocation = 4;
+
+	/**
+	 * Vertex position (vec2) in the previous frame, blended with the current
+	 * position in the plain and palette programs; see
+	 * PrimitiveRenderer::render(GLenum, float32).
+	 */
+	static constexpr GLint s_previousPositionLocation = 5;
+
+	/**
+	 * Point size (float) in the plain and palette programs, scaled by @ref
+	 * setPointScale
+	 * and written to `gl_PointSize`; see PointRenderer.
+	 */
+	static constexpr GLint s_pointSizeLocation = 6;
+
+	/** Per-instance contact point and unit normal (vec4). */
+	static constexpr GLint s_contactLocation = 7;
+
+	/** Per-instance normal impulse (float) at a contact point. */
+	static constexpr GLint s_impulseLocation = 8;
+
+	/**
+	 * Normal length per unit of impulse, and the half-width of the cross
+	 * marking each point (vec2), constant across contacts.
+	 */
+	static constexpr GLint s_contactScaleLocation = 9;
+
+	/** Vertices per instanced circle (float), constant across circles. */
+	static constexpr GLint s_circleSegmentsLocation = 10;
+
+	/** The number of colours in the palette program's uniform palette. */
+	static constexpr std::size_t s_paletteSize = 64u;
+
+	/**
+	 * Create a library.
+	 *
+	 * @param cacheDirectory an existing directory in which to cache program
+	 * binaries, or an empty string to disable caching.
+	 */
+	explicit ProgramLibrary(std::string cacheDirectory = "");
+
+	ProgramLibrary(ProgramLibrary const&) = delete;
+	ProgramLibrary& operator=(ProgramLibrary const&) = delete;
+
+	~ProgramLibrary() noexcept;
+
+	/**
+	 * Get a program, compiling (or loading) it if necessary.
+	 *
+	 * @throws std::runtime_error if compilation or linking fails.
+	 */
+	GLuint program(ProgramKind kind);
+
+	/** Bind a program and bring its uniforms up to date. */
+	void use(ProgramKind kind);
+
+	/** Set the column-major model-view-projection matrix for all programs. */
+	void setMatrix(GLfloat const* pMatrix) noexcept;
+
+	/**
+	 * Set the number of pixels per unit of point size: one, the default, for
+	 * sizes in pixels, or the pixels per metre at the current zoom for sizes
+	 * in metres.
+	 */
+	void setPointScale(GLfloat scale) noexcept;
+
+	inline GLfloat pointScale() const noexcept
+	{ return m_pointScale; }
+
+	/**
+	 * Set the palette program's colours; at most @ref s_paletteSize are
+	 * used. Pass the same colours as to the renderers drawing with it, e.g.
+	 * DebugDraw::GetPalette.
+	 */
+	void setPalette(b2Color const* pColours, std::size_t count) noexcept;
+
+	/** Whether programs are being cached on disk. */
+	inline bool cachesBinaries() const noexcept
+	{ return !m_cacheDirectory.empty(); }
+
+	/** The number of programs loaded from the binary cache. */
+	inline unsigned cacheHits() const noexcept
+	{ return m_cacheHits; }
+
+private:
+	struct Program
+	{
+		GLuint id;
+		GLint matrixLocation;
+		GLint pointScaleLocation;
+		GLint paletteLocation;
+		unsigned dirty;
+	};
+
+	enum DirtyBits : unsigned
+	{
+		e_matrixBit = 0x1,
+		e_pointScaleBit = 0x2,
+		e_paletteBit = 0x4,
+		e_allBits = 0x7
+	};
+
+	void markDirty(unsigned bits) noexcept;
+
+	GLuint loadCachedProgram(std::string const& path) const;
+
+	void saveCachedProgram(GLuint id, std::string const& path) const;
+
+	std::string cachePath(ProgramKind kind) const;
+
+	std::array<Program, static_cast<std::size_t>(ProgramKind::count)>
+		m_programs;
+	std::array<GLfloat, 16> m_matrix;
+	std::array<GLfloat, 4 * s_paletteSize> m_palette;
+	std::string m_cacheDirectory;
+	std::string m_driverKey;
+	GLfloat m_pointScale;
+	unsigned m_cacheHits;
+};
+
+
+} // namespace b2draw
+#endif // #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__PROGRAMLIBRARY__H
@@ -0,0 +1,125 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__RESOURCEPOOL__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__RESOURCEPOOL__H
+#include <vector>
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+
+namespace b2draw {
+
+
+/**
+ * A vertex buffer, its vertex array, and the fence guarding it.
+ *
+ * The element and command buffers are created on demand by renderers using
+ * indexed or indirect submission, and the cull buffer by those culling on the
+ * GPU; all are pooled along with the rest.
+ */
+struct VertexBuffer
+{
+	GLuint vbo;
+	GLuint vao;
+	GLsync fence;
+	GLsizeiptr capacity;
+	GLuint elementBuffer;
+	GLuint commandBuffer;
+	GLuint cullBuffer;
+};
+
+
+/**
+ * A pool of vertex buffers, recycled between PrimitiveRenderers.
+ *
+ * Renderers acquire buffers on their first upload and return them when
+ * destroyed, so short-lived renderers cost no GL object creation once the
+ * pool is warm. Returned buffers keep their storage and any pending fence.
+ *
+ * The pool checks the context's capabilities on first use; from then on the
+ * same GL context must be current whenever the pool is used, as vertex arrays
+ * can't be shared between contexts. Destroying a pool makes no GL calls, so
+ * pooled objects are left to be freed with their context; call @ref clear
+ * while it's current to free them sooner.
+ *
+ * In debug builds, the first use of a pool also installs a KHR_debug message
+ * callback which reports GL errors to `std::cerr`, unless the application
+ * has installed its own.
+ */
+class ResourcePool
+{
+public:
+	ResourcePool() noexcept;
+
+	ResourcePool(ResourcePool const&) = delete;
+	ResourcePool& operator=(ResourcePool const&) = delete;
+
+	~ResourcePool() noexcept;
+
+	/**
+	 * The pool used by renderers which aren't given one explicitly.
+	 *
+	 * Only use it from one GL context. DebugDraw has a pool of its own unless
+	 * given one.
+	 */
+	static ResourcePool& shared() noexcept;
+
+	/**
+	 * Take a vertex buffer from the pool, creating one if the pool is empty.
+	 *
+	 * @throws std::runtime_error if GL objects can't be created.
+	 */
+	VertexBuffer acquire();
+
+	/**
+	 * Create a bare buffer object, for use alongside a vertex buffer.
+	 *
+	 * @throws std::runtime_error if the buffer can't be created.
+	 */
+	GLuint createBuffer();
+
+	/**
+	 * Return a vertex buffer to the pool.
+	 *
+	 * The caller should disable any vertex attributes it enabled, so that the
+	 * next user starts from a clean vertex array. If the pool can't grow to
+	 * hold it, the buffer is deleted instead.
+	 */
+	void release(VertexBuffer const& buffer) noexcept;
+
+	/** Delete all pooled objects. */
+	void clear() noexcept;
+
+	/** The number of idle buffers in the pool. */
+	inline std::size_t size() const noexcept
+	{ return m_buffers.size(); }
+
+	/** Whether the context supports fence sync objects. */
+	inline bool usesFences() noexcept
+	{
+		initialise();
+		return m_useFences;
+	}
+
+	/** Whether buffers are created and edited with direct state access. */
+	inline bool usesDirectStateAccess() noexcept
+	{
+		initialise();
+		return m_useDirectStateAccess;
+	}
+
+private:
+	/** Detect capabilities, once, on first use. */
+	void initialise() noexcept;
+
+	/** Delete a vertex buffer's GL objects. */
+	static void destroy(VertexBuffer const& buffer) noexcept;
+
+	std::vector<VertexBuffer> m_buffers;
+	bool m_initialised;
+	bool m_useFences;
+	bool m_useDirectStateAccess;
+};
+
+
+} // namespace b2draw
+#endif // #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__RESOURCEPOOL__H
@@ -0,0 +1,161 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__SOFTWARERASTERISER__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__SOFTWARERASTERISER__H
+#include <cstdint>
+#include <vector>
+
+#include "b2draw/Frame.h"
+#include "b2draw/WorkerPool.h"
+
+
+namespace b2draw {
+
+
+/**
+ * Draws frames into an RGBA8 image on the CPU, for machines without GL.
+ *
+ * Consumes the same primitives as PrimitiveRenderer: `GL_TRIANGLE_FAN`s are
+ * filled, `GL_LINE_LOOP`s and `GL_LINE_STRIP`s drawn one pixel wide, and
+ * `GL_POINTS` drawn as squares. Each primitive takes the colour of its first
+ * vertex, and is blended as with `glBlendFunc(GL_SRC_ALPHA,
+ * GL_ONE_MINUS_SRC_ALPHA)`, in the order DebugDraw::Render draws it.
+ *
+ * Primitives are binned into square tiles by several threads, then tiles are
+ * filled in parallel, each using edge functions evaluated four pixels at a
+ * time with SSE2 where available. Pixels on edges shared by two polygons are
+ * filled once, so abutting translucent shapes have no seams.
+ *
+ * The image stays valid until the next @ref clear or @ref draw.
+ *
+ * @code
+ * b2draw::SoftwareRasteriser rasteriser{1920, 1080};
+ * rasteriser.setView(lower, upper);
+ * rasteriser.clear();
+ * rasteriser.draw(debugDraw.GetFrame());
+ * save(rasteriser.pixels(), rasteriser.stride(), rasteriser.height());
+ * @endcode
+ */
+class SoftwareRasteriser
+{
+public:
+	/** The width and height of each tile, in pixels. */
+	static constexpr unsigned s_tileSize = 64u;
+
+	/**
+	 * Create a transparent black image, showing one world unit per pixel
+	 * until @ref setView is called.
+	 *
+	 * @param threads the most threads to draw with, or zero for one per
+	 * hardware thread.
+	 * @param workers the threads to draw with, besides the caller's.
+	 * @throws std::runtime_error if either side exceeds 16384 pixels.
+	 */
+	SoftwareRasteriser(
+		unsigned width,
+		unsigned height,
+		unsigned threads = 0u,
+		WorkerPool& workers = WorkerPool::shared()
+	);
+
+	SoftwareRasteriser(SoftwareRasteriser const&) = default;
+	SoftwareRasteriser& operator=(SoftwareRasteriser const&) = default;
+
+	SoftwareRasteriser(SoftwareRasteriser&&) = default;
+	SoftwareRasteriser& operator=(SoftwareRasteriser&&) = default;
+
+	/** Set the world area shown, stretched to fill the image. */
+	void setView(b2Vec2 const& lower, b2Vec2 const& upper) noexcept;
+
+	/** Set the width of points, in pixels; frames don't record sizes. */
+	inline void setPointSize(float32 pixels) noexcept
+	{ m_pointSize = pixels; }
+
+	inline float32 pointSize() const noexcept
+	{ return m_pointSize; }
+
+	/** Fill the image with a colour, ignoring blending. */
+	void clear(b2Color const& colour = b2Color{0.0f, 0.0f, 0.0f, 0.0f});
+
+	/** Draw every section of a frame over the image. */
+	void draw(FrameView const& frame);
+
+	/** Draw primitives in a mode over the image. */
+	void draw(GLenum mode, PrimitiveView const& primitives);
+
+	inline unsigned width() const noexcept
+	{ return m_width; }
+
+	inline unsigned height() const noexcept
+	{ return m_height; }
+
+	/** The distance between rows, in pixels; at least the width. */
+	inline unsigned stride() const noexcept
+	{ return m_stride; }
+
+	/**
+	 * The image, top row first, with each pixel's bytes in R, G, B, A order
+	 * in memory.
+	 */
+	inline std::uint32_t const* pixels() const noexcept
+	{ return m_pixels.data(); }
+
+	inline std::uint32_t pixel(unsigned x, unsigned y) const noexcept
+	{ return m_pixels[y * m_stride + x]; }
+
+	inline unsigned threadCount() const noexcept
+	{ return m_threads; }
+
+private:
+	/** A primitive, with its vertices' offset in @ref m_positions. */
+	struct Primitive
+	{
+		std::uint32_t firstVertex;
+		std::uint32_t vertexCount;
+		GLenum mode;
+		std::uint32_t colour;
+		std::uint32_t alpha;
+	};
+
+	/** A tile's pixel bounds, exclusive at the maximum. */
+	struct Rect
+	{
+		int minX;
+		int minY;
+		int maxX;
+		int maxY;
+	};
+
+	/** Map a world position to pixels, within the guard band. */
+	b2Vec2 toPixels(b2Vec2 const& position) const noexcept;
+
+	/** Transform vertices, and bin primitives to tiles, on each thread. */
+	void bin(FrameView const& frame);
+
+	/** Draw the primitives binned to one tile. */
+	void drawTile(std::size_t tile) noexcept;
+
+	void drawPrimitive(Primitive const& primitive, Rect const& clip) noexcept;
+
+	unsigned m_width;
+	unsigned m_height;
+	unsigned m_stride;
+	unsigned m_tileColumns;
+	unsigned m_tileRows;
+	unsigned m_threads;
+	WorkerPool* m_pWorkers;
+	std::vector<std::uint32_t> m_pixels;
+
+	b2Vec2 m_lower;
+	b2Vec2 m_scale;
+	float32 m_pointSize;
+
+	std::vector<b2Vec2> m_positions;
+	std::vector<Primitive> m_primitives;
+
+	/** Primitive indices per binning worker, then per tile. */
+	std::vector<std::vector<std::uint32_t>> m_bins;
+	std::size_t m_binWorkers;
+};
+
+
+} // namespace b2draw
+#endif // #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__SOFTWARERASTERISER__H
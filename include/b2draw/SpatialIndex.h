@@ -0,0 +1,87 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__SPATIALINDEX__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__SPATIALINDEX__H
+#include <cstdint>
+#include <vector>
+
+#include <Box2D/Common/b2Math.h>
+
+
+namespace b2draw {
+
+
+/**
+ * A uniform grid over axis-aligned boxes, for finding those near a point.
+ *
+ * The grid is rebuilt from scratch by @ref build in three linear passes,
+ * with cells sized to the boxes, and stored as one array of box indices
+ * sorted by cell; rebuilding reuses the previous build's memory, so it's
+ * cheap enough to do every frame.
+ */
+class SpatialIndex
+{
+public:
+	/** A box, from its lower to its upper corner. */
+	struct Bounds
+	{
+		b2Vec2 lower;
+		b2Vec2 upper;
+	};
+
+	SpatialIndex();
+
+	/**
+	 * Index boxes, replacing any indexed before.
+	 *
+	 * Boxes with NaN or infinite corners are never found.
+	 */
+	void build(Bounds const* pBoxes, std::size_t count);
+
+	/**
+	 * Find the boxes overlapping a box.
+	 *
+	 * @param indices appended with each overlapping box's index, once, in
+	 * ascending order.
+	 */
+	void query(
+		Bounds const& bounds,
+		std::vector<std::size_t>& indices
+	) const;
+
+	/** The number of boxes indexed. */
+	inline std::size_t size() const noexcept
+	{ return m_boxes.size(); }
+
+	inline std::size_t cellCount() const noexcept
+	{ return std::size_t(m_columns) * m_rows; }
+
+	inline void clear() noexcept
+	{ build(nullptr, 0u); }
+
+private:
+	/** The cells covered by a box, clamped to the grid and inclusive. */
+	struct CellRange
+	{
+		unsigned minColumn;
+		unsigned minRow;
+		unsigned maxColumn;
+		unsigned maxRow;
+	};
+
+	CellRange cells(Bounds const& bounds) const noexcept;
+
+	std::vector<Bounds> m_boxes;
+	b2Vec2 m_lower;
+	float32 m_inverseCellSize;
+	unsigned m_columns;
+	unsigned m_rows;
+
+	/** Where each cell's entries start, then the entry count. */
+	std::vector<std::uint32_t> m_cellStarts;
+
+	/** Box indices, grouped by cell. */
+	std::vector<std::uint32_t> m_entries;
+};
+
+
+} // namespace b2draw
+#endif // #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__SPATIALINDEX__H
@@ -0,0 +1,123 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__STATICMESH__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__STATICMESH__H
+#include <vector>
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include "b2draw/Frame.h"
+#include "b2draw/ResourcePool.h"
+
+
+namespace b2draw {
+
+
+/**
+ * Geometry which doesn't change, welded into one indexed mesh.
+ *
+ * For level geometry such as tilemaps made of many abutting fixtures, which
+ * a DebugDraw would redraw every frame with each shared corner repeated and
+ * each internal edge outlined twice. Draw it once, e.g. into a DebugDraw
+ * that is never rendered, and build a mesh from that DebugDraw's frame:
+ * - coincident vertices of the same colour, within `epsilon` metres, are
+ *   merged, and primitives are stored as indices into the merged vertices;
+ * - an outline edge shared by exactly two line loops of the same colour is
+ *   internal to the shape they form, so is dropped, as are repeated edges;
+ * - fans become indexed triangles, dropping any that welding collapsed.
+ *
+ * Line loop and line strip sections become lines; triangle fan sections
+ * become triangles. Other sections are ignored.
+ */
+class StaticMesh
+{
+public:
+	/** The default welding distance, just under a millimetre. */
+	static constexpr float32 s_defaultEpsilon = 1.0f / 1024.0f;
+
+	/** What the last @ref build did. */
+	struct Stats
+	{
+		/** Vertices in the source frame. */
+		std::size_t inputVertices{0};
+
+		/** Vertices left after welding. */
+		std::size_t vertices{0};
+
+		/** Line edges drawn. */
+		std::size_t edges{0};
+
+		/** Internal and repeated edges dropped. */
+		std::size_t droppedEdges{0};
+
+		/** Triangles drawn. */
+		std::size_t triangles{0};
+	};
+
+	/** Welded vertices, indexed by line pairs and then by triangles. */
+	struct Geometry
+	{
+		std::vector<Vertex> vertices;
+		std::vector<GLuint> indices;
+
+		/** The indices of lines, before those of triangles. */
+		std::size_t lineIndexCount;
+
+		Stats stats;
+	};
+
+	/**
+	 * Create an empty mesh.
+	 *
+	 * No GL calls are made until the first @ref build, when a vertex buffer
+	 * is taken from @p pool; it is returned on destruction.
+	 */
+	StaticMesh(
+		GLint positionAttribLocation,
+		GLint colourAttribLocation,
+		ResourcePool& pool = ResourcePool::shared()
+	);
+
+	StaticMesh(StaticMesh const&) = delete;
+	StaticMesh& operator=(StaticMesh const&) = delete;
+
+	~StaticMesh() noexcept;
+
+	/**
+	 * Weld a frame's primitives and upload the result, replacing any previous
+	 * contents.
+	 *
+	 * @throws std::runtime_error if GL objects can't be created.
+	 */
+	void build(FrameView const& frame, float32 epsilon = s_defaultEpsilon);
+
+	/** Weld a frame's primitives as @ref build does, without any GL calls. */
+	static Geometry weld(
+		FrameView const& frame,
+		float32 epsilon = s_defaultEpsilon
+	);
+
+	/** Draw the lines, then the triangles, with the bound program. */
+	void render() noexcept;
+
+	inline Stats const& stats() const noexcept
+	{ return m_stats; }
+
+	inline bool empty() const noexcept
+	{ return m_lineIndexCount == 0 && m_triangleIndexCount == 0; }
+
+private:
+	void applyAttribLocations() const noexcept;
+
+	ResourcePool* m_pPool;
+	VertexBuffer m_buffer;
+	bool m_hasBuffer;
+	GLint m_positionLocation;
+	GLint m_colourLocation;
+	GLsizei m_lineIndexCount;
+	GLsizei m_triangleIndexCount;
+	Stats m_stats;
+};
+
+
+} // namespace b2draw
+#endif // #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__STATICMESH__H
@@ -0,0 +1,181 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__TRANSPORT__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__TRANSPORT__H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "b2draw/AsyncFrameSink.h"
+
+
+namespace b2draw {
+
+
+/**
+ * Publishes frames to other processes through a POSIX shared-memory ring.
+ *
+ * Install with DebugDraw::SetFrameSink, and call DebugDraw::Publish each
+ * frame on headless servers. Each frame is serialised straight into the next
+ * of `slotCount` slots, so publishing costs one copy of the frame and never
+ * waits for readers. Frames larger than `slotSize` bytes are dropped.
+ *
+ * Readers use a sequence lock: each slot's sequence number is odd while it's
+ * being written, so readers can detect frames overwritten mid-read. A slot is
+ * only reused after `slotCount - 1` newer frames have been published.
+ *
+ * The segment is unlinked when the publisher is destroyed; readers already
+ * attached keep their mapping.
+ */
+class SharedMemoryPublisher
+	:	public FrameSink
+{
+public:
+	static constexpr std::size_t s_defaultSlotSize = 8u << 20;
+	static constexpr unsigned s_defaultSlotCount = 3u;
+
+	/**
+	 * Create a shared-memory segment.
+	 *
+	 * @param name a POSIX shared-memory name, e.g. "/b2draw".
+	 * @param replace whether to take over an existing segment of the same
+	 * name, e.g. one left behind by a crashed run. Its readers are orphaned,
+	 * so don't replace the segment of a publisher which is still running.
+	 * @throws std::runtime_error if the segment can't be created, including
+	 * if it already exists and @p replace is false.
+	 */
+	explicit SharedMemoryPublisher(
+		std::string const& name,
+		std::size_t slotSize = s_defaultSlotSize,
+		unsigned slotCount = s_defaultSlotCount,
+		bool replace = false
+	);
+
+	SharedMemoryPublisher(SharedMemoryPublisher const&) = delete;
+	SharedMemoryPublisher& operator=(SharedMemoryPublisher const&) = delete;
+
+	virtual ~SharedMemoryPublisher() noexcept override;
+
+	virtual void write(FrameView const& frame) override;
+
+	inline std::uint64_t framesPublished() const noexcept
+	{ return m_framesPublished; }
+
+	inline std::size_t framesDropped() const noexcept
+	{ return m_framesDropped; }
+
+private:
+	std::string m_name;
+	char* m_pData;
+	std::size_t m_size;
+	std::size_t m_slotSize;
+	unsigned m_slotCount;
+	std::uint64_t m_framesPublished;
+	std::size_t m_framesDropped;
+};
+
+
+/**
+ * Views the newest frame in a @ref SharedMemoryPublisher's ring.
+ *
+ * Frames are viewed in place, without copying, so may be overwritten while in
+ * use: check @ref intact after buffering a frame, and before rendering it.
+ */
+class SharedMemorySubscriber
+	:	public FrameSource
+{
+public:
+	/** @throws std::runtime_error if the segment can't be mapped. */
+	explicit SharedMemorySubscriber(std::string const& name);
+
+	SharedMemorySubscriber(SharedMemorySubscriber const&) = delete;
+	SharedMemorySubscriber& operator=(SharedMemorySubscriber const&) = delete;
+
+	virtual ~SharedMemorySubscriber() noexcept override;
+
+	virtual bool poll(FrameView& frame) override;
+	virtual bool intact() const noexcept override;
+
+private:
+	char const* slot(std::uint64_t frameNumber) const noexcept;
+
+	char const* m_pData;
+	std::size_t m_size;
+	std::uint64_t m_framesSeen;
+	std::uint64_t m_frameNumber;
+};
+
+
+/**
+ * Publishes frames over a Unix-domain socket, e.g. for use across containers
+ * which don't share memory.
+ *
+ * Frames are sent to every connected @ref SocketSubscriber on a background
+ * thread, so slow readers cost the publisher dropped frames rather than time.
+ * Readers which stop reading for a second are disconnected.
+ */
+class SocketPublisher
+	:	public AsyncFrameSink
+{
+public:
+	/**
+	 * Listen on a socket, replacing any existing file at @p path.
+	 *
+	 * @throws std::runtime_error if the socket can't be created.
+	 */
+	explicit SocketPublisher(
+		std::string const& path,
+		std::size_t maxQueuedFrames = 2u
+	);
+
+	SocketPublisher(SocketPublisher const&) = delete;
+	SocketPublisher& operator=(SocketPublisher const&) = delete;
+
+	virtual ~SocketPublisher() noexcept override;
+
+protected:
+	virtual bool consume(void const* pRecord, std::size_t size) override;
+
+private:
+	std::string m_path;
+	int m_listener;
+
+	// Only touched by the background thread.
+	std::vector<int> m_clients;
+};
+
+
+/** Receives frames from a @ref SocketPublisher. */
+class SocketSubscriber
+	:	public FrameSource
+{
+public:
+	/** @throws std::runtime_error if the socket can't be connected. */
+	explicit SocketSubscriber(std::string const& path);
+
+	SocketSubscriber(SocketSubscriber const&) = delete;
+	SocketSubscriber& operator=(SocketSubscriber const&) = delete;
+
+	virtual ~SocketSubscriber() noexcept override;
+
+	/**
+	 * Read whatever has arrived, and return the newest complete frame.
+	 *
+	 * Frames which arrived since the last call but were superseded are
+	 * skipped.
+	 *
+	 * @throws std::runtime_error if the stream is corrupt.
+	 */
+	virtual bool poll(FrameView& frame) override;
+
+	/** Whether the publisher is still connected. */
+	inline bool connected() const noexcept
+	{ return m_socket >= 0; }
+
+private:
+	int m_socket;
+	std::vector<char> m_incoming;
+	std::vector<std::uint64_t> m_record;
+};
+
+
+} // namespace b2draw
+#endif // #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__TRANSPORT__H
@@ -0,0 +1,127 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__WORKERPOOL__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__WORKERPOOL__H
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace b2draw {
+
+
+/**
+ * Threads kept between calls to @ref parallelFor, so that splitting work
+ * costs a wake-up rather than creating and joining a thread per slice.
+ *
+ * Threads are started on demand, up to a limit, and sleep between jobs. Jobs
+ * from several threads run one at a time, so don't call @ref parallelFor from
+ * within a job.
+ */
+class WorkerPool
+{
+public:
+	/**
+	 * Create a pool without starting any threads.
+	 *
+	 * @param maxThreads the most threads to start, besides the caller's, or
+	 * zero for one fewer than the hardware has.
+	 */
+	explicit WorkerPool(unsigned maxThreads = 0u);
+
+	WorkerPool(WorkerPool const&) = delete;
+	WorkerPool& operator=(WorkerPool const&) = delete;
+
+	/** Wake and join every thread. */
+	~WorkerPool() noexcept;
+
+	/** The pool used by DensityGrid and SoftwareRasteriser by default. */
+	static WorkerPool& shared() noexcept;
+
+	/**
+	 * Split `[0, itemCount)` into @p workers slices, and call
+	 * `function(begin, end, worker)` once for each, with `worker` the slice's
+	 * index. Slices are shared between the calling thread and the pool's,
+	 * and all have been run when this returns.
+	 *
+	 * @throws the first exception thrown by @p function, once all slices
+	 * have been run.
+	 */
+	template <typename Function>
+	void parallelFor(
+		std::size_t itemCount,
+		std::size_t workers,
+		Function const& function
+	)
+	{
+		run(
+			itemCount,
+			workers,
+			[](
+				void const* const pFunction,
+				std::size_t const begin,
+				std::size_t const end,
+				std::size_t const worker
+			) {
+				(*static_cast<Function const*>(pFunction))(begin, end, worker);
+			},
+			&function
+		);
+	}
+
+	/** The number of threads started so far, besides callers'. */
+	std::size_t threadCount() const;
+
+private:
+	using Task = void (*)(
+		void const* pFunction,
+		std::size_t begin,
+		std::size_t end,
+		std::size_t worker);
+
+	void run(
+		std::size_t itemCount,
+		std::size_t workers,
+		Task task,
+		void const* pFunction
+	);
+
+	/** Start threads, as far as possible, until there are @p count. */
+	void grow(std::size_t count) noexcept;
+
+	/** Run slices of the current job until none are left. */
+	void work() noexcept;
+
+	void loop(std::size_t index, std::uint64_t generation) noexcept;
+
+	std::size_t m_maxThreads;
+	std::vector<std::thread> m_threads;
+
+	/** Held for the whole of a job, so that jobs run one at a time. */
+	std::mutex m_jobMutex;
+
+	/** Guards the fields below, except the slice counter. */
+	mutable std::mutex m_mutex;
+	std::condition_variable m_start;
+	std::condition_variable m_done;
+	std::uint64_t m_generation;
+	bool m_stopping;
+
+	Task m_task;
+	void const* m_pFunction;
+	std::size_t m_itemCount;
+	std::size_t m_sliceSize;
+	std::size_t m_sliceCount;
+	std::atomic<std::size_t> m_nextSlice;
+
+	/** The threads taking part in the current job, and those yet to finish. */
+	std::size_t m_helpers;
+	std::size_t m_pending;
+	std::exception_ptr m_pError;
+};
+
+
+} // namespace b2draw
+#endif // #ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__WORKERPOOL__H
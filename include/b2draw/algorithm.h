@@ -1,6 +1,8 @@
 #ifndef HEADER_INCLUDE__RECURSION__ALGORITHM__CHEBYSHEV_SEGMENTS__H
 #define HEADER_INCLUDE__RECURSION__ALGORITHM__CHEBYSHEV_SEGMENTS__H
+#include <algorithm>
 #include <cmath>
+#include <thread>
 
 
 namespace b2draw {
@@ -143,6 +145,24 @@ chebyshevSegments(
 }
 
 
+/**
+ * Choose how many threads to split work between, giving each at least
+ * @p minItemsPerWorker items and using no more threads than the hardware has.
+ */
+inline std::size_t
+workerCount(
+	std::size_t const itemCount,
+	std::size_t const minItemsPerWorker
+) noexcept
+{
+	std::size_t const hardware{
+		std::max(std::thread::hardware_concurrency(), 1u)};
+	std::size_t const useful{
+		itemCount / std::max<std::size_t>(minItemsPerWorker, 1u)};
+	return std::max<std::size_t>(std::min(hardware, useful), 1u);
+}
+
+
 } // namespace algorithm
 } // namespace b2draw
 #endif // #ifndef HEADER_INCLUDE__RECURSION__ALGORITHM__CHEBYSHEV_SEGMENTS__H
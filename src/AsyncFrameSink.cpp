@@ -0,0 +1,128 @@
+#include <algorithm>
+
+#include "b2draw/AsyncFrameSink.h"
+
+
+namespace b2draw {
+
+
+AsyncFrameSink::AsyncFrameSink(std::size_t const maxQueuedFrames)
+	:	m_mutex{}
+	,	m_condition{}
+	,	m_queue{}
+	,	m_spareRecords{}
+	,	m_maxQueuedFrames{std::max<std::size_t>(maxQueuedFrames, 1u)}
+	,	m_stopping{false}
+	,	m_failed{false}
+	,	m_framesWritten{0u}
+	,	m_framesDropped{0u}
+	,	m_thread{}
+{
+}
+
+
+AsyncFrameSink::~AsyncFrameSink() noexcept
+{
+	stop();
+}
+
+
+void
+AsyncFrameSink::start()
+{
+	m_thread = std::thread{&AsyncFrameSink::run, this};
+}
+
+
+void
+AsyncFrameSink::stop() noexcept
+{
+	if (!m_thread.joinable()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		m_stopping = true;
+	}
+	m_condition.notify_one();
+	m_thread.join();
+}
+
+
+void
+AsyncFrameSink::write(FrameView const& frame)
+{
+	Record record;
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		if (m_stopping || m_queue.size() >= m_maxQueuedFrames)
+		{
+			++m_framesDropped;
+			return;
+		}
+		if (!m_spareRecords.empty())
+		{
+			record = std::move(m_spareRecords.back());
+			m_spareRecords.pop_back();
+		}
+	}
+
+	// Serialise outside the lock; this is the only copy of the frame made on
+	// the calling thread.
+	auto const size = frameRecordSize(frame);
+	record.resize(size / sizeof(std::uint64_t));
+	writeFrameRecord(frame, record.data());
+
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		m_queue.push_back(std::move(record));
+	}
+	m_condition.notify_one();
+}
+
+
+void
+AsyncFrameSink::run() noexcept
+{
+	std::unique_lock<std::mutex> lock{m_mutex};
+	while (true)
+	{
+		m_condition.wait(lock, [this] {
+			return m_stopping || !m_queue.empty();
+		});
+		if (m_queue.empty()) {
+			return;
+		}
+
+		auto record = std::move(m_queue.front());
+		m_queue.pop_front();
+		bool const failed{m_failed};
+		lock.unlock();
+
+		bool consumed{false};
+		if (!failed)
+		{
+			try
+			{
+				consumed = consume(
+					record.data(), record.size() * sizeof(std::uint64_t));
+			}
+			catch (...)
+			{
+			}
+		}
+
+		lock.lock();
+		if (consumed) {
+			++m_framesWritten;
+		}
+		else {
+			m_failed = true;
+		}
+		m_spareRecords.push_back(std::move(record));
+	}
+}
+
+
+} // namespace b2draw
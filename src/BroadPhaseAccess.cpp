@@ -0,0 +1,88 @@
+#include <stdexcept>
+
+#include <Box2D/Common/b2Settings.h>
+
+#include "BroadPhaseAccess.h"
+
+
+// The members named below are private, and their names and types are only
+// known for Box2D 2.3; CMake passes the version it found.
+#if defined(b2draw_BOX2D_VERSION_MAJOR) && defined(b2draw_BOX2D_VERSION_MINOR)
+static_assert(
+	b2draw_BOX2D_VERSION_MAJOR == 2 && b2draw_BOX2D_VERSION_MINOR == 3,
+	"Broad-phase access relies on the private members of Box2D 2.3"
+);
+#endif
+
+
+namespace b2draw {
+namespace {
+
+
+/**
+ * Box2D keeps the broad-phase tree private, with no way to walk its nodes.
+ * Explicit instantiations may name private members, so instantiating Expose
+ * with a pointer to one defines a friend `get` returning it. A member whose
+ * type has changed fails to compile here.
+ */
+template <typename Member, typename Member::Type pointer>
+struct Expose
+{
+	friend typename Member::Type get(Member) noexcept
+	{
+		return pointer;
+	}
+};
+
+struct BroadPhaseTree
+{
+	using Type = b2DynamicTree b2BroadPhase::*;
+	friend Type get(BroadPhaseTree) noexcept;
+};
+
+struct TreeRoot
+{
+	using Type = int32 b2DynamicTree::*;
+	friend Type get(TreeRoot) noexcept;
+};
+
+struct TreeNodes
+{
+	using Type = b2TreeNode* b2DynamicTree::*;
+	friend Type get(TreeNodes) noexcept;
+};
+
+template struct Expose<BroadPhaseTree, &b2BroadPhase::m_tree>;
+template struct Expose<TreeRoot, &b2DynamicTree::m_root>;
+template struct Expose<TreeNodes, &b2DynamicTree::m_nodes>;
+
+
+} // namespace
+
+
+b2DynamicTree const&
+broadPhaseTree(b2BroadPhase const& broadPhase)
+{
+	// The headers may match while the library linked doesn't.
+	if (b2_version.major != 2 || b2_version.minor != 3) {
+		throw std::runtime_error{"Broad-phase access needs Box2D 2.3"};
+	}
+	return broadPhase.*get(BroadPhaseTree{});
+}
+
+
+int32
+treeRoot(b2DynamicTree const& tree) noexcept
+{
+	return tree.*get(TreeRoot{});
+}
+
+
+b2TreeNode const*
+treeNodes(b2DynamicTree const& tree) noexcept
+{
+	return tree.*get(TreeNodes{});
+}
+
+
+} // namespace b2draw
@@ -0,0 +1,28 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__BROADPHASEACCESS__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__BROADPHASEACCESS__H
+#include <Box2D/Collision/b2BroadPhase.h>
+#include <Box2D/Collision/b2DynamicTree.h>
+
+
+namespace b2draw {
+
+
+/**
+ * Read-only access to the nodes of the broad-phase tree, which Box2D keeps
+ * private. This relies on the private members of Box2D 2.3.
+ *
+ * @throws std::runtime_error if the Box2D library linked isn't version 2.3.
+ */
+b2DynamicTree const& broadPhaseTree(b2BroadPhase const& broadPhase);
+
+/** The index of the root node of @p tree, or `b2_nullNode`. */
+int32 treeRoot(b2DynamicTree const& tree) noexcept;
+
+/** The nodes of @p tree, indexed by node. */
+b2TreeNode const* treeNodes(b2DynamicTree const& tree) noexcept;
+
+
+} // namespace b2draw
+
+
+#endif
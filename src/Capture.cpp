@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "b2draw/Capture.h"
+
+
+namespace b2draw {
+namespace {
+
+
+constexpr std::uint32_t fileMagic = 0x43443242u; // "B2DC"
+constexpr std::uint32_t footerMagic = 0x49443242u; // "B2DI"
+constexpr std::uint32_t fileVersion = 1u;
+
+
+struct FileHeader
+{
+	std::uint32_t magic;
+	std::uint32_t version;
+	std::uint64_t reserved;
+};
+
+
+struct FileFooter
+{
+	std::uint64_t frameOffsetsOffset;
+	std::uint64_t frameCount;
+	std::uint32_t magic;
+	std::uint32_t version;
+};
+
+
+} // namespace
+
+
+CaptureWriter::CaptureWriter(
+	std::string const& path,
+	std::size_t const maxQueuedFrames
+)
+	:	AsyncFrameSink{maxQueuedFrames}
+	,	m_pFile{std::fopen(path.c_str(), "wb")}
+	,	m_frameOffsets{}
+	,	m_offset{sizeof(FileHeader)}
+{
+	if (!m_pFile) {
+		throw std::runtime_error{"Unable to open capture file " + path};
+	}
+
+	FileHeader const header{fileMagic, fileVersion, 0u};
+	if (std::fwrite(&header, sizeof(header), 1, m_pFile) != 1)
+	{
+		std::fclose(m_pFile);
+		throw std::runtime_error{"Unable to write capture file " + path};
+	}
+
+	start();
+}
+
+
+CaptureWriter::~CaptureWriter() noexcept
+{
+	try
+	{
+		close();
+	}
+	catch (...)
+	{
+	}
+}
+
+
+bool
+CaptureWriter::consume(void const* const pRecord, std::size_t const size)
+{
+	if (std::fwrite(pRecord, size, 1, m_pFile) != 1) {
+		return false;
+	}
+	m_frameOffsets.push_back(m_offset);
+	m_offset += size;
+	return true;
+}
+
+
+void
+CaptureWriter::close()
+{
+	if (!m_pFile) {
+		return;
+	}
+	stop();
+
+	FileFooter const footer{
+		m_offset, m_frameOffsets.size(), footerMagic, fileVersion};
+	bool ok{!failed()};
+	ok = ok && std::fwrite(
+		m_frameOffsets.data(),
+		sizeof(std::uint64_t),
+		m_frameOffsets.size(),
+		m_pFile
+	) == m_frameOffsets.size();
+	ok = ok && std::fwrite(&footer, sizeof(footer), 1, m_pFile) == 1;
+	ok = (std::fclose(m_pFile) == 0) && ok;
+	m_pFile = nullptr;
+
+	if (!ok) {
+		throw std::runtime_error{"Failed to write capture file"};
+	}
+}
+
+
+CaptureReader::CaptureReader(std::string const& path)
+	:	m_pData{nullptr}
+	,	m_size{0u}
+	,	m_pFrameOffsets{nullptr}
+	,	m_scannedOffsets{}
+	,	m_frameCount{0u}
+{
+	int const fd{::open(path.c_str(), O_RDONLY)};
+	if (fd < 0) {
+		throw std::runtime_error{"Unable to open capture file " + path};
+	}
+
+	struct stat status;
+	if (::fstat(fd, &status) != 0 || std::size_t(status.st_size) <
+		sizeof(FileHeader))
+	{
+		::close(fd);
+		throw std::runtime_error{"Invalid capture file " + path};
+	}
+	m_size = status.st_size;
+
+	void* const pMapping{
+		::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0)};
+	::close(fd);
+	if (pMapping == MAP_FAILED) {
+		throw std::runtime_error{"Unable to map capture file " + path};
+	}
+	m_pData = static_cast<char const*>(pMapping);
+
+	auto const pHeader = reinterpret_cast<FileHeader const*>(m_pData);
+	if (pHeader->magic != fileMagic || pHeader->version != fileVersion)
+	{
+		::munmap(pMapping, m_size);
+		throw std::runtime_error{"Invalid capture file " + path};
+	}
+
+	// Use the footer's frame table if the file was closed cleanly.
+	if (m_size >= sizeof(FileHeader) + sizeof(FileFooter))
+	{
+		auto const pFooter = reinterpret_cast<FileFooter const*>(
+			m_pData + m_size - sizeof(FileFooter));
+		auto const tableEnd = pFooter->frameOffsetsOffset +
+			pFooter->frameCount * sizeof(std::uint64_t);
+		if (
+			pFooter->magic == footerMagic &&
+			pFooter->version == fileVersion &&
+			tableEnd == m_size - sizeof(FileFooter)
+		)
+		{
+			m_pFrameOffsets = reinterpret_cast<std::uint64_t const*>(
+				m_pData + pFooter->frameOffsetsOffset);
+			m_frameCount = pFooter->frameCount;
+			return;
+		}
+	}
+
+	scanFrames();
+}
+
+
+CaptureReader::~CaptureReader() noexcept
+{
+	::munmap(const_cast<char*>(m_pData), m_size);
+}
+
+
+void
+CaptureReader::scanFrames()
+{
+	std::size_t offset{sizeof(FileHeader)};
+	FrameView frame;
+	while (readFrameRecord(m_pData + offset, m_size - offset, frame))
+	{
+		m_scannedOffsets.push_back(offset);
+		offset += frameRecordSize(frame);
+	}
+	m_pFrameOffsets = m_scannedOffsets.data();
+	m_frameCount = m_scannedOffsets.size();
+}
+
+
+FrameView
+CaptureReader::frame(std::size_t const index) const
+{
+	if (index >= m_frameCount) {
+		throw std::out_of_range{"Capture frame index out of range"};
+	}
+
+	auto const offset = m_pFrameOffsets[index];
+	FrameView frame;
+	if (
+		offset >= m_size ||
+		!readFrameRecord(m_pData + offset, m_size - offset, frame)
+	)
+	{
+		throw std::runtime_error{"Corrupt capture frame"};
+	}
+	return frame;
+}
+
+
+} // namespace b2draw
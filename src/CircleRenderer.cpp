@@ -0,0 +1,177 @@
+#include <cstddef>
+#include <utility>
+
+#include "b2draw/CircleRenderer.h"
+
+
+namespace b2draw {
+
+
+static_assert(
+	offsetof(CircleRenderer::Circle, radius) == sizeof(b2Vec2),
+	"The centre and radius are read as one vec3");
+
+
+CircleRenderer::CircleRenderer(
+	GLint const circleAttribLocation,
+	GLint const colourAttribLocation,
+	GLint const segmentsAttribLocation,
+	unsigned const numSegments,
+	ResourcePool& pool
+)
+	:	m_circles{}
+	,	m_pPool{&pool}
+	,	m_buffer{0u, 0u, nullptr, 0, 0u, 0u, 0u}
+	,	m_hasBuffer{false}
+	,	m_bufferedCount{0}
+	,	m_numSegments{numSegments < 3u ? 3u : numSegments}
+	,	m_circleLocation{circleAttribLocation}
+	,	m_colourLocation{colourAttribLocation}
+	,	m_segmentsLocation{segmentsAttribLocation}
+	,	m_enabledLocations{{-1, -1}}
+{
+}
+
+
+CircleRenderer::CircleRenderer(CircleRenderer&& other) noexcept
+	:	m_circles{std::move(other.m_circles)}
+	,	m_pPool{other.m_pPool}
+	,	m_buffer{other.m_buffer}
+	,	m_hasBuffer{other.m_hasBuffer}
+	,	m_bufferedCount{other.m_bufferedCount}
+	,	m_numSegments{other.m_numSegments}
+	,	m_circleLocation{other.m_circleLocation}
+	,	m_colourLocation{other.m_colourLocation}
+	,	m_segmentsLocation{other.m_segmentsLocation}
+	,	m_enabledLocations(other.m_enabledLocations)
+{
+	other.m_hasBuffer = false;
+}
+
+
+CircleRenderer&
+CircleRenderer::operator=(CircleRenderer&& other) noexcept
+{
+	if (this != &other)
+	{
+		releaseBuffer();
+		m_circles = std::move(other.m_circles);
+		m_pPool = other.m_pPool;
+		m_buffer = other.m_buffer;
+		m_hasBuffer = other.m_hasBuffer;
+		m_bufferedCount = other.m_bufferedCount;
+		m_numSegments = other.m_numSegments;
+		m_circleLocation = other.m_circleLocation;
+		m_colourLocation = other.m_colourLocation;
+		m_segmentsLocation = other.m_segmentsLocation;
+		m_enabledLocations = other.m_enabledLocations;
+		other.m_hasBuffer = false;
+	}
+	return *this;
+}
+
+
+CircleRenderer::~CircleRenderer() noexcept
+{
+	releaseBuffer();
+}
+
+
+void
+CircleRenderer::releaseBuffer() noexcept
+{
+	if (!m_hasBuffer) {
+		return;
+	}
+
+	// Leave the vertex array as the pool expects: nothing enabled, and
+	// nothing per-instance.
+	glBindVertexArray(m_buffer.vao);
+	for (auto const location: m_enabledLocations)
+	{
+		if (location >= 0)
+		{
+			glVertexAttribDivisor(location, 0u);
+			glDisableVertexAttribArray(location);
+		}
+	}
+	m_enabledLocations.fill(-1);
+	m_pPool->release(m_buffer);
+	m_hasBuffer = false;
+}
+
+
+void
+CircleRenderer::bufferData()
+{
+	m_bufferedCount = GLsizei(m_circles.size());
+	if (!m_bufferedCount) {
+		return;
+	}
+
+	if (!m_hasBuffer)
+	{
+		m_buffer = m_pPool->acquire();
+		m_hasBuffer = true;
+	}
+
+	// Orphan the old storage rather than wait for the GPU to finish with it.
+	auto const bytes = m_circles.size() * sizeof(Circle);
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer.vbo);
+	glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, m_circles.data());
+	m_buffer.capacity = bytes;
+	applyAttribLocations();
+}
+
+
+void
+CircleRenderer::render(GLenum const mode) noexcept
+{
+	if (!m_hasBuffer || !m_bufferedCount) {
+		return;
+	}
+
+	glBindVertexArray(m_buffer.vao);
+	if (m_segmentsLocation >= 0) {
+		glVertexAttrib1f(m_segmentsLocation, GLfloat(m_numSegments));
+	}
+	glDrawArraysInstanced(mode, 0, GLsizei(m_numSegments), m_bufferedCount);
+}
+
+
+void
+CircleRenderer::applyAttribLocations() noexcept
+{
+	glBindVertexArray(m_buffer.vao);
+	for (auto const location: m_enabledLocations)
+	{
+		if (location >= 0)
+		{
+			glVertexAttribDivisor(location, 0u);
+			glDisableVertexAttribArray(location);
+		}
+	}
+
+	if (m_circleLocation >= 0)
+	{
+		glEnableVertexAttribArray(m_circleLocation);
+		glVertexAttribPointer(
+			m_circleLocation, 3, GL_FLOAT, GL_FALSE, sizeof(Circle), nullptr);
+		glVertexAttribDivisor(m_circleLocation, 1u);
+	}
+
+	if (m_colourLocation >= 0)
+	{
+		glEnableVertexAttribArray(m_colourLocation);
+		glVertexAttribPointer(
+			m_colourLocation, 4, GL_FLOAT, GL_FALSE, sizeof(Circle),
+			reinterpret_cast<void const*>(offsetof(Circle, colour)));
+		glVertexAttribDivisor(m_colourLocation, 1u);
+	}
+
+	m_enabledLocations = {{m_circleLocation, m_colourLocation}};
+}
+
+
+} // namespace b2draw
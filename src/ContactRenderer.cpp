@@ -0,0 +1,191 @@
+#include <cstddef>
+#include <utility>
+
+#include "b2draw/ContactRenderer.h"
+
+
+namespace b2draw {
+
+
+static_assert(
+	offsetof(ContactRenderer::Contact, normal) == sizeof(b2Vec2),
+	"The point and normal are read as one vec4");
+
+
+ContactRenderer::ContactRenderer(
+	GLint const contactAttribLocation,
+	GLint const impulseAttribLocation,
+	GLint const colourAttribLocation,
+	GLint const scaleAttribLocation,
+	ResourcePool& pool
+)
+	:	m_contacts{}
+	,	m_pPool{&pool}
+	,	m_buffer{0u, 0u, nullptr, 0, 0u, 0u, 0u}
+	,	m_hasBuffer{false}
+	,	m_bufferedCount{0}
+	,	m_colour{1.0f, 0.3f, 0.1f, 1.0f}
+	,	m_lengthPerImpulse{0.1f}
+	,	m_crossSize{0.1f}
+	,	m_contactLocation{contactAttribLocation}
+	,	m_impulseLocation{impulseAttribLocation}
+	,	m_colourLocation{colourAttribLocation}
+	,	m_scaleLocation{scaleAttribLocation}
+	,	m_enabledLocations{{-1, -1}}
+{
+}
+
+
+ContactRenderer::ContactRenderer(ContactRenderer&& other) noexcept
+	:	m_contacts{std::move(other.m_contacts)}
+	,	m_pPool{other.m_pPool}
+	,	m_buffer{other.m_buffer}
+	,	m_hasBuffer{other.m_hasBuffer}
+	,	m_bufferedCount{other.m_bufferedCount}
+	,	m_colour{other.m_colour}
+	,	m_lengthPerImpulse{other.m_lengthPerImpulse}
+	,	m_crossSize{other.m_crossSize}
+	,	m_contactLocation{other.m_contactLocation}
+	,	m_impulseLocation{other.m_impulseLocation}
+	,	m_colourLocation{other.m_colourLocation}
+	,	m_scaleLocation{other.m_scaleLocation}
+	,	m_enabledLocations(other.m_enabledLocations)
+{
+	other.m_hasBuffer = false;
+}
+
+
+ContactRenderer&
+ContactRenderer::operator=(ContactRenderer&& other) noexcept
+{
+	if (this != &other)
+	{
+		releaseBuffer();
+		m_contacts = std::move(other.m_contacts);
+		m_pPool = other.m_pPool;
+		m_buffer = other.m_buffer;
+		m_hasBuffer = other.m_hasBuffer;
+		m_bufferedCount = other.m_bufferedCount;
+		m_colour = other.m_colour;
+		m_lengthPerImpulse = other.m_lengthPerImpulse;
+		m_crossSize = other.m_crossSize;
+		m_contactLocation = other.m_contactLocation;
+		m_impulseLocation = other.m_impulseLocation;
+		m_colourLocation = other.m_colourLocation;
+		m_scaleLocation = other.m_scaleLocation;
+		m_enabledLocations = other.m_enabledLocations;
+		other.m_hasBuffer = false;
+	}
+	return *this;
+}
+
+
+ContactRenderer::~ContactRenderer() noexcept
+{
+	releaseBuffer();
+}
+
+
+void
+ContactRenderer::releaseBuffer() noexcept
+{
+	if (!m_hasBuffer) {
+		return;
+	}
+
+	// Leave the vertex array as the pool expects: nothing enabled, and
+	// nothing per-instance.
+	glBindVertexArray(m_buffer.vao);
+	for (auto const location: m_enabledLocations)
+	{
+		if (location >= 0)
+		{
+			glVertexAttribDivisor(location, 0u);
+			glDisableVertexAttribArray(location);
+		}
+	}
+	m_enabledLocations.fill(-1);
+	m_pPool->release(m_buffer);
+	m_hasBuffer = false;
+}
+
+
+void
+ContactRenderer::bufferData()
+{
+	m_bufferedCount = GLsizei(m_contacts.size());
+	if (!m_bufferedCount) {
+		return;
+	}
+
+	if (!m_hasBuffer)
+	{
+		m_buffer = m_pPool->acquire();
+		m_hasBuffer = true;
+	}
+
+	// Orphan the old storage rather than wait for the GPU to finish with it.
+	auto const bytes = m_contacts.size() * sizeof(Contact);
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer.vbo);
+	glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, m_contacts.data());
+	m_buffer.capacity = bytes;
+	applyAttribLocations();
+}
+
+
+void
+ContactRenderer::render() noexcept
+{
+	if (!m_hasBuffer || !m_bufferedCount) {
+		return;
+	}
+
+	glBindVertexArray(m_buffer.vao);
+	if (m_colourLocation >= 0) {
+		glVertexAttrib4f(
+			m_colourLocation, m_colour.r, m_colour.g, m_colour.b, m_colour.a);
+	}
+	if (m_scaleLocation >= 0) {
+		glVertexAttrib2f(m_scaleLocation, m_lengthPerImpulse, m_crossSize);
+	}
+	glDrawArraysInstanced(GL_LINES, 0, 6, m_bufferedCount);
+}
+
+
+void
+ContactRenderer::applyAttribLocations() noexcept
+{
+	glBindVertexArray(m_buffer.vao);
+	for (auto const location: m_enabledLocations)
+	{
+		if (location >= 0)
+		{
+			glVertexAttribDivisor(location, 0u);
+			glDisableVertexAttribArray(location);
+		}
+	}
+
+	if (m_contactLocation >= 0)
+	{
+		glEnableVertexAttribArray(m_contactLocation);
+		glVertexAttribPointer(
+			m_contactLocation, 4, GL_FLOAT, GL_FALSE, sizeof(Contact),
+			nullptr);
+		glVertexAttribDivisor(m_contactLocation, 1u);
+	}
+
+	if (m_impulseLocation >= 0)
+	{
+		glEnableVertexAttribArray(m_impulseLocation);
+		glVertexAttribPointer(
+			m_impulseLocation, 1, GL_FLOAT, GL_FALSE, sizeof(Contact),
+			reinterpret_cast<void const*>(offsetof(Contact, impulse)));
+		glVertexAttribDivisor(m_impulseLocation, 1u);
+	}
+
+	m_enabledLocations = {{m_contactLocation, m_impulseLocation}};
+}
+
+
+} // namespace b2draw
@@ -1,12 +1,98 @@
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <stdexcept>
 
+#include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Dynamics/b2ContactManager.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Dynamics/b2WorldCallbacks.h>
 
 #include "b2draw/algorithm.h"
 #include "b2draw/DebugDraw.h"
+#include "BroadPhaseAccess.h"
+#include "ShapeDrawing.h"
 
 
 namespace b2draw {
+namespace {
+
+
+/** Circles with fewer segments than this are never thinned out. */
+constexpr std::size_t minThinnedCircleSegments{12u};
+
+
+/** The flag drawn into each of DebugDraw's retained layers, in order. */
+constexpr uint32 retainedFlags[] = {
+	b2Draw::e_jointBit,
+	b2Draw::e_aabbBit,
+	b2Draw::e_pairBit,
+	b2Draw::e_centerOfMassBit
+};
+
+
+inline bool
+hasColour(
+	b2Color const& colour,
+	float32 const r,
+	float32 const g,
+	float32 const b
+) noexcept
+{
+	return colour.r == r && colour.g == g && colour.b == b;
+}
+
+
+/**
+ * The fixed colours Box2D draws with: each body state's colour as outlined
+ * and as filled, then joints, pairs, AABBs, the transform axes and the
+ * solid circles' black axis.
+ */
+std::vector<b2Color>
+box2dPalette(float32 const fillAlpha)
+{
+	b2Color const bodyColours[] = {
+		b2Color{0.5f, 0.5f, 0.3f}, // Inactive.
+		b2Color{0.5f, 0.9f, 0.5f}, // Static.
+		b2Color{0.5f, 0.5f, 0.9f}, // Kinematic.
+		b2Color{0.6f, 0.6f, 0.6f}, // Asleep.
+		b2Color{0.9f, 0.7f, 0.7f}
+	};
+
+	std::vector<b2Color> palette{};
+	for (auto const& colour: bodyColours)
+	{
+		palette.push_back(colour);
+		palette.push_back(b2Color{colour.r, colour.g, colour.b, fillAlpha});
+	}
+	palette.push_back(b2Color{0.5f, 0.8f, 0.8f});
+	palette.push_back(b2Color{0.3f, 0.9f, 0.9f});
+	palette.push_back(b2Color{0.9f, 0.3f, 0.9f});
+	palette.push_back(b2Color{1.0f, 0.0f, 0.0f});
+	palette.push_back(b2Color{0.0f, 1.0f, 0.0f});
+	palette.push_back(b2Color{0.0f, 0.0f, 0.0f, 1.0f});
+	return palette;
+}
+
+
+/** A hue from blue at depth zero to red at @p maxDepth. */
+b2Color
+depthColour(unsigned const depth, unsigned const maxDepth) noexcept
+{
+	float32 const t{
+		maxDepth ? std::min(float32(depth) / maxDepth, 1.0f) : 0.0f};
+	float32 const hue{4.0f * (1.0f - t)}; // In sixths of a turn.
+	auto const channel = [hue](float32 const n) {
+		float32 const k{std::fmod(n + hue, 6.0f)};
+		return 1.0f - std::max(std::min({k, 4.0f - k, 1.0f}), 0.0f);
+	};
+	return b2Color{channel(5.0f), channel(3.0f), channel(1.0f)};
+}
+
+
+} // namespace
 
 
 DebugDraw::DebugDraw(
@@ -14,19 +100,178 @@ DebugDraw::DebugDraw(
 	GLint colourAttribLoc,
 	unsigned numCircleSegments,
 	float32 fillAlpha,
-	float32 axisScale
+	float32 axisScale,
+	unsigned numBuffers,
+	Arena* pArena,
+	ResourcePool* pPool
 )
-	:	m_lineRenderer{positionAttribLoc, colourAttribLoc, numCircleSegments}
-	,	m_fillRenderer{positionAttribLoc, colourAttribLoc, numCircleSegments}
+	:	m_pool{pPool}
+	,	m_lineRenderer{
+			positionAttribLoc,
+			colourAttribLoc,
+			numCircleSegments,
+			numBuffers,
+			*m_pool.pPool,
+			pArena}
+	,	m_fillRenderer{
+			positionAttribLoc,
+			colourAttribLoc,
+			numCircleSegments,
+			numBuffers,
+			*m_pool.pPool,
+			pArena}
+	,	m_segmentRenderer{
+			positionAttribLoc,
+			colourAttribLoc,
+			numCircleSegments,
+			numBuffers,
+			*m_pool.pPool,
+			pArena}
+	,	m_pointRenderer{positionAttribLoc, colourAttribLoc, -1, *m_pool.pPool}
+	,	m_contactRenderer{
+			ProgramLibrary::s_contactLocation,
+			ProgramLibrary::s_impulseLocation,
+			ProgramLibrary::s_colourLocation,
+			ProgramLibrary::s_contactScaleLocation,
+			*m_pool.pPool}
+	,	m_contactMode{}
+	,	m_circleLineRenderer{
+			ProgramLibrary::s_circleLocation,
+			ProgramLibrary::s_colourLocation,
+			ProgramLibrary::s_circleSegmentsLocation,
+			numCircleSegments,
+			*m_pool.pPool}
+	,	m_circleFillRenderer{
+			ProgramLibrary::s_circleLocation,
+			ProgramLibrary::s_colourLocation,
+			ProgramLibrary::s_circleSegmentsLocation,
+			numCircleSegments,
+			*m_pool.pPool}
+	,	m_instancingCircles{false}
+	,	m_retainedRenderers{}
+	,	m_refreshIntervals{}
+	,	m_refreshCountdowns{}
+	,	m_retainedDemand{}
+	,	m_refreshingLayers{0u}
+	,	m_pausedLayers{0u}
 	,	m_fillAlpha{fillAlpha}
 	,	m_axisScale{axisScale}
+	,	m_palette{box2dPalette(fillAlpha)}
+	,	m_pFrameSink{nullptr}
+	,	m_budget{}
+	,	m_nextBudget{}
+	,	m_frameStats{}
+	,	m_demand{}
+	,	m_lineTags{}
+	,	m_fillTags{}
+	,	m_segmentTags{}
+	,	m_skippedPrimitives{0u}
+	,	m_skipLevel{Degradation::none}
+	,	m_budgetApplied{false}
+	,	m_densityGrid{*m_pool.pPool}
+	,	m_densityMode{}
+	,	m_worldOffset{0.0f, 0.0f}
+	,	m_worldScale{1.0f}
+	,	m_solidShapes{0u}
+	,	m_drawingDensity{false}
+	,	m_treeStats{}
+	,	m_tmpTreeStack{}
+	,	m_tmpPicks{}
 {
+	m_segmentRenderer.setSegmentCoalescing(true);
+
+	m_retainedRenderers.reserve(e_retainedLayerCount);
+	for (unsigned i = 0; i < e_retainedLayerCount; ++i)
+	{
+		// Retained across frames, so kept off the frame arena.
+		m_retainedRenderers.emplace_back(
+			positionAttribLoc,
+			colourAttribLoc,
+			numCircleSegments,
+			numBuffers,
+			*m_pool.pPool);
+		m_retainedRenderers.back().setSegmentCoalescing(true);
+	}
+	m_refreshIntervals.fill(1u);
 }
 
 
 DebugDraw::~DebugDraw() noexcept = default;
 
 
+void
+DebugDraw::SetPaletteIndexAttribLocation(GLint const location)
+{
+	auto const apply = [this, location](PrimitiveRenderer& renderer) {
+		renderer.setPalette(m_palette.data(), m_palette.size());
+		renderer.setPaletteIndexAttribLocation(location);
+	};
+	apply(m_lineRenderer);
+	apply(m_fillRenderer);
+	apply(m_segmentRenderer);
+	for (auto& renderer: m_retainedRenderers)
+	{
+		apply(renderer);
+	}
+}
+
+
+DebugDraw::PoolOwner::PoolOwner(ResourcePool* const pBorrowed)
+	:	pOwned{pBorrowed ? nullptr : new ResourcePool{}}
+	,	pPool{pBorrowed ? pBorrowed : pOwned.get()}
+{
+}
+
+
+DebugDraw::PoolOwner::PoolOwner(PoolOwner&& other) noexcept
+	:	pOwned{std::move(other.pOwned)}
+	,	pPool{other.pPool}
+{
+}
+
+
+DebugDraw::PoolOwner&
+DebugDraw::PoolOwner::operator=(PoolOwner&& other) noexcept
+{
+	// The renderers assigned next return their old buffers to the old pool,
+	// which the other DebugDraw now frees.
+	std::swap(pOwned, other.pOwned);
+	std::swap(pPool, other.pPool);
+	return *this;
+}
+
+
+DebugDraw::PoolOwner::~PoolOwner() noexcept
+{
+	if (pOwned) {
+		pOwned->clear();
+	}
+}
+
+
+DebugDraw::Layer
+DebugDraw::Classify(b2Color const& colour) noexcept
+{
+	// The colours b2World::DrawDebugData uses for each layer.
+	if (
+		hasColour(colour, 0.9f, 0.3f, 0.9f) || // AABBs.
+		hasColour(colour, 0.3f, 0.9f, 0.9f) // Broad-phase pairs.
+	)
+	{
+		return e_overlayLayer;
+	}
+	if (
+		hasColour(colour, 0.5f, 0.9f, 0.5f) || // Static.
+		hasColour(colour, 0.6f, 0.6f, 0.6f) || // Sleeping.
+		hasColour(colour, 0.5f, 0.5f, 0.3f) // Inactive.
+	)
+	{
+		return e_restingLayer;
+	}
+	return e_bodyLayer;
+}
+
+
 void
 DebugDraw::DrawPolygon(
 	b2Vec2 const* pVertices,
@@ -34,7 +279,26 @@ DebugDraw::DrawPolygon(
 	b2Color const& colour
 )
 {
-	m_lineRenderer.addPolygon(pVertices, vertexCount, colour);
+	if (hasColour(colour, 0.9f, 0.3f, 0.9f))
+	{
+		if (auto const pAabbs = Refreshing(e_aabbLayer))
+		{
+			if (AdmitRetained(e_aabbLayer, vertexCount)) {
+				pAabbs->addPolygon(pVertices, vertexCount, colour);
+			}
+			return;
+		}
+		if (Paused(e_aabbLayer)) {
+			return;
+		}
+	}
+
+	auto const layer = Classify(colour);
+	if (Admit(layer, vertexCount, false))
+	{
+		m_lineRenderer.addPolygon(pVertices, vertexCount, colour);
+		Tag(m_lineRenderer, m_lineTags, layer, false);
+	}
 }
 
 void
@@ -44,10 +308,20 @@ DebugDraw::DrawSolidPolygon(
 	b2Color const& colour
 )
 {
+	if (CountDensity(pVertices, vertexCount, colour)) {
+		return;
+	}
+
+	auto const layer = Classify(colour);
+	if (!Admit(layer, vertexCount, false)) {
+		return;
+	}
+
 	b2Color fillColour{colour};
 	fillColour.a = m_fillAlpha;
 
 	m_fillRenderer.addPolygon(pVertices, vertexCount, fillColour);
+	Tag(m_fillRenderer, m_fillTags, layer, false);
 }
 
 void
@@ -57,7 +331,23 @@ DebugDraw::DrawCircle(
 	b2Color const& colour
 )
 {
-	m_lineRenderer.addCircle(centre, radius, colour);
+	auto const layer = Classify(colour);
+	if (m_instancingCircles)
+	{
+		if (Admit(layer, m_circleLineRenderer.segments(), false)) {
+			m_circleLineRenderer.addCircle(
+				m_worldOffset + m_worldScale * centre,
+				m_worldScale * radius,
+				colour);
+		}
+		return;
+	}
+
+	if (Admit(layer, m_lineRenderer.numCircleSegments(), true))
+	{
+		m_lineRenderer.addCircle(centre, radius, colour);
+		Tag(m_lineRenderer, m_lineTags, layer, true);
+	}
 }
 
 void
@@ -68,15 +358,39 @@ DebugDraw::DrawSolidCircle(
 	b2Color const& colour
 )
 {
+	if (CountDensity(&centre, 1, colour)) {
+		return;
+	}
+
+	auto const layer = Classify(colour);
+	bool const admitFill{m_instancingCircles
+		? Admit(layer, m_circleFillRenderer.segments(), false)
+		: Admit(layer, m_fillRenderer.numCircleSegments(), true)};
+	bool const admitAxis{Admit(layer, 2u, false)};
+	if (!admitFill || !admitAxis) {
+		return;
+	}
+
 	b2Color fillColour{colour};
 	fillColour.a = m_fillAlpha;
 
-	m_fillRenderer.addCircle(centre, radius, fillColour);
-	m_lineRenderer.addSegment(
+	if (m_instancingCircles) {
+		m_circleFillRenderer.addCircle(
+			m_worldOffset + m_worldScale * centre,
+			m_worldScale * radius,
+			fillColour);
+	}
+	else
+	{
+		m_fillRenderer.addCircle(centre, radius, fillColour);
+		Tag(m_fillRenderer, m_fillTags, layer, true);
+	}
+	m_segmentRenderer.addSegment(
 		centre,
 		centre + radius * axis,
 		b2Color{0.0f, 0.0f, 0.0f, 1.0f}
 	);
+	Tag(m_segmentRenderer, m_segmentTags, layer, false);
 }
 
 void
@@ -86,7 +400,34 @@ DebugDraw::DrawSegment(
 	b2Color const& colour
 )
 {
-	m_lineRenderer.addSegment(begin, end, colour);
+	// The colours b2World::DrawDebugData draws joints and pairs in.
+	auto retained = e_retainedLayerCount;
+	if (hasColour(colour, 0.5f, 0.8f, 0.8f)) {
+		retained = e_jointLayer;
+	}
+	else if (hasColour(colour, 0.3f, 0.9f, 0.9f)) {
+		retained = e_pairLayer;
+	}
+	if (retained != e_retainedLayerCount)
+	{
+		if (auto const pRetained = Refreshing(retained))
+		{
+			if (AdmitRetained(retained, 2u)) {
+				pRetained->addSegment(begin, end, colour);
+			}
+			return;
+		}
+		if (Paused(retained)) {
+			return;
+		}
+	}
+
+	auto const layer = Classify(colour);
+	if (Admit(layer, 2u, false))
+	{
+		m_segmentRenderer.addSegment(begin, end, colour);
+		Tag(m_segmentRenderer, m_segmentTags, layer, false);
+	}
 }
 
 
@@ -97,34 +438,395 @@ DebugDraw::DrawPoint(
 	b2Color const& colour
 )
 {
-	constexpr int32 numVertices{4};
-	b2Vec2 const vertices[numVertices] = {
-		b2Vec2{point.x - 0.1f, point.y - 0.1f},
-		b2Vec2{point.x + 0.1f, point.y - 0.1f},
-		b2Vec2{point.x + 0.1f, point.y + 0.1f},
-		b2Vec2{point.x - 0.1f, point.y + 0.1f}
-	};
-	DrawSolidPolygon(&vertices[0], numVertices, colour);
+	// Points can't be grouped, so are placed in their world here. They're
+	// never thinned out, only dropped with their layer.
+	if (Admit(Classify(colour), 1u, false)) {
+		m_pointRenderer.addPoint(
+			m_worldOffset + m_worldScale * point, size, colour);
+	}
 }
 
 
 void
 DebugDraw::DrawTransform(b2Transform const& xf)
 {
+	// Box2D only draws transforms to mark centres of mass.
+	if (auto const pCentres = Refreshing(e_centreOfMassLayer))
+	{
+		if (!AdmitRetained(e_centreOfMassLayer, 4u)) {
+			return;
+		}
+		pCentres->addSegment(
+			xf.p,
+			xf.p + m_axisScale * xf.q.GetXAxis(),
+			b2Color{1.0f, 0.0f, 0.0f});
+		pCentres->addSegment(
+			xf.p,
+			xf.p + m_axisScale * xf.q.GetYAxis(),
+			b2Color{0.0f, 1.0f, 0.0f});
+		return;
+	}
+	if (Paused(e_centreOfMassLayer)) {
+		return;
+	}
+
+	bool const xAxis{Admit(e_overlayLayer, 2u, false)};
+	bool const yAxis{Admit(e_overlayLayer, 2u, false)};
+	if (!xAxis || !yAxis) {
+		return;
+	}
 
 	b2Vec2 end = xf.p + m_axisScale * xf.q.GetXAxis();
-	m_lineRenderer.addSegment(xf.p, end, b2Color{1.0f, 0.0f, 0.0f});
+	m_segmentRenderer.addSegment(xf.p, end, b2Color{1.0f, 0.0f, 0.0f});
+	Tag(m_segmentRenderer, m_segmentTags, e_overlayLayer, false);
 
 	end = xf.p + m_axisScale * xf.q.GetYAxis();
-	m_lineRenderer.addSegment(xf.p, end, b2Color{0.0f, 1.0f, 0.0f});
+	m_segmentRenderer.addSegment(xf.p, end, b2Color{0.0f, 1.0f, 0.0f});
+	Tag(m_segmentRenderer, m_segmentTags, e_overlayLayer, false);
+}
+
+
+bool
+DebugDraw::Admit(
+	Layer const layer,
+	std::size_t const vertexCount,
+	bool const circle
+) noexcept
+{
+	if (!HasBudget()) {
+		return true;
+	}
+
+	auto& demand = m_demand[layer];
+	demand.vertices += vertexCount;
+	if (circle && vertexCount >= minThinnedCircleSegments) {
+		demand.circleSaving += vertexCount / 2;
+	}
+
+	bool const skip{Drops(m_skipLevel, layer)};
+	m_skippedPrimitives += skip;
+	return !skip;
+}
+
+
+bool
+DebugDraw::AdmitRetained(
+	RetainedLayer const layer,
+	std::size_t const vertexCount
+) noexcept
+{
+	if (!HasBudget()) {
+		return true;
+	}
+
+	// Counted until the layer is next redrawn, as it's drawn every frame.
+	m_retainedDemand[layer] += vertexCount;
+	bool const skip{Drops(m_skipLevel, BudgetLayer(layer))};
+	m_skippedPrimitives += skip;
+	return !skip;
+}
+
+
+void
+DebugDraw::Tag(
+	PrimitiveRenderer const& renderer,
+	std::vector<unsigned char>& tags,
+	Layer const layer,
+	bool const circle
+)
+{
+	if (HasBudget() && tags.size() < renderer.polygonCount()) {
+		tags.push_back(layer | (circle ? e_circleTag : 0u));
+	}
+}
+
+
+void
+DebugDraw::ApplyBudget()
+{
+	if (m_budgetApplied) {
+		return;
+	}
+	m_budgetApplied = true;
+
+	std::array<PrimitiveRenderer*, 3> const renderers{{
+		&m_lineRenderer, &m_fillRenderer, &m_segmentRenderer}};
+	std::array<std::vector<unsigned char>*, 3> const tags{{
+		&m_lineTags, &m_fillTags, &m_segmentTags}};
+
+	auto& stats = m_frameStats;
+	stats = FrameStats{};
+	stats.tree = m_treeStats;
+	std::size_t retainedVertices{0u};
+	for (auto const& renderer: m_retainedRenderers)
+	{
+		retainedVertices += renderer.vertexCount();
+	}
+	stats.vertices = m_pointRenderer.pointCount() + retainedVertices;
+	for (auto const pRenderer: renderers)
+	{
+		stats.vertices += pRenderer->vertexCount();
+	}
+	stats.requestedVertices = stats.vertices;
+	stats.bytes = stats.vertices * sizeof(Vertex);
+	if (!HasBudget()) {
+		return;
+	}
+
+	std::size_t limit{std::numeric_limits<std::size_t>::max()};
+	if (m_budget.maxVertices) {
+		limit = m_budget.maxVertices;
+	}
+	if (m_budget.maxBytesPerFrame) {
+		limit = std::min(limit, m_budget.maxBytesPerFrame / sizeof(Vertex));
+	}
+
+	// Work out how far to degrade from what was drawn, including anything
+	// skipped, so that skipped layers come back once they'd fit. Retained
+	// layers count as drawn every frame.
+	auto demands = m_demand;
+	for (unsigned i = 0; i < e_retainedLayerCount; ++i)
+	{
+		demands[BudgetLayer(RetainedLayer(i))].vertices +=
+			m_retainedDemand[i];
+	}
+	std::size_t total{0u};
+	for (auto const& demand: demands)
+	{
+		total += demand.vertices;
+	}
+	stats.requestedVertices = total;
+
+	auto level = Degradation::none;
+	if (total > limit)
+	{
+		for (auto const& demand: demands)
+		{
+			total -= demand.circleSaving;
+		}
+		level = Degradation::circleDetail;
+	}
+	for (auto const layer: {e_overlayLayer, e_restingLayer})
+	{
+		if (total <= limit) {
+			break;
+		}
+		auto const& demand = demands[layer];
+		total -= demand.vertices - demand.circleSaving;
+		level = layer == e_overlayLayer
+			? Degradation::overlays
+			: Degradation::restingBodies;
+	}
+	std::size_t stride{1u};
+	if (total > limit)
+	{
+		stride = limit ? (total + limit - 1) / limit : total;
+		level = Degradation::sampling;
+	}
+	m_skipLevel = level;
+	stats.degradation = level;
+	stats.sampleStride = stride;
+	stats.droppedPrimitives = m_skippedPrimitives;
+	if (level == Degradation::none) {
+		return;
+	}
+
+	// Empty retained layers which are dropped until they're next redrawn,
+	// uploading them along with those being redrawn.
+	for (std::size_t i = 0; i < m_retainedRenderers.size(); ++i)
+	{
+		auto& renderer = m_retainedRenderers[i];
+		auto const layer = BudgetLayer(RetainedLayer(i));
+		if (renderer.polygonCount() && Drops(level, layer))
+		{
+			stats.droppedPrimitives += renderer.polygonCount();
+			retainedVertices -= renderer.vertexCount();
+			renderer.clear();
+			m_refreshingLayers |= 1u << i;
+		}
+	}
+
+	// Thin out or drop each primitive by its tag, stopping at the limit.
+	std::vector<unsigned char> strides;
+	std::size_t kept{m_pointRenderer.pointCount() + retainedVertices};
+	std::size_t sampled{0u};
+	for (std::size_t r = 0; r < renderers.size(); ++r)
+	{
+		auto& renderer = *renderers[r];
+		auto const primitives = renderer.view();
+		strides.assign(primitives.polygonCount, 0u);
+		for (std::size_t i = 0; i < primitives.polygonCount; ++i)
+		{
+			auto const tag = (*tags[r])[i];
+			auto const layer = Layer(tag & ~e_circleTag);
+			std::size_t const size = primitives.pPolygonSizes[i];
+			bool const dropped{
+				Drops(level, layer) ||
+				(level == Degradation::sampling && sampled++ % stride != 0)
+			};
+			std::size_t const step =
+				(tag & e_circleTag) && size >= minThinnedCircleSegments
+				? 2u
+				: 1u;
+			std::size_t const remaining = (size + step - 1) / step;
+			if (dropped || kept + remaining > limit)
+			{
+				++stats.droppedPrimitives;
+				continue;
+			}
+			strides[i] = step;
+			kept += remaining;
+		}
+		renderer.compact(strides);
+	}
+
+	stats.vertices = kept;
+	stats.bytes = kept * sizeof(Vertex);
+}
+
+
+bool
+DebugDraw::CountDensity(
+	b2Vec2 const* const pPoints,
+	int32 const count,
+	b2Color const& colour
+)
+{
+	++m_solidShapes;
+	if (!m_drawingDensity) {
+		return false;
+	}
+	bool const counted{
+		!m_densityMode.awakeOnly || Classify(colour) == e_bodyLayer};
+	if (count <= 0 || !counted) {
+		return true;
+	}
+
+	b2Vec2 centre{0.0f, 0.0f};
+	for (int32 i = 0; i < count; ++i)
+	{
+		centre += pPoints[i];
+	}
+	centre *= 1.0f / count;
+	m_densityGrid.add(m_worldOffset + m_worldScale * centre);
+	return true;
 }
 
 
 void
 DebugDraw::BufferData()
 {
+	ApplyBudget();
 	m_lineRenderer.bufferData();
 	m_fillRenderer.bufferData();
+	m_segmentRenderer.bufferData();
+	m_pointRenderer.bufferData();
+	m_circleLineRenderer.bufferData();
+	m_circleFillRenderer.bufferData();
+
+	// Contacts are drawn during the step, so are cleared once buffered.
+	m_frameStats.contacts = m_contactRenderer.contactCount();
+	m_contactRenderer.bufferData();
+	m_contactRenderer.clear();
+
+	// Stale layers keep the buffers they were last drawn from.
+	for (std::size_t i = 0; i < m_retainedRenderers.size(); ++i)
+	{
+		if (m_refreshingLayers & (1u << i)) {
+			m_retainedRenderers[i].bufferData();
+		}
+	}
+	if (m_drawingDensity) {
+		m_densityGrid.bufferData();
+	}
+	Publish();
+}
+
+
+void
+DebugDraw::Publish()
+{
+	ApplyBudget();
+	if (m_pFrameSink) {
+		m_pFrameSink->write(GetFrame());
+	}
+}
+
+
+void
+DebugDraw::BufferData(FrameView const& frame)
+{
+	PrimitiveView lines{nullptr, 0u, nullptr, nullptr, 0u};
+	PrimitiveView fills{nullptr, 0u, nullptr, nullptr, 0u};
+	PrimitiveView segments{nullptr, 0u, nullptr, nullptr, 0u};
+	PrimitiveView points{nullptr, 0u, nullptr, nullptr, 0u};
+	// Sections after the first of each mode are retained layers, in order,
+	// as laid out by GetFrame.
+	std::size_t retained{0u};
+	unsigned seen{0u};
+	for (std::size_t i = 0; i < frame.sectionCount; ++i)
+	{
+		auto const& section = frame.sections[i];
+		PrimitiveView* pView{nullptr};
+		unsigned bit{0u};
+		if (section.mode == GL_LINE_LOOP) {
+			pView = &lines;
+			bit = 0x1u;
+		}
+		else if (section.mode == GL_TRIANGLE_FAN) {
+			pView = &fills;
+			bit = 0x2u;
+		}
+		else if (section.mode == GL_LINE_STRIP) {
+			pView = &segments;
+			bit = 0x4u;
+		}
+		else if (section.mode == GL_POINTS) {
+			pView = &points;
+			bit = 0x8u;
+		}
+
+		if (pView && !(seen & bit))
+		{
+			*pView = section.primitives;
+			seen |= bit;
+		}
+		else if (pView && retained < m_retainedRenderers.size()) {
+			m_retainedRenderers[retained++].bufferData(section.primitives);
+		}
+	}
+	m_lineRenderer.bufferData(lines);
+	m_fillRenderer.bufferData(fills);
+	m_segmentRenderer.bufferData(segments);
+	m_pointRenderer.bufferData(points);
+	for (; retained < m_retainedRenderers.size(); ++retained)
+	{
+		m_retainedRenderers[retained].bufferData(
+			PrimitiveView{nullptr, 0u, nullptr, nullptr, 0u});
+	}
+}
+
+
+FrameView
+DebugDraw::GetFrame() const noexcept
+{
+	FrameView frame;
+	frame.flags = GetFlags();
+	frame.sectionCount = 4u + e_retainedLayerCount;
+	frame.sections[0] = FrameSection{GL_LINE_LOOP, m_lineRenderer.view()};
+	frame.sections[1] = FrameSection{GL_TRIANGLE_FAN, m_fillRenderer.view()};
+	frame.sections[2] = FrameSection{GL_LINE_STRIP, m_segmentRenderer.view()};
+	frame.sections[3] = FrameSection{GL_POINTS, m_pointRenderer.view()};
+
+	// Retained layers last, in the order Render draws them.
+	for (std::size_t i = 0; i < m_retainedRenderers.size(); ++i)
+	{
+		GLenum const mode{
+			i == e_aabbLayer ? GLenum(GL_LINE_LOOP) : GLenum(GL_LINE_STRIP)};
+		frame.sections[4u + i] =
+			FrameSection{mode, m_retainedRenderers[i].view()};
+	}
+	return frame;
 }
 
 
@@ -133,14 +835,526 @@ DebugDraw::Render()
 {
 	m_lineRenderer.render(GL_LINE_LOOP);
 	m_fillRenderer.render(GL_TRIANGLE_FAN);
+	m_segmentRenderer.render(GL_LINE_STRIP);
+	m_pointRenderer.render();
+	RenderRetained();
+}
+
+
+void
+DebugDraw::Render(float32 const alpha)
+{
+	m_lineRenderer.render(GL_LINE_LOOP, alpha);
+	m_fillRenderer.render(GL_TRIANGLE_FAN, alpha);
+	m_segmentRenderer.render(GL_LINE_STRIP, alpha);
+	m_pointRenderer.render();
+	RenderRetained();
+}
+
+
+void
+DebugDraw::RenderCulled(
+	b2Vec2 const& lower,
+	b2Vec2 const& upper,
+	GLuint const cullProgram,
+	GLuint const drawProgram,
+	float32 const minSize
+)
+{
+	m_lineRenderer.renderCulled(
+		GL_LINE_LOOP, lower, upper, cullProgram, drawProgram, minSize);
+	m_fillRenderer.renderCulled(
+		GL_TRIANGLE_FAN, lower, upper, cullProgram, drawProgram, minSize);
+	m_segmentRenderer.renderCulled(
+		GL_LINE_STRIP, lower, upper, cullProgram, drawProgram, minSize);
+	m_pointRenderer.render();
+	for (std::size_t i = 0; i < m_retainedRenderers.size(); ++i)
+	{
+		m_retainedRenderers[i].renderCulled(
+			i == e_aabbLayer ? GL_LINE_LOOP : GL_LINE_STRIP,
+			lower,
+			upper,
+			cullProgram,
+			drawProgram,
+			minSize);
+	}
+}
+
+
+void
+DebugDraw::RenderRetained()
+{
+	for (std::size_t i = 0; i < m_retainedRenderers.size(); ++i)
+	{
+		m_retainedRenderers[i].render(
+			i == e_aabbLayer ? GL_LINE_LOOP : GL_LINE_STRIP);
+	}
+}
+
+
+void
+DebugDraw::Render(
+	Viewport const* const pViewports,
+	std::size_t const count,
+	ProgramLibrary& programs,
+	ProgramKind const kind
+)
+{
+	bool const cull{PrimitiveRenderer::supportsCulling()};
+	GLuint const cullProgram{
+		cull ? programs.program(ProgramKind::cullPrimitives) : 0u};
+	GLuint const drawProgram{programs.program(kind)};
+	for (auto pView = pViewports; pView < pViewports + count; ++pView)
+	{
+		auto const& view = *pView;
+		b2Vec2 const extents{view.upper - view.lower};
+		if (
+			view.width <= 0 || view.height <= 0 ||
+			extents.x <= 0.0f || extents.y <= 0.0f
+		)
+		{
+			continue;
+		}
+
+		// Column-major orthographic projection of the view's world area.
+		GLfloat const matrix[16] = {
+			2.0f / extents.x, 0.0f, 0.0f, 0.0f,
+			0.0f, 2.0f / extents.y, 0.0f, 0.0f,
+			0.0f, 0.0f, 1.0f, 0.0f,
+			-(view.lower.x + view.upper.x) / extents.x,
+			-(view.lower.y + view.upper.y) / extents.y,
+			0.0f,
+			1.0f
+		};
+		programs.setMatrix(matrix);
+		programs.use(kind);
+		glViewport(view.x, view.y, view.width, view.height);
+		if (!cull) {
+			Render();
+		}
+		else
+		{
+			float32 const pixelSize{std::max(
+				extents.x / view.width, extents.y / view.height)};
+			RenderCulled(
+				view.lower,
+				view.upper,
+				cullProgram,
+				drawProgram,
+				view.minPixels * pixelSize);
+		}
+
+		if (
+			m_circleLineRenderer.bufferedCount() ||
+			m_circleFillRenderer.bufferedCount()
+		)
+		{
+			programs.use(ProgramKind::instancedCircle);
+			RenderCircles();
+		}
+	}
+}
+
+
+void
+DebugDraw::RenderDensity()
+{
+	if (m_drawingDensity) {
+		m_densityGrid.render();
+	}
+}
+
+
+void
+DebugDraw::DrawContact(
+	b2Contact const* const pContact,
+	b2ContactImpulse const* const pImpulse
+)
+{
+	b2WorldManifold manifold;
+	pContact->GetWorldManifold(&manifold);
+	int32 const count{
+		std::min(pContact->GetManifold()->pointCount, pImpulse->count)};
+	for (int32 i = 0; i < count; ++i)
+	{
+		float32 const impulse{pImpulse->normalImpulses[i]};
+		if (impulse >= m_contactMode.impulseThreshold) {
+			m_contactRenderer.addContact(
+				manifold.points[i], manifold.normal, impulse);
+		}
+	}
+}
+
+
+void
+DebugDraw::DrawWorld(b2World& world)
+{
+	// Draw the shapes here, as Box2D would, then let it draw the rest.
+	auto const flags = GetFlags();
+	if (flags & e_shapeBit)
+	{
+		for (auto pBody = world.GetBodyList(); pBody; pBody = pBody->GetNext())
+		{
+			auto const& xf = pBody->GetTransform();
+			auto const colour = bodyColour(*pBody);
+			for (
+				auto pFixture = pBody->GetFixtureList();
+				pFixture;
+				pFixture = pFixture->GetNext()
+			)
+			{
+				SetTag(pFixture);
+				drawShape(*this, *pFixture, xf, colour);
+			}
+		}
+		SetTag(nullptr);
+	}
+
+	// Paused layers would be skipped anyway, so spare the world traversing
+	// them.
+	uint32 paused{0u};
+	for (unsigned i = 0; i < e_retainedLayerCount; ++i)
+	{
+		if (m_pausedLayers & (1u << i)) {
+			paused |= retainedFlags[i];
+		}
+	}
+	world.SetDebugDraw(this);
+	SetFlags(flags & ~(uint32(e_shapeBit) | paused));
+	world.DrawDebugData();
+	SetFlags(flags);
+}
+
+
+void
+DebugDraw::DrawBroadPhase(b2World const& world, TreeDetail const& detail)
+{
+	auto const& broadPhase = world.GetContactManager().m_broadPhase;
+	auto const& tree = broadPhaseTree(broadPhase);
+	b2TreeNode const* const pNodes{treeNodes(tree)};
+	int32 const root{treeRoot(tree)};
+
+	m_treeStats.height = world.GetTreeHeight();
+	m_treeStats.areaRatio =
+		detail.measureAreaRatio ? world.GetTreeQuality() : 0.0f;
+	if (root == b2_nullNode) {
+		return;
+	}
+
+	// Children lie inside their parents, so a node too deep or too small to
+	// draw ends its branch. Nodes skipped for the budget are still descended,
+	// so that their children count towards demand.
+	auto& stack = m_tmpTreeStack;
+	stack.assign(1u, {root, 0u});
+	while (!stack.empty())
+	{
+		auto const next = stack.back();
+		stack.pop_back();
+		auto const& node = pNodes[next.first];
+		auto const& aabb = node.aabb;
+		b2Vec2 const size{aabb.upperBound - aabb.lowerBound};
+		if (std::max(size.x, size.y) * detail.pixelsPerUnit < detail.minPixels)
+		{
+			continue;
+		}
+
+		if (Admit(e_overlayLayer, 4u, false))
+		{
+			b2Vec2 const corners[4]{
+				aabb.lowerBound,
+				b2Vec2{aabb.upperBound.x, aabb.lowerBound.y},
+				aabb.upperBound,
+				b2Vec2{aabb.lowerBound.x, aabb.upperBound.y}
+			};
+			m_lineRenderer.addPolygon(
+				corners, 4, depthColour(next.second, detail.maxDepth));
+			Tag(m_lineRenderer, m_lineTags, e_overlayLayer, false);
+			++m_treeStats.nodesDrawn;
+		}
+		if (!node.IsLeaf() && next.second < detail.maxDepth)
+		{
+			stack.emplace_back(node.child2, next.second + 1u);
+			stack.emplace_back(node.child1, next.second + 1u);
+		}
+	}
+}
+
+
+std::size_t
+DebugDraw::Pick(
+	b2Vec2 const& point,
+	float32 const radius,
+	std::vector<PrimitiveRenderer::Tag>& tags
+)
+{
+	tags.clear();
+
+	// Segments are drawn over fills, which are drawn over outlines; within
+	// a renderer, later primitives are drawn over earlier ones.
+	std::pair<PrimitiveRenderer*, GLenum> const layers[] = {
+		{&m_segmentRenderer, GL_LINE_STRIP},
+		{&m_fillRenderer, GL_TRIANGLE_FAN},
+		{&m_lineRenderer, GL_LINE_LOOP}
+	};
+	for (auto const& layer: layers)
+	{
+		m_tmpPicks.clear();
+		layer.first->pick(layer.second, point, radius, m_tmpPicks);
+		for (auto i = m_tmpPicks.rbegin(); i != m_tmpPicks.rend(); ++i)
+		{
+			auto const tag = layer.first->tag(*i);
+			if (tag && std::find(tags.begin(), tags.end(), tag) == tags.end())
+			{
+				tags.push_back(tag);
+			}
+		}
+	}
+	return tags.size();
 }
 
 
 void
 DebugDraw::Clear()
 {
+	// Redraw retained layers which are due, and pause the rest, leaving
+	// their buffers as they are. The flags themselves are left alone.
+	m_refreshingLayers = 0u;
+	m_pausedLayers = 0u;
+	for (unsigned i = 0; i < e_retainedLayerCount; ++i)
+	{
+		auto& countdown = m_refreshCountdowns[i];
+		if (m_refreshIntervals[i] <= 1u || !(GetFlags() & retainedFlags[i]))
+		{
+			// Upload the emptied layer once, so it isn't drawn stale.
+			if (m_retainedRenderers[i].polygonCount()) {
+				m_refreshingLayers |= 1u << i;
+			}
+			m_retainedRenderers[i].clear();
+			m_retainedDemand[i] = 0u;
+			countdown = 0u;
+		}
+		else if (countdown == 0u)
+		{
+			m_retainedRenderers[i].clear();
+			m_retainedDemand[i] = 0u;
+			m_refreshingLayers |= 1u << i;
+			countdown = m_refreshIntervals[i] - 1u;
+		}
+		else
+		{
+			m_pausedLayers |= 1u << i;
+			--countdown;
+		}
+	}
+
+	// Start this frame's storage apart from the geometry of other DebugDraws
+	// sharing the arena, so that its chunks can rewind.
+	if (auto const pArena = m_lineRenderer.arena()) {
+		pArena->reset();
+	}
 	m_lineRenderer.clear();
 	m_fillRenderer.clear();
+	m_segmentRenderer.clear();
+	m_pointRenderer.clear();
+	m_circleLineRenderer.clear();
+	m_circleFillRenderer.clear();
+
+	m_budget = m_nextBudget;
+	if (!HasBudget()) {
+		m_skipLevel = Degradation::none;
+	}
+	m_demand = {};
+	m_lineTags.clear();
+	m_fillTags.clear();
+	m_segmentTags.clear();
+	m_skippedPrimitives = 0u;
+	m_budgetApplied = false;
+
+	// Switch on the density of the last frame, and back at a lower density.
+	auto const cells = m_densityGrid.cellCount();
+	if (m_densityMode.bodiesPerPixel > 0.0f && cells)
+	{
+		float32 const threshold{
+			m_densityMode.bodiesPerPixel * (m_drawingDensity ? 0.75f : 1.0f)};
+		m_drawingDensity = float32(m_solidShapes) > threshold * cells;
+	}
+	else {
+		m_drawingDensity = false;
+	}
+	m_solidShapes = 0u;
+	m_densityGrid.clear();
+	m_worldOffset.SetZero();
+	m_worldScale = 1.0f;
+	m_treeStats = TreeStats{};
+}
+
+
+DebugDraw::CalibrationResult
+DebugDraw::Calibrate(unsigned const numPrimitives, unsigned const iterations)
+{
+	using Clock = std::chrono::steady_clock;
+
+	// Upload as the frame does: into as many buffers, from the same pool and
+	// so with or without direct state access alike.
+	PrimitiveRenderer lines{
+		m_lineRenderer.positionAttribLocation(),
+		m_lineRenderer.colourAttribLocation(),
+		unsigned(m_lineRenderer.numCircleSegments()),
+		unsigned(m_lineRenderer.bufferCount()),
+		*m_pool.pPool
+	};
+	PrimitiveRenderer fills{
+		m_fillRenderer.positionAttribLocation(),
+		m_fillRenderer.colourAttribLocation(),
+		unsigned(m_fillRenderer.numCircleSegments()),
+		unsigned(m_fillRenderer.bufferCount()),
+		*m_pool.pPool
+	};
+
+	// Lay out a grid of alternating circles and boxes.
+	b2Color const colour{0.5f, 0.5f, 0.5f, 0.5f};
+	auto const columns = unsigned(std::sqrt(float(numPrimitives))) + 1u;
+	for (unsigned i = 0; i < numPrimitives; ++i)
+	{
+		b2Vec2 const centre{float32(i % columns), float32(i / columns)};
+		if (i % 2)
+		{
+			lines.addCircle(centre, 0.4f, colour);
+			fills.addCircle(centre, 0.4f, colour);
+			continue;
+		}
+
+		b2Vec2 const box[4] = {
+			centre + b2Vec2{-0.4f, -0.4f},
+			centre + b2Vec2{0.4f, -0.4f},
+			centre + b2Vec2{0.4f, 0.4f},
+			centre + b2Vec2{-0.4f, 0.4f}
+		};
+		lines.addPolygon(box, 4, colour);
+		fills.addPolygon(box, 4, colour);
+	}
+
+	GLint program{0};
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+	if (!program) {
+		throw std::runtime_error{"Calibrate needs a program bound"};
+	}
+
+	GLint indirectBuffer{0};
+	bool const indirect{
+		PrimitiveRenderer::isSupported(SubmissionStrategy::indirect)};
+	if (indirect) {
+		glGetIntegerv(GL_DRAW_INDIRECT_BUFFER_BINDING, &indirectBuffer);
+	}
+
+	GLboolean colourMask[4];
+	glGetBooleanv(GL_COLOR_WRITEMASK, colourMask);
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	auto const restore = [&colourMask, indirect, indirectBuffer]() {
+		glColorMask(colourMask[0], colourMask[1], colourMask[2], colourMask[3]);
+		if (indirect) {
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, GLuint(indirectBuffer));
+		}
+	};
+
+	CalibrationResult result{SubmissionStrategy::multiDraw, {}};
+	auto best = Clock::duration::max();
+	try
+	{
+		for (unsigned i = 0; i < unsigned(SubmissionStrategy::count); ++i)
+		{
+			auto const strategy = static_cast<SubmissionStrategy>(i);
+			if (!PrimitiveRenderer::isSupported(strategy)) {
+				continue;
+			}
+			lines.setSubmissionStrategy(strategy);
+			fills.setSubmissionStrategy(strategy);
+
+			// Create any index or command buffers before timing.
+			lines.bufferData();
+			fills.bufferData();
+			lines.render(GL_LINE_LOOP);
+			fills.render(GL_TRIANGLE_FAN);
+			glFinish();
+
+			// Upload each iteration, as each frame does, so that building
+			// indices or commands after each upload is timed too.
+			auto const start = Clock::now();
+			for (unsigned j = 0; j < iterations; ++j)
+			{
+				lines.bufferData();
+				fills.bufferData();
+				lines.render(GL_LINE_LOOP);
+				fills.render(GL_TRIANGLE_FAN);
+			}
+			glFinish();
+			auto const elapsed = Clock::now() - start;
+
+			result.timings[i] = elapsed;
+			if (elapsed < best)
+			{
+				best = elapsed;
+				result.strategy = strategy;
+			}
+		}
+	}
+	catch (...)
+	{
+		// E.g. std::bad_alloc building indices; leave GL as it was found.
+		restore();
+		throw;
+	}
+
+	restore();
+	SetSubmissionStrategy(result.strategy);
+	return result;
+}
+
+
+PrimitiveRenderer::UploadStats
+DebugDraw::GetUploadStats() const noexcept
+{
+	auto stats = m_lineRenderer.uploadStats();
+	auto const add = [&stats](PrimitiveRenderer const& renderer) {
+		auto const& rendererStats = renderer.uploadStats();
+		stats.fenceWaitTime += rendererStats.fenceWaitTime;
+		stats.uploads += rendererStats.uploads;
+		stats.busyUploads += rendererStats.busyUploads;
+	};
+	add(m_fillRenderer);
+	add(m_segmentRenderer);
+	for (auto const& renderer: m_retainedRenderers)
+	{
+		add(renderer);
+	}
+	return stats;
+}
+
+
+void
+DebugDraw::SetRefreshInterval(uint32 const flag, unsigned const frames) noexcept
+{
+	for (unsigned i = 0; i < e_retainedLayerCount; ++i)
+	{
+		if (retainedFlags[i] == flag)
+		{
+			m_refreshIntervals[i] = std::max(frames, 1u);
+			m_refreshCountdowns[i] = 0u;
+		}
+	}
+}
+
+
+unsigned
+DebugDraw::GetRefreshInterval(uint32 const flag) const noexcept
+{
+	for (unsigned i = 0; i < e_retainedLayerCount; ++i)
+	{
+		if (retainedFlags[i] == flag) {
+			return m_refreshIntervals[i];
+		}
+	}
+	return 1u;
 }
 
 
@@ -0,0 +1,1254 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "b2draw/DeltaStream.h"
+
+
+namespace b2draw {
+namespace {
+
+
+constexpr std::uint32_t streamMagic = 0x53443242u; // "B2DS"
+constexpr std::uint32_t packetMagic = 0x50443242u; // "B2DP"
+constexpr std::uint32_t streamVersion = 1u;
+
+// How far, in metres, a primitive may move between frames and still be
+// matched to its previous position.
+constexpr float matchDistance = 1.0f;
+
+// Limits on decoded sizes, so corrupt streams can't exhaust memory.
+constexpr std::uint64_t maxPolygons = 1u << 24;
+constexpr std::uint64_t maxVertices = 1u << 26;
+
+
+struct StreamHeader
+{
+	std::uint32_t magic;
+	std::uint32_t version;
+	float quantum;
+	std::uint32_t keyframeInterval;
+};
+
+
+enum class PacketType: std::uint32_t
+{
+	keyframe,
+	delta
+};
+
+
+struct PacketHeader
+{
+	std::uint32_t magic;
+	PacketType type;
+	std::uint32_t flags;
+	std::uint32_t sectionCount;
+	std::uint64_t payloadSize;
+};
+
+
+[[noreturn]] void
+throwCorrupt()
+{
+	throw std::runtime_error{"Corrupt delta stream frame"};
+}
+
+
+// Adaptive binary range coding, as in LZMA: each modelled bit has an 11-bit
+// probability of being zero, which adapts towards the bits actually seen.
+using Probability = std::uint16_t;
+constexpr unsigned probabilityBits = 11u;
+constexpr Probability initialProbability = 1u << (probabilityBits - 1u);
+constexpr unsigned adaptationShift = 5u;
+constexpr std::uint32_t topValue = 1u << 24;
+
+
+class RangeEncoder
+{
+public:
+	static constexpr bool decoding = false;
+
+	explicit RangeEncoder(std::vector<unsigned char>& output)
+		:	m_output(output)
+		,	m_low{0u}
+		,	m_range{0xffffffffu}
+		,	m_cache{0u}
+		,	m_cacheSize{1u}
+	{
+	}
+
+	void bit(Probability& probability, bool& value)
+	{
+		std::uint32_t const bound{(m_range >> probabilityBits) * probability};
+		if (value)
+		{
+			m_low += bound;
+			m_range -= bound;
+			probability -= probability >> adaptationShift;
+		}
+		else
+		{
+			m_range = bound;
+			probability += ((1u << probabilityBits) - probability) >>
+				adaptationShift;
+		}
+		normalise();
+	}
+
+	void direct(std::uint32_t& value, unsigned const numBits)
+	{
+		for (unsigned i = numBits; i-- > 0u;)
+		{
+			m_range >>= 1;
+			if ((value >> i) & 1u) {
+				m_low += m_range;
+			}
+			normalise();
+		}
+	}
+
+	void flush()
+	{
+		for (int i = 0; i < 5; ++i) {
+			shiftLow();
+		}
+	}
+
+private:
+	void normalise()
+	{
+		while (m_range < topValue)
+		{
+			m_range <<= 8;
+			shiftLow();
+		}
+	}
+
+	void shiftLow()
+	{
+		if (std::uint32_t(m_low) < 0xff000000u || (m_low >> 32) != 0u)
+		{
+			auto const carry = static_cast<unsigned char>(m_low >> 32);
+			auto byte = m_cache;
+			do
+			{
+				m_output.push_back(static_cast<unsigned char>(byte + carry));
+				byte = 0xffu;
+			}
+			while (--m_cacheSize != 0u);
+			m_cache = static_cast<unsigned char>(std::uint32_t(m_low) >> 24);
+		}
+		++m_cacheSize;
+		m_low = (m_low & 0x00ffffffu) << 8;
+	}
+
+	std::vector<unsigned char>& m_output;
+	std::uint64_t m_low;
+	std::uint32_t m_range;
+	unsigned char m_cache;
+	std::uint64_t m_cacheSize;
+};
+
+
+class RangeDecoder
+{
+public:
+	static constexpr bool decoding = true;
+
+	RangeDecoder(unsigned char const* const pInput, std::size_t const size)
+		:	m_pInput{pInput}
+		,	m_pEnd{pInput + size}
+		,	m_code{0u}
+		,	m_range{0xffffffffu}
+		,	m_overrun{false}
+	{
+		for (int i = 0; i < 5; ++i) {
+			m_code = (m_code << 8) | nextByte();
+		}
+	}
+
+	void bit(Probability& probability, bool& value)
+	{
+		std::uint32_t const bound{(m_range >> probabilityBits) * probability};
+		value = m_code >= bound;
+		if (value)
+		{
+			m_code -= bound;
+			m_range -= bound;
+			probability -= probability >> adaptationShift;
+		}
+		else
+		{
+			m_range = bound;
+			probability += ((1u << probabilityBits) - probability) >>
+				adaptationShift;
+		}
+		normalise();
+	}
+
+	void direct(std::uint32_t& value, unsigned const numBits)
+	{
+		value = 0u;
+		for (unsigned i = 0u; i < numBits; ++i)
+		{
+			m_range >>= 1;
+			std::uint32_t const bit{m_code >= m_range ? 1u : 0u};
+			m_code -= m_range & (0u - bit);
+			value = (value << 1) | bit;
+			normalise();
+		}
+	}
+
+	/** Whether decoding has read past the end of the input. */
+	bool overrun() const noexcept
+	{ return m_overrun; }
+
+private:
+	std::uint32_t nextByte() noexcept
+	{
+		if (m_pInput == m_pEnd)
+		{
+			m_overrun = true;
+			return 0u;
+		}
+		return *m_pInput++;
+	}
+
+	void normalise()
+	{
+		while (m_range < topValue)
+		{
+			m_range <<= 8;
+			m_code = (m_code << 8) | nextByte();
+		}
+	}
+
+	unsigned char const* m_pInput;
+	unsigned char const* m_pEnd;
+	std::uint32_t m_code;
+	std::uint32_t m_range;
+	bool m_overrun;
+};
+
+
+template <unsigned NumBits>
+struct BitTree
+{
+	BitTree()
+		:	probabilities{}
+	{
+		probabilities.fill(initialProbability);
+	}
+
+	std::array<Probability, 1u << NumBits> probabilities;
+};
+
+
+/**
+ * Code a symbol of NumBits bits.
+ *
+ * The coding functions below are shared by the encoder and decoder: encoding
+ * reads each value, and decoding writes it.
+ */
+template <typename Coder, unsigned NumBits>
+void
+codeSymbol(Coder& coder, BitTree<NumBits>& tree, std::uint32_t& symbol)
+{
+	std::uint32_t node{1u};
+	for (unsigned i = NumBits; i-- > 0u;)
+	{
+		bool bit{((symbol >> i) & 1u) != 0u};
+		coder.bit(tree.probabilities[node], bit);
+		node = (node << 1) | (bit ? 1u : 0u);
+	}
+	symbol = node - (1u << NumBits);
+}
+
+
+// Values are coded as their bit length, which is modelled, followed by the
+// bits below the leading one, which aren't.
+using ValueModel = BitTree<6u>;
+
+
+unsigned
+bitLength(std::uint32_t value) noexcept
+{
+	unsigned length{0u};
+	for (; value != 0u; value >>= 1) {
+		++length;
+	}
+	return length;
+}
+
+
+template <typename Coder>
+void
+codeValue(Coder& coder, ValueModel& model, std::uint32_t& value)
+{
+	std::uint32_t length{bitLength(value)};
+	codeSymbol(coder, model, length);
+	if (length > 32u) {
+		throwCorrupt();
+	}
+	if (length <= 1u)
+	{
+		value = length;
+		return;
+	}
+
+	std::uint32_t const top{1u << (length - 1u)};
+	std::uint32_t low{value & (top - 1u)};
+	coder.direct(low, length - 1u);
+	value = top | low;
+}
+
+
+inline std::uint32_t
+zigzag(std::uint32_t const value) noexcept
+{
+	return (value << 1) ^ (0u - (value >> 31));
+}
+
+
+inline std::uint32_t
+unzigzag(std::uint32_t const value) noexcept
+{
+	return (value >> 1) ^ (0u - (value & 1u));
+}
+
+
+struct Models
+{
+	ValueModel count{};
+	ValueModel size{};
+	ValueModel addedX{};
+	ValueModel addedY{};
+	ValueModel moveRun{};
+	ValueModel movedX{};
+	ValueModel movedY{};
+	ValueModel colourRun{};
+	Probability sameColour{initialProbability};
+	std::array<BitTree<8u>, 4u> channels{};
+};
+
+
+/**
+ * A section after quantisation: positions as interleaved multiples of the
+ * quantum, and colours as RGBA8. Velocities are each vertex's movement since
+ * the previous frame. Positions are kept as unsigned integers so that deltas
+ * wrap rather than overflow.
+ */
+struct QuantisedSection
+{
+	std::uint32_t mode{0u};
+	std::vector<std::uint32_t> sizes{};
+	std::vector<std::uint32_t> positions{};
+	std::vector<std::uint32_t> velocities{};
+	std::vector<std::uint32_t> colours{};
+};
+
+
+using QuantisedFrame = std::vector<QuantisedSection>;
+
+
+/** Vertex correspondences between the previous and current frame. */
+struct Match
+{
+	std::uint32_t current;
+	std::uint32_t previous;
+	bool startsPrimitive;
+};
+
+
+struct Scratch
+{
+	std::vector<Match> matches{};
+	std::vector<std::uint32_t> residuals{};
+
+	/** How far, in quanta, a primitive may move and still be matched. */
+	std::uint32_t matchDistance{0u};
+};
+
+
+template <typename Coder>
+void
+codeColour(
+	Coder& coder,
+	Models& models,
+	std::uint32_t& colour,
+	std::uint32_t const predicted
+)
+{
+	bool same{colour == predicted};
+	coder.bit(models.sameColour, same);
+	if (same)
+	{
+		colour = predicted;
+		return;
+	}
+
+	std::uint32_t result{0u};
+	for (unsigned channel = 0u; channel < 4u; ++channel)
+	{
+		std::uint32_t byte{(colour >> (8u * channel)) & 0xffu};
+		codeSymbol(coder, models.channels[channel], byte);
+		result |= byte << (8u * channel);
+	}
+	colour = result;
+}
+
+
+/** Code vertices with no counterpart in the previous frame. */
+template <typename Coder>
+void
+codeAddedVertices(
+	Coder& coder,
+	Models& models,
+	QuantisedSection& section,
+	std::size_t const begin,
+	std::size_t const end
+)
+{
+	std::uint32_t lastX{0u};
+	std::uint32_t lastY{0u};
+	std::uint32_t lastColour{0u};
+	for (std::size_t i = begin; i < end; ++i)
+	{
+		std::uint32_t dx{zigzag(section.positions[2u * i] - lastX)};
+		std::uint32_t dy{zigzag(section.positions[2u * i + 1u] - lastY)};
+		codeValue(coder, models.addedX, dx);
+		codeValue(coder, models.addedY, dy);
+		lastX += unzigzag(dx);
+		lastY += unzigzag(dy);
+		section.positions[2u * i] = lastX;
+		section.positions[2u * i + 1u] = lastY;
+		section.velocities[2u * i] = 0u;
+		section.velocities[2u * i + 1u] = 0u;
+
+		codeColour(coder, models, section.colours[i], lastColour);
+		lastColour = section.colours[i];
+	}
+}
+
+
+/**
+ * Code runs of zero residual pairs, each followed by one non-zero pair.
+ *
+ * @param residuals zigzagged (x, y) pairs, sized by the caller.
+ */
+template <typename Coder>
+void
+codeResiduals(
+	Coder& coder,
+	Models& models,
+	std::vector<std::uint32_t>& residuals
+)
+{
+	std::size_t const count{residuals.size() / 2u};
+	std::size_t k{0u};
+	while (k < count)
+	{
+		std::uint32_t run{0u};
+		if (!Coder::decoding)
+		{
+			while (
+				k + run < count &&
+				residuals[2u * (k + run)] == 0u &&
+				residuals[2u * (k + run) + 1u] == 0u
+			)
+			{
+				++run;
+			}
+		}
+		codeValue(coder, models.moveRun, run);
+		if (run > count - k) {
+			throwCorrupt();
+		}
+		std::fill_n(residuals.begin() + 2u * k, 2u * run, 0u);
+		k += run;
+		if (k == count) {
+			break;
+		}
+
+		codeValue(coder, models.movedX, residuals[2u * k]);
+		codeValue(coder, models.movedY, residuals[2u * k + 1u]);
+		++k;
+	}
+}
+
+
+/**
+ * Code the vertices of primitives which were matched to the previous frame.
+ *
+ * Each vertex is predicted to move as it did in the previous frame. The error
+ * in that prediction is in turn predicted to be that of the vertex before it
+ * in the same primitive, so resting or steadily moving bodies cost almost
+ * nothing, and accelerating bodies little more than one vertex each.
+ */
+template <typename Coder>
+void
+codeMatchedVertices(
+	Coder& coder,
+	Models& models,
+	Scratch& scratch,
+	QuantisedSection const& previous,
+	QuantisedSection& current
+)
+{
+	auto const& matches = scratch.matches;
+	auto& residuals = scratch.residuals;
+	residuals.resize(2u * matches.size());
+
+	std::array<std::uint32_t, 2u> lastErrors{};
+	if (!Coder::decoding)
+	{
+		for (std::size_t k = 0u; k < matches.size(); ++k)
+		{
+			auto const& match = matches[k];
+			if (match.startsPrimitive) {
+				lastErrors.fill(0u);
+			}
+			for (unsigned axis = 0u; axis < 2u; ++axis)
+			{
+				auto const i = 2u * match.current + axis;
+				auto const j = 2u * match.previous + axis;
+				current.velocities[i] =
+					current.positions[i] - previous.positions[j];
+				auto const error = current.velocities[i] -
+					previous.velocities[j];
+				residuals[2u * k + axis] = zigzag(error - lastErrors[axis]);
+				lastErrors[axis] = error;
+			}
+		}
+	}
+
+	codeResiduals(coder, models, residuals);
+
+	if (Coder::decoding)
+	{
+		for (std::size_t k = 0u; k < matches.size(); ++k)
+		{
+			auto const& match = matches[k];
+			if (match.startsPrimitive) {
+				lastErrors.fill(0u);
+			}
+			for (unsigned axis = 0u; axis < 2u; ++axis)
+			{
+				auto const i = 2u * match.current + axis;
+				auto const j = 2u * match.previous + axis;
+				lastErrors[axis] += unzigzag(residuals[2u * k + axis]);
+				current.velocities[i] =
+					previous.velocities[j] + lastErrors[axis];
+				current.positions[i] =
+					previous.positions[j] + current.velocities[i];
+			}
+		}
+	}
+
+	// Colours: runs of unchanged colours, each followed by a new colour.
+	std::size_t k{0u};
+	while (k < matches.size())
+	{
+		std::uint32_t run{0u};
+		if (!Coder::decoding)
+		{
+			while (
+				k + run < matches.size() &&
+				current.colours[matches[k + run].current] ==
+					previous.colours[matches[k + run].previous]
+			)
+			{
+				++run;
+			}
+		}
+		codeValue(coder, models.colourRun, run);
+		if (run > matches.size() - k) {
+			throwCorrupt();
+		}
+		for (; run > 0u; --run, ++k)
+		{
+			current.colours[matches[k].current] =
+				previous.colours[matches[k].previous];
+		}
+		if (k == matches.size()) {
+			break;
+		}
+
+		auto const index = matches[k].current;
+		codeColour(
+			coder,
+			models,
+			current.colours[index],
+			index > 0u ? current.colours[index - 1u] : 0u
+		);
+		++k;
+	}
+}
+
+
+/** Whether two vertices are close enough to be the same one, moved. */
+bool
+isNear(
+	QuantisedSection const& previous,
+	std::size_t const previousVertex,
+	QuantisedSection const& current,
+	std::size_t const currentVertex,
+	std::uint32_t const maxDistance
+) noexcept
+{
+	for (unsigned axis = 0u; axis < 2u; ++axis)
+	{
+		auto const delta = current.positions[2u * currentVertex + axis] -
+			previous.positions[2u * previousVertex + axis];
+		if (std::min(delta, 0u - delta) > maxDistance) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/**
+ * Find the longest common prefix and suffix of two primitive lists.
+ *
+ * Primitives match if they have the same size and their first vertices are
+ * within @p maxDistance of each other, so that a primitive inserted among
+ * others of the same size doesn't shift every match after it.
+ */
+void
+matchPrimitives(
+	QuantisedSection const& previous,
+	QuantisedSection const& current,
+	std::uint32_t const maxDistance,
+	std::uint32_t& prefix,
+	std::uint32_t& suffix
+) noexcept
+{
+	auto const common = std::min(previous.sizes.size(), current.sizes.size());
+	std::size_t vertex{0u};
+	prefix = 0u;
+	while (
+		prefix < common &&
+		previous.sizes[prefix] == current.sizes[prefix] &&
+		(
+			current.sizes[prefix] == 0u ||
+			isNear(previous, vertex, current, vertex, maxDistance)
+		)
+	)
+	{
+		vertex += current.sizes[prefix++];
+	}
+
+	std::size_t previousEnd{previous.colours.size()};
+	std::size_t currentEnd{current.colours.size()};
+	suffix = 0u;
+	while (prefix + suffix < common)
+	{
+		auto const size = current.sizes[current.sizes.size() - 1u - suffix];
+		if (
+			previous.sizes[previous.sizes.size() - 1u - suffix] != size ||
+			(
+				size != 0u &&
+				!isNear(
+					previous,
+					previousEnd - size,
+					current,
+					currentEnd - size,
+					maxDistance
+				)
+			)
+		)
+		{
+			break;
+		}
+		previousEnd -= size;
+		currentEnd -= size;
+		++suffix;
+	}
+}
+
+
+template <typename Coder>
+void
+codeSection(
+	Coder& coder,
+	Models& models,
+	Scratch& scratch,
+	QuantisedSection const* const pPrevious,
+	QuantisedSection& current
+)
+{
+	std::uint32_t polygonCount(current.sizes.size());
+	codeValue(coder, models.count, polygonCount);
+	if (polygonCount > maxPolygons) {
+		throwCorrupt();
+	}
+	current.sizes.resize(polygonCount);
+
+	// Primitives common to the start and end of both frames are matched; the
+	// rest are coded as though new.
+	std::uint32_t prefix{0u};
+	std::uint32_t suffix{0u};
+	std::size_t const previousCount{pPrevious ? pPrevious->sizes.size() : 0u};
+	if (pPrevious)
+	{
+		if (!Coder::decoding) {
+			matchPrimitives(
+				*pPrevious, current, scratch.matchDistance, prefix, suffix);
+		}
+		codeValue(coder, models.count, prefix);
+		codeValue(coder, models.count, suffix);
+		if (
+			std::uint64_t(prefix) + suffix >
+				std::min<std::uint64_t>(previousCount, polygonCount)
+		)
+		{
+			throwCorrupt();
+		}
+		std::copy_n(pPrevious->sizes.begin(), prefix, current.sizes.begin());
+		std::copy_n(
+			pPrevious->sizes.end() - suffix,
+			suffix,
+			current.sizes.end() - suffix
+		);
+	}
+	for (std::size_t i = prefix; i < polygonCount - suffix; ++i) {
+		codeValue(coder, models.size, current.sizes[i]);
+	}
+
+	std::uint64_t vertexCount{0u};
+	std::uint64_t prefixVertexCount{0u};
+	std::uint64_t suffixVertexCount{0u};
+	for (std::size_t i = 0u; i < polygonCount; ++i)
+	{
+		vertexCount += current.sizes[i];
+		if (i < prefix) {
+			prefixVertexCount += current.sizes[i];
+		}
+		else if (i >= polygonCount - suffix) {
+			suffixVertexCount += current.sizes[i];
+		}
+	}
+	if (vertexCount > maxVertices) {
+		throwCorrupt();
+	}
+	current.positions.resize(2u * vertexCount);
+	current.velocities.resize(2u * vertexCount);
+	current.colours.resize(vertexCount);
+
+	codeAddedVertices(
+		coder,
+		models,
+		current,
+		prefixVertexCount,
+		vertexCount - suffixVertexCount
+	);
+	if (!pPrevious) {
+		return;
+	}
+
+	auto& matches = scratch.matches;
+	matches.clear();
+	std::uint32_t vertex{0u};
+	for (std::size_t i = 0u; i < prefix; ++i)
+	{
+		for (std::uint32_t j = 0u; j < current.sizes[i]; ++j, ++vertex) {
+			matches.push_back({vertex, vertex, j == 0u});
+		}
+	}
+	std::uint32_t currentVertex(vertexCount - suffixVertexCount);
+	std::uint32_t previousVertex(
+		pPrevious->colours.size() - suffixVertexCount);
+	for (std::size_t i = polygonCount - suffix; i < polygonCount; ++i)
+	{
+		for (std::uint32_t j = 0u; j < current.sizes[i]; ++j)
+		{
+			matches.push_back({currentVertex++, previousVertex++, j == 0u});
+		}
+	}
+	codeMatchedVertices(coder, models, scratch, *pPrevious, current);
+}
+
+
+template <typename Coder>
+void
+codeFrame(
+	Coder& coder,
+	Scratch& scratch,
+	QuantisedFrame const* const pPrevious,
+	QuantisedFrame& current
+)
+{
+	Models models;
+	for (std::size_t i = 0u; i < current.size(); ++i)
+	{
+		auto& section = current[i];
+		if (pPrevious) {
+			section.mode = (*pPrevious)[i].mode;
+		}
+		else {
+			codeValue(coder, models.count, section.mode);
+		}
+		codeSection(
+			coder,
+			models,
+			scratch,
+			pPrevious ? &(*pPrevious)[i] : nullptr,
+			section
+		);
+	}
+}
+
+
+std::uint32_t
+quantise(float const value, float const inverseQuantum) noexcept
+{
+	double const scaled{std::round(double(value) * inverseQuantum)};
+	double const limit{std::numeric_limits<std::int32_t>::max()};
+	return std::uint32_t(
+		std::int32_t(std::max(-limit, std::min(scaled, limit))));
+}
+
+
+std::uint32_t
+packColour(b2Color const& colour) noexcept
+{
+	auto const channel = [](float const value) {
+		return std::uint32_t(std::max(0.0f, std::min(value, 1.0f)) * 255.0f +
+			0.5f);
+	};
+	return channel(colour.r)
+		| (channel(colour.g) << 8)
+		| (channel(colour.b) << 16)
+		| (channel(colour.a) << 24);
+}
+
+
+} // namespace
+
+
+class DeltaEncoder
+{
+public:
+	explicit DeltaEncoder(float const quantum)
+		:	m_inverseQuantum{1.0f / quantum}
+		,	m_previous{}
+		,	m_current{}
+		,	m_scratch{}
+		,	m_hasPrevious{false}
+	{
+		m_scratch.matchDistance = std::uint32_t(
+			std::min(matchDistance / quantum, 1.0e9f));
+	}
+
+	/**
+	 * Encode a frame.
+	 *
+	 * @param keyframe whether a keyframe is wanted. Also set if one is needed.
+	 */
+	void encode(
+		FrameView const& frame,
+		bool& keyframe,
+		std::vector<unsigned char>& payload
+	)
+	{
+		quantiseFrame(frame);
+
+		keyframe = keyframe || !m_hasPrevious ||
+			m_previous.size() != m_current.size();
+		for (std::size_t i = 0u; !keyframe && i < m_current.size(); ++i) {
+			keyframe = m_previous[i].mode != m_current[i].mode;
+		}
+
+		payload.clear();
+		RangeEncoder encoder{payload};
+		codeFrame(
+			encoder, m_scratch, keyframe ? nullptr : &m_previous, m_current);
+		encoder.flush();
+
+		std::swap(m_previous, m_current);
+		m_hasPrevious = true;
+	}
+
+private:
+	void quantiseFrame(FrameView const& frame)
+	{
+		m_current.resize(frame.sectionCount);
+		for (std::size_t i = 0u; i < frame.sectionCount; ++i)
+		{
+			auto const& primitives = frame.sections[i].primitives;
+			auto& section = m_current[i];
+			section.mode = frame.sections[i].mode;
+			section.sizes.clear();
+			section.positions.clear();
+			section.colours.clear();
+			for (std::size_t j = 0u; j < primitives.polygonCount; ++j)
+			{
+				auto const size = std::max<GLsizei>(
+					primitives.pPolygonSizes[j], 0);
+				section.sizes.push_back(size);
+				auto const pBegin =
+					primitives.pVertices + primitives.pFirstIndices[j];
+				for (auto pVertex = pBegin; pVertex != pBegin + size; ++pVertex)
+				{
+					section.positions.push_back(
+						quantise(pVertex->first.x, m_inverseQuantum));
+					section.positions.push_back(
+						quantise(pVertex->first.y, m_inverseQuantum));
+					section.colours.push_back(packColour(pVertex->second));
+				}
+			}
+		}
+	}
+
+	float m_inverseQuantum;
+	QuantisedFrame m_previous;
+	QuantisedFrame m_current;
+	Scratch m_scratch;
+	bool m_hasPrevious;
+};
+
+
+class DeltaDecoder
+{
+public:
+	explicit DeltaDecoder(float const quantum)
+		:	m_quantum{quantum}
+		,	m_previous{}
+		,	m_current{}
+		,	m_scratch{}
+		,	m_vertices{}
+		,	m_firstIndices{}
+		,	m_polygonSizes{}
+	{
+	}
+
+	/** Decode a frame, which must follow the last unless a keyframe. */
+	void decode(
+		bool const keyframe,
+		std::size_t const sectionCount,
+		unsigned char const* const pPayload,
+		std::size_t const payloadSize
+	)
+	{
+		if (
+			sectionCount > FrameView::s_maxSections ||
+			(!keyframe && sectionCount != m_previous.size())
+		)
+		{
+			throwCorrupt();
+		}
+
+		m_current.resize(sectionCount);
+		RangeDecoder decoder{pPayload, payloadSize};
+		codeFrame(
+			decoder, m_scratch, keyframe ? nullptr : &m_previous, m_current);
+		if (decoder.overrun()) {
+			throwCorrupt();
+		}
+		std::swap(m_previous, m_current);
+	}
+
+	/** View the last frame decoded. */
+	FrameView frame(std::uint32_t const flags)
+	{
+		FrameView view;
+		view.flags = flags;
+		view.sectionCount = m_previous.size();
+		for (std::size_t i = 0u; i < m_previous.size(); ++i)
+		{
+			auto const& section = m_previous[i];
+			auto& vertices = m_vertices[i];
+			auto& firstIndices = m_firstIndices[i];
+			auto& polygonSizes = m_polygonSizes[i];
+
+			vertices.resize(section.colours.size());
+			for (std::size_t j = 0u; j < vertices.size(); ++j)
+			{
+				auto const colour = section.colours[j];
+				vertices[j] = {
+					b2Vec2{
+						float(std::int32_t(section.positions[2u * j])) *
+							m_quantum,
+						float(std::int32_t(section.positions[2u * j + 1u])) *
+							m_quantum
+					},
+					b2Color{
+						float(colour & 0xffu) / 255.0f,
+						float((colour >> 8) & 0xffu) / 255.0f,
+						float((colour >> 16) & 0xffu) / 255.0f,
+						float(colour >> 24) / 255.0f
+					}
+				};
+			}
+
+			firstIndices.resize(section.sizes.size());
+			polygonSizes.resize(section.sizes.size());
+			GLint first{0};
+			for (std::size_t j = 0u; j < section.sizes.size(); ++j)
+			{
+				firstIndices[j] = first;
+				polygonSizes[j] = GLsizei(section.sizes[j]);
+				first += polygonSizes[j];
+			}
+
+			view.sections[i] = {
+				GLenum(section.mode),
+				PrimitiveView{
+					vertices.data(),
+					vertices.size(),
+					firstIndices.data(),
+					polygonSizes.data(),
+					polygonSizes.size()
+				}
+			};
+		}
+		return view;
+	}
+
+private:
+	float m_quantum;
+	QuantisedFrame m_previous;
+	QuantisedFrame m_current;
+	Scratch m_scratch;
+
+	std::array<std::vector<Vertex>, FrameView::s_maxSections> m_vertices;
+	std::array<std::vector<GLint>, FrameView::s_maxSections> m_firstIndices;
+	std::array<std::vector<GLsizei>, FrameView::s_maxSections>
+		m_polygonSizes;
+};
+
+
+DeltaStreamWriter::DeltaStreamWriter(
+	std::string const& path,
+	float const quantum,
+	unsigned const keyframeInterval,
+	std::size_t const maxQueuedFrames
+)
+	:	AsyncFrameSink{maxQueuedFrames}
+	,	m_pFile{nullptr}
+	,	m_pEncoder{}
+	,	m_payload{}
+	,	m_keyframeInterval{std::max(keyframeInterval, 1u)}
+	,	m_framesSinceKeyframe{0u}
+	,	m_bytesWritten{sizeof(StreamHeader)}
+{
+	if (!(quantum > 0.0f)) {
+		throw std::runtime_error{"Delta stream quantum must be positive"};
+	}
+	m_pEncoder.reset(new DeltaEncoder{quantum});
+
+	m_pFile = std::fopen(path.c_str(), "wb");
+	if (!m_pFile) {
+		throw std::runtime_error{"Unable to open delta stream " + path};
+	}
+
+	StreamHeader const header{
+		streamMagic, streamVersion, quantum, m_keyframeInterval};
+	if (std::fwrite(&header, sizeof(header), 1, m_pFile) != 1)
+	{
+		std::fclose(m_pFile);
+		throw std::runtime_error{"Unable to write delta stream " + path};
+	}
+
+	start();
+}
+
+
+DeltaStreamWriter::~DeltaStreamWriter() noexcept
+{
+	try
+	{
+		close();
+	}
+	catch (...)
+	{
+	}
+}
+
+
+bool
+DeltaStreamWriter::consume(void const* const pRecord, std::size_t const size)
+{
+	FrameView frame;
+	if (!readFrameRecord(pRecord, size, frame)) {
+		return false;
+	}
+
+	bool keyframe{m_framesSinceKeyframe == 0u};
+	m_pEncoder->encode(frame, keyframe, m_payload);
+	m_framesSinceKeyframe = keyframe ? 1u : m_framesSinceKeyframe + 1u;
+	if (m_framesSinceKeyframe == m_keyframeInterval) {
+		m_framesSinceKeyframe = 0u;
+	}
+
+	PacketHeader const header{
+		packetMagic,
+		keyframe ? PacketType::keyframe : PacketType::delta,
+		frame.flags,
+		std::uint32_t(frame.sectionCount),
+		m_payload.size()
+	};
+	if (
+		std::fwrite(&header, sizeof(header), 1, m_pFile) != 1 ||
+		std::fwrite(m_payload.data(), 1, m_payload.size(), m_pFile) !=
+			m_payload.size()
+	)
+	{
+		return false;
+	}
+	m_bytesWritten += sizeof(header) + m_payload.size();
+
+	// Keep at most one keyframe interval unwritten if the process dies.
+	return !keyframe || std::fflush(m_pFile) == 0;
+}
+
+
+void
+DeltaStreamWriter::close()
+{
+	if (!m_pFile) {
+		return;
+	}
+	stop();
+
+	bool const ok{(std::fclose(m_pFile) == 0) && !failed()};
+	m_pFile = nullptr;
+	if (!ok) {
+		throw std::runtime_error{"Failed to write delta stream"};
+	}
+}
+
+
+DeltaStreamReader::DeltaStreamReader(std::string const& path)
+	:	m_pData{nullptr}
+	,	m_size{0u}
+	,	m_quantum{0.0f}
+	,	m_packets{}
+	,	m_pDecoder{}
+	,	m_decodedIndex{0u}
+{
+	int const fd{::open(path.c_str(), O_RDONLY)};
+	if (fd < 0) {
+		throw std::runtime_error{"Unable to open delta stream " + path};
+	}
+
+	struct stat status;
+	if (::fstat(fd, &status) != 0 || std::size_t(status.st_size) <
+		sizeof(StreamHeader))
+	{
+		::close(fd);
+		throw std::runtime_error{"Invalid delta stream " + path};
+	}
+	m_size = status.st_size;
+
+	void* const pMapping{
+		::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0)};
+	::close(fd);
+	if (pMapping == MAP_FAILED) {
+		throw std::runtime_error{"Unable to map delta stream " + path};
+	}
+	m_pData = static_cast<char const*>(pMapping);
+
+	StreamHeader header;
+	std::memcpy(&header, m_pData, sizeof(header));
+	if (
+		header.magic != streamMagic ||
+		header.version != streamVersion ||
+		!(header.quantum > 0.0f)
+	)
+	{
+		::munmap(pMapping, m_size);
+		throw std::runtime_error{"Invalid delta stream " + path};
+	}
+	m_quantum = header.quantum;
+	m_pDecoder.reset(new DeltaDecoder{m_quantum});
+
+	// Index every complete packet; a trailing partial one is ignored.
+	std::size_t offset{sizeof(StreamHeader)};
+	while (m_size - offset >= sizeof(PacketHeader))
+	{
+		PacketHeader packet;
+		std::memcpy(&packet, m_pData + offset, sizeof(packet));
+		if (
+			packet.magic != packetMagic ||
+			packet.payloadSize > m_size - offset - sizeof(PacketHeader)
+		)
+		{
+			break;
+		}
+		m_packets.push_back({offset, packet.type == PacketType::keyframe});
+		offset += sizeof(PacketHeader) + packet.payloadSize;
+	}
+	m_decodedIndex = m_packets.size();
+}
+
+
+DeltaStreamReader::~DeltaStreamReader() noexcept
+{
+	::munmap(const_cast<char*>(m_pData), m_size);
+}
+
+
+void
+DeltaStreamReader::decode(std::size_t const index)
+{
+	PacketHeader header;
+	auto const pPacket = m_pData + m_packets[index].offset;
+	std::memcpy(&header, pPacket, sizeof(header));
+	m_decodedIndex = m_packets.size();
+	m_pDecoder->decode(
+		header.type == PacketType::keyframe,
+		header.sectionCount,
+		reinterpret_cast<unsigned char const*>(pPacket + sizeof(header)),
+		header.payloadSize
+	);
+	m_decodedIndex = index;
+}
+
+
+FrameView
+DeltaStreamReader::frame(std::size_t const index)
+{
+	if (index >= m_packets.size()) {
+		throw std::out_of_range{"Delta stream frame index out of range"};
+	}
+
+	std::size_t keyframe{index};
+	while (!m_packets[keyframe].keyframe)
+	{
+		if (keyframe == 0u) {
+			throwCorrupt();
+		}
+		--keyframe;
+	}
+
+	std::size_t next{keyframe};
+	if (
+		m_decodedIndex < m_packets.size() &&
+		m_decodedIndex >= keyframe &&
+		m_decodedIndex <= index
+	)
+	{
+		next = m_decodedIndex + 1u;
+	}
+	for (; next <= index; ++next) {
+		decode(next);
+	}
+
+	PacketHeader header;
+	std::memcpy(&header, m_pData + m_packets[index].offset, sizeof(header));
+	return m_pDecoder->frame(header.flags);
+}
+
+
+} // namespace b2draw
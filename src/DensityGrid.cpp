@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "b2draw/algorithm.h"
+#include "b2draw/DensityGrid.h"
+
+
+namespace b2draw {
+namespace {
+
+
+/** Fewer items than this per thread aren't worth waking a thread for. */
+constexpr std::size_t minItemsPerWorker{1u << 14};
+
+
+} // namespace
+
+
+DensityGrid::DensityGrid(ResourcePool& pool, WorkerPool& workers)
+	:	m_pPool{&pool}
+	,	m_pWorkers{&workers}
+	,	m_buffer{0u, 0u, nullptr, 0, 0u, 0u, 0u}
+	,	m_hasBuffer{false}
+	,	m_texture{0u}
+	,	m_textureWidth{0u}
+	,	m_textureHeight{0u}
+	,	m_lower{0.0f, 0.0f}
+	,	m_upper{0.0f, 0.0f}
+	,	m_width{0u}
+	,	m_height{0u}
+	,	m_points{}
+	,	m_pCounts{}
+	,	m_countCapacity{0u}
+	,	m_levels{}
+	,	m_maxCount{0u}
+{
+}
+
+
+DensityGrid::DensityGrid(DensityGrid&& other) noexcept
+	:	m_pPool{other.m_pPool}
+	,	m_pWorkers{other.m_pWorkers}
+	,	m_buffer{other.m_buffer}
+	,	m_hasBuffer{other.m_hasBuffer}
+	,	m_texture{other.m_texture}
+	,	m_textureWidth{other.m_textureWidth}
+	,	m_textureHeight{other.m_textureHeight}
+	,	m_lower{other.m_lower}
+	,	m_upper{other.m_upper}
+	,	m_width{other.m_width}
+	,	m_height{other.m_height}
+	,	m_points{std::move(other.m_points)}
+	,	m_pCounts{std::move(other.m_pCounts)}
+	,	m_countCapacity{other.m_countCapacity}
+	,	m_levels{std::move(other.m_levels)}
+	,	m_maxCount{other.m_maxCount}
+{
+	other.m_hasBuffer = false;
+	other.m_texture = 0u;
+	other.m_countCapacity = 0u;
+}
+
+
+DensityGrid&
+DensityGrid::operator=(DensityGrid&& other) noexcept
+{
+	if (this != &other)
+	{
+		releaseResources();
+		m_pPool = other.m_pPool;
+		m_pWorkers = other.m_pWorkers;
+		m_buffer = other.m_buffer;
+		m_hasBuffer = other.m_hasBuffer;
+		m_texture = other.m_texture;
+		m_textureWidth = other.m_textureWidth;
+		m_textureHeight = other.m_textureHeight;
+		m_lower = other.m_lower;
+		m_upper = other.m_upper;
+		m_width = other.m_width;
+		m_height = other.m_height;
+		m_points = std::move(other.m_points);
+		m_pCounts = std::move(other.m_pCounts);
+		m_countCapacity = other.m_countCapacity;
+		m_levels = std::move(other.m_levels);
+		m_maxCount = other.m_maxCount;
+
+		other.m_hasBuffer = false;
+		other.m_texture = 0u;
+		other.m_countCapacity = 0u;
+	}
+	return *this;
+}
+
+
+DensityGrid::~DensityGrid() noexcept
+{
+	releaseResources();
+}
+
+
+void
+DensityGrid::releaseResources() noexcept
+{
+	if (m_texture)
+	{
+		glDeleteTextures(1, &m_texture);
+		m_texture = 0u;
+	}
+	if (m_hasBuffer)
+	{
+		m_pPool->release(m_buffer);
+		m_hasBuffer = false;
+	}
+}
+
+
+void
+DensityGrid::setView(
+	b2Vec2 const& lower,
+	b2Vec2 const& upper,
+	unsigned const width,
+	unsigned const height
+)
+{
+	m_lower = lower;
+	m_upper = upper;
+	m_width = width;
+	m_height = height;
+
+	auto const cells = cellCount();
+	if (cells > m_countCapacity)
+	{
+		m_pCounts.reset(new std::atomic<std::uint32_t>[cells]);
+		for (std::size_t i = 0; i < cells; ++i)
+		{
+			m_pCounts[i].store(0u, std::memory_order_relaxed);
+		}
+		m_countCapacity = cells;
+	}
+	m_levels.assign(cells, 0u);
+}
+
+
+void
+DensityGrid::bin()
+{
+	auto const cells = cellCount();
+	m_maxCount = 0u;
+	b2Vec2 const extents{m_upper - m_lower};
+	if (!cells || extents.x <= 0.0f || extents.y <= 0.0f)
+	{
+		std::fill(m_levels.begin(), m_levels.end(), 0u);
+		return;
+	}
+
+	// Count concurrently, each worker noting the highest count it reached;
+	// the fullest cell's count is the highest of these.
+	float32 const columnScale{float32(m_width) / extents.x};
+	float32 const rowScale{float32(m_height) / extents.y};
+	auto const counters =
+		algorithm::workerCount(m_points.size(), minItemsPerWorker);
+	std::vector<std::uint32_t> maxima(counters, 0u);
+	m_pWorkers->parallelFor(
+		m_points.size(),
+		counters,
+		[&](std::size_t begin, std::size_t const end, std::size_t worker) {
+			std::uint32_t highest{0u};
+			for (; begin < end; ++begin)
+			{
+				auto const& point = m_points[begin];
+				float32 const x{(point.x - m_lower.x) * columnScale};
+				float32 const y{(point.y - m_lower.y) * rowScale};
+				// Also skips NaNs.
+				if (!(x >= 0.0f && x < m_width && y >= 0.0f && y < m_height)) {
+					continue;
+				}
+				auto& count =
+					m_pCounts[std::size_t(y) * m_width + std::size_t(x)];
+				auto const previous =
+					count.fetch_add(1u, std::memory_order_relaxed);
+				highest = std::max(highest, previous + 1u);
+			}
+			maxima[worker] = highest;
+		}
+	);
+	m_maxCount = *std::max_element(maxima.begin(), maxima.end());
+
+	// Convert to levels, zeroing the counts for next time.
+	float32 const levelScale{
+		m_maxCount ? 255.0f / std::log1p(float32(m_maxCount)) : 0.0f};
+	m_pWorkers->parallelFor(
+		cells,
+		algorithm::workerCount(cells, minItemsPerWorker),
+		[&](std::size_t begin, std::size_t const end, std::size_t) {
+			for (; begin < end; ++begin)
+			{
+				auto const count =
+					m_pCounts[begin].load(std::memory_order_relaxed);
+				if (!count)
+				{
+					m_levels[begin] = 0u;
+					continue;
+				}
+				m_pCounts[begin].store(0u, std::memory_order_relaxed);
+
+				// Keep occupied cells distinguishable from empty ones.
+				auto const level =
+					std::lround(std::log1p(float32(count)) * levelScale);
+				m_levels[begin] = static_cast<unsigned char>(
+					std::max(level, 1l));
+			}
+		}
+	);
+}
+
+
+void
+DensityGrid::bufferData()
+{
+	bin();
+	if (!cellCount()) {
+		return;
+	}
+
+	if (!m_texture)
+	{
+		glGenTextures(1, &m_texture);
+		if (!m_texture) {
+			throw std::runtime_error{"Failed to create density texture"};
+		}
+	}
+	if (!m_hasBuffer)
+	{
+		// Only the vertex array is used; the quad is generated in the shader.
+		m_buffer = m_pPool->acquire();
+		m_hasBuffer = true;
+	}
+
+	GLint unpackAlignment{4};
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glBindTexture(GL_TEXTURE_2D, m_texture);
+	if (m_textureWidth != m_width || m_textureHeight != m_height)
+	{
+		glTexImage2D(
+			GL_TEXTURE_2D, 0, GL_R8, m_width, m_height, 0, GL_RED,
+			GL_UNSIGNED_BYTE, m_levels.data());
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		m_textureWidth = m_width;
+		m_textureHeight = m_height;
+	}
+	else
+	{
+		glTexSubImage2D(
+			GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RED,
+			GL_UNSIGNED_BYTE, m_levels.data());
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+}
+
+
+void
+DensityGrid::render() noexcept
+{
+	if (!m_texture || !m_hasBuffer || !cellCount()) {
+		return;
+	}
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, m_texture);
+	glBindVertexArray(m_buffer.vao);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+
+} // namespace b2draw
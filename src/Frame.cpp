@@ -0,0 +1,163 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "b2draw/Frame.h"
+
+
+namespace b2draw {
+namespace {
+
+
+constexpr std::uint32_t recordMagic = 0x52463242u; // "B2FR"
+
+
+struct RecordHeader
+{
+	std::uint32_t magic;
+	std::uint32_t flags;
+	std::uint32_t sectionCount;
+	std::uint32_t reserved;
+	std::uint64_t size;
+};
+
+
+struct SectionHeader
+{
+	std::uint32_t mode;
+	std::uint32_t vertexCount;
+	std::uint32_t polygonCount;
+	std::uint32_t reserved;
+};
+
+
+static_assert(sizeof(RecordHeader) % 8 == 0, "Records must stay aligned");
+static_assert(sizeof(SectionHeader) % 8 == 0, "Sections must stay aligned");
+static_assert(sizeof(Vertex) % 8 == 0, "Vertex arrays must stay aligned");
+
+
+std::size_t
+sectionSize(PrimitiveView const& primitives) noexcept
+{
+	return sizeof(SectionHeader)
+		+ primitives.vertexCount * sizeof(Vertex)
+		+ primitives.polygonCount * (sizeof(GLint) + sizeof(GLsizei));
+}
+
+
+} // namespace
+
+
+std::size_t
+frameRecordSize(FrameView const& frame) noexcept
+{
+	std::size_t size{sizeof(RecordHeader)};
+	for (std::size_t i = 0; i < frame.sectionCount; ++i)
+	{
+		size += sectionSize(frame.sections[i].primitives);
+	}
+	return size;
+}
+
+
+void
+writeFrameRecord(FrameView const& frame, void* const pOut) noexcept
+{
+	auto pBytes = static_cast<char*>(pOut);
+	RecordHeader const header{
+		recordMagic,
+		frame.flags,
+		std::uint32_t(frame.sectionCount),
+		0u,
+		frameRecordSize(frame)
+	};
+	std::memcpy(pBytes, &header, sizeof(header));
+	pBytes += sizeof(header);
+
+	for (std::size_t i = 0; i < frame.sectionCount; ++i)
+	{
+		auto const& section = frame.sections[i];
+		auto const& primitives = section.primitives;
+		SectionHeader const sectionHeader{
+			section.mode,
+			std::uint32_t(primitives.vertexCount),
+			std::uint32_t(primitives.polygonCount),
+			0u
+		};
+		std::memcpy(pBytes, &sectionHeader, sizeof(sectionHeader));
+		pBytes += sizeof(sectionHeader);
+
+		// Empty vectors may have null data, which memcpy doesn't allow.
+		auto const vertexBytes = primitives.vertexCount * sizeof(Vertex);
+		if (vertexBytes) {
+			std::memcpy(pBytes, primitives.pVertices, vertexBytes);
+		}
+		pBytes += vertexBytes;
+
+		auto const firstBytes = primitives.polygonCount * sizeof(GLint);
+		auto const sizeBytes = primitives.polygonCount * sizeof(GLsizei);
+		if (primitives.polygonCount)
+		{
+			std::memcpy(pBytes, primitives.pFirstIndices, firstBytes);
+			std::memcpy(
+				pBytes + firstBytes, primitives.pPolygonSizes, sizeBytes);
+		}
+		pBytes += firstBytes + sizeBytes;
+	}
+}
+
+
+bool
+readFrameRecord(
+	void const* const pRecord,
+	std::size_t const size,
+	FrameView& frame
+) noexcept
+{
+	auto pBytes = static_cast<char const*>(pRecord);
+	auto const pHeader = reinterpret_cast<RecordHeader const*>(pBytes);
+	if (
+		size < sizeof(RecordHeader) ||
+		pHeader->magic != recordMagic ||
+		pHeader->size < sizeof(RecordHeader) ||
+		pHeader->size > size ||
+		pHeader->sectionCount > FrameView::s_maxSections
+	)
+	{
+		return false;
+	}
+
+	auto const pEnd = pBytes + pHeader->size;
+	frame.flags = pHeader->flags;
+	frame.sectionCount = pHeader->sectionCount;
+	pBytes += sizeof(RecordHeader);
+
+	for (std::size_t i = 0; i < frame.sectionCount; ++i)
+	{
+		if (pEnd - pBytes < std::ptrdiff_t(sizeof(SectionHeader))) {
+			return false;
+		}
+		auto const pSection = reinterpret_cast<SectionHeader const*>(pBytes);
+
+		auto& section = frame.sections[i];
+		section.mode = pSection->mode;
+		auto& primitives = section.primitives;
+		primitives.vertexCount = pSection->vertexCount;
+		primitives.polygonCount = pSection->polygonCount;
+		if (std::size_t(pEnd - pBytes) < sectionSize(primitives)) {
+			return false;
+		}
+		pBytes += sizeof(SectionHeader);
+
+		primitives.pVertices = reinterpret_cast<Vertex const*>(pBytes);
+		pBytes += primitives.vertexCount * sizeof(Vertex);
+		primitives.pFirstIndices = reinterpret_cast<GLint const*>(pBytes);
+		pBytes += primitives.polygonCount * sizeof(GLint);
+		primitives.pPolygonSizes = reinterpret_cast<GLsizei const*>(pBytes);
+		pBytes += primitives.polygonCount * sizeof(GLsizei);
+	}
+	return true;
+}
+
+
+} // namespace b2draw
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <cstdint>
+
+#include "b2draw/FrameArena.h"
+
+
+namespace b2draw {
+namespace {
+
+
+/** Each allocation is preceded by the index of its chunk. */
+using Header = std::size_t;
+
+
+inline std::uintptr_t
+alignUp(std::uintptr_t const value, std::size_t const alignment) noexcept
+{
+	return (value + alignment - 1u) & ~std::uintptr_t(alignment - 1u);
+}
+
+
+} // namespace
+
+
+Arena::~Arena() noexcept = default;
+
+
+void
+Arena::reset() noexcept
+{
+}
+
+
+FrameArena::FrameArena(std::size_t const chunkSize)
+	:	m_chunks{}
+	,	m_current{0u}
+	,	m_chunkSize{std::max(chunkSize, std::size_t{256u})}
+	,	m_usedBytes{0u}
+	,	m_peakBytes{0u}
+	,	m_reservedBytes{0u}
+	,	m_resetting{false}
+{
+}
+
+
+FrameArena::~FrameArena() noexcept = default;
+
+
+void*
+FrameArena::allocate(std::size_t const bytes, std::size_t const alignment)
+{
+	auto const align = std::max(alignment, alignof(Header));
+	auto const place = [align](Chunk const& chunk) {
+		auto const base = reinterpret_cast<std::uintptr_t>(chunk.pMemory.get());
+		return std::size_t(
+			alignUp(base + chunk.used + sizeof(Header), align) - base);
+	};
+	if (
+		m_chunks.empty() ||
+		m_resetting ||
+		place(m_chunks[m_current]) + bytes > m_chunks[m_current].size
+	)
+	{
+		nextChunk(bytes + align + sizeof(Header));
+		m_resetting = false;
+	}
+
+	auto& chunk = m_chunks[m_current];
+	auto const offset = place(chunk);
+	auto const pMemory = chunk.pMemory.get() + offset;
+	reinterpret_cast<Header*>(pMemory)[-1] = m_current;
+	m_usedBytes += offset + bytes - chunk.used;
+	m_peakBytes = std::max(m_peakBytes, m_usedBytes);
+	chunk.used = offset + bytes;
+	++chunk.live;
+	return pMemory;
+}
+
+
+void
+FrameArena::deallocate(
+	void* const pMemory,
+	std::size_t const,
+	std::size_t const
+) noexcept
+{
+	if (!pMemory) {
+		return;
+	}
+
+	// Rewind a chunk once nothing in it is in use, even the current one.
+	auto& chunk = m_chunks[static_cast<Header const*>(pMemory)[-1]];
+	if (--chunk.live == 0u)
+	{
+		m_usedBytes -= chunk.used;
+		chunk.used = 0u;
+	}
+}
+
+
+void
+FrameArena::reset() noexcept
+{
+	// Lazily, so that an owner resetting without allocating costs nothing.
+	m_resetting = true;
+}
+
+
+void
+FrameArena::trim() noexcept
+{
+	// Chunks keep their places, as allocations refer to them by index.
+	for (auto& chunk: m_chunks)
+	{
+		if (chunk.live == 0u && chunk.pMemory)
+		{
+			m_reservedBytes -= chunk.size;
+			chunk.pMemory.reset();
+			chunk.size = 0u;
+		}
+	}
+}
+
+
+void
+FrameArena::nextChunk(std::size_t const bytes)
+{
+	for (std::size_t i = 0; i < m_chunks.size(); ++i)
+	{
+		if (m_chunks[i].live == 0u && m_chunks[i].size >= bytes)
+		{
+			m_current = i;
+			return;
+		}
+	}
+
+	// Reuse the place of a trimmed chunk if there is one.
+	auto const size = std::max(bytes, m_chunkSize);
+	Chunk chunk{
+		std::unique_ptr<unsigned char[]>{new unsigned char[size]},
+		size,
+		0u,
+		0u
+	};
+	m_current = std::size_t(std::find_if(
+		m_chunks.begin(),
+		m_chunks.end(),
+		[](Chunk const& other) { return !other.pMemory; }
+	) - m_chunks.begin());
+	if (m_current < m_chunks.size()) {
+		m_chunks[m_current] = std::move(chunk);
+	}
+	else {
+		m_chunks.push_back(std::move(chunk));
+	}
+	m_reservedBytes += size;
+}
+
+
+} // namespace b2draw
@@ -0,0 +1,538 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include "b2draw/FrameExporter.h"
+
+
+namespace b2draw {
+namespace {
+
+
+constexpr unsigned char pngSignature[] = {
+	0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+/** The most bytes in a stored (uncompressed) deflate block. */
+constexpr std::size_t maxStoredBlock{0xffffu};
+
+
+std::uint32_t
+crc32(
+	unsigned char const* pData,
+	std::size_t const size,
+	std::uint32_t crc = 0u
+) noexcept
+{
+	static auto const table = []() {
+		std::array<std::uint32_t, 256> entries{};
+		for (std::uint32_t i = 0; i < entries.size(); ++i)
+		{
+			std::uint32_t entry{i};
+			for (int bit = 0; bit < 8; ++bit)
+			{
+				entry = (entry & 1u) ? 0xedb88320u ^ (entry >> 1) : entry >> 1;
+			}
+			entries[i] = entry;
+		}
+		return entries;
+	}();
+
+	crc = ~crc;
+	for (auto const pEnd = pData + size; pData < pEnd; ++pData)
+	{
+		crc = table[(crc ^ *pData) & 0xffu] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+
+std::uint32_t
+adler32(unsigned char const* pData, std::size_t const size) noexcept
+{
+	std::uint32_t a{1u};
+	std::uint32_t b{0u};
+	for (auto const pEnd = pData + size; pData < pEnd; ++pData)
+	{
+		a = (a + *pData) % 65521u;
+		b = (b + a) % 65521u;
+	}
+	return (b << 16) | a;
+}
+
+
+void
+appendBigEndian(std::vector<unsigned char>& bytes, std::uint32_t const value)
+{
+	bytes.push_back(static_cast<unsigned char>(value >> 24));
+	bytes.push_back(static_cast<unsigned char>(value >> 16));
+	bytes.push_back(static_cast<unsigned char>(value >> 8));
+	bytes.push_back(static_cast<unsigned char>(value));
+}
+
+
+/** Write a PNG chunk: length, type, data and the CRC of the type and data. */
+void
+writeChunk(
+	std::ofstream& file,
+	char const* const pType,
+	unsigned char const* const pData,
+	std::size_t const size
+)
+{
+	std::vector<unsigned char> header;
+	appendBigEndian(header, static_cast<std::uint32_t>(size));
+	header.insert(header.end(), pType, pType + 4);
+	auto crc = crc32(header.data() + 4, 4u);
+	crc = crc32(pData, size, crc);
+
+	std::vector<unsigned char> footer;
+	appendBigEndian(footer, crc);
+	file.write(reinterpret_cast<char const*>(header.data()), header.size());
+	file.write(reinterpret_cast<char const*>(pData), size);
+	file.write(reinterpret_cast<char const*>(footer.data()), footer.size());
+}
+
+
+} // namespace
+
+
+FrameExporter::FrameExporter(
+	std::string path,
+	Format const format,
+	GLsizei const width,
+	GLsizei const height,
+	unsigned const framesPerSecond,
+	std::size_t const ringSize,
+	std::size_t const maxQueuedFrames
+)
+	:	m_path{std::move(path)}
+	,	m_format{format}
+	,	m_width{std::max(width, 1)}
+	,	m_height{std::max(height, 1)}
+	,	m_framesPerSecond{std::max(framesPerSecond, 1u)}
+	,	m_framebuffer{0u}
+	,	m_renderbuffer{0u}
+	,	m_readbacks{}
+	,	m_nextReadback{0u}
+	,	m_framesCaptured{0u}
+	,	m_stalls{0u}
+	,	m_finished{false}
+	,	m_previousDrawFramebuffer{0}
+	,	m_previousReadFramebuffer{0}
+	,	m_previousViewport{0, 0, 0, 0}
+	,	m_mutex{}
+	,	m_condition{}
+	,	m_queue{}
+	,	m_spareImages{}
+	,	m_maxQueuedFrames{std::max<std::size_t>(maxQueuedFrames, 1u)}
+	,	m_stopping{false}
+	,	m_dropFrames{true}
+	,	m_failed{false}
+	,	m_framesWritten{0u}
+	,	m_framesDropped{0u}
+	,	m_encoded{}
+	,	m_video{}
+	,	m_thread{}
+{
+	if (m_format == Format::y4m)
+	{
+		m_video.open(m_path, std::ios::binary | std::ios::trunc);
+		m_video << "YUV4MPEG2 W" << m_width << " H" << m_height << " F"
+			<< m_framesPerSecond << ":1 Ip A1:1 C444\n";
+		if (!m_video) {
+			throw std::runtime_error{"Failed to open " + m_path};
+		}
+	}
+
+	try
+	{
+		glGenRenderbuffers(1, &m_renderbuffer);
+		glGenFramebuffers(1, &m_framebuffer);
+		if (!m_renderbuffer || !m_framebuffer) {
+			throw std::runtime_error{"Failed to create export framebuffer"};
+		}
+
+		GLint previous{0};
+		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+		glBindRenderbuffer(GL_RENDERBUFFER, m_renderbuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_width, m_height);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+		glFramebufferRenderbuffer(
+			GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+			m_renderbuffer);
+		auto const status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		glBindFramebuffer(GL_FRAMEBUFFER, previous);
+		if (status != GL_FRAMEBUFFER_COMPLETE) {
+			throw std::runtime_error{"Incomplete export framebuffer"};
+		}
+
+		// Stream, then read once: each buffer is filled by the GPU and read
+		// by the CPU.
+		GLsizeiptr const size = GLsizeiptr(m_width) * m_height * 4;
+		m_readbacks.reserve(std::max<std::size_t>(ringSize, 1u));
+		while (m_readbacks.size() < m_readbacks.capacity())
+		{
+			Readback readback{0u, nullptr, 0u};
+			glGenBuffers(1, &readback.buffer);
+			if (!readback.buffer) {
+				throw std::runtime_error{"Failed to create pixel buffer"};
+			}
+			m_readbacks.push_back(readback);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+			glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0u);
+
+		m_thread = std::thread{&FrameExporter::run, this};
+	}
+	catch (...)
+	{
+		releaseResources();
+		throw;
+	}
+}
+
+
+FrameExporter::~FrameExporter() noexcept
+{
+	finish();
+	releaseResources();
+}
+
+
+void
+FrameExporter::releaseResources() noexcept
+{
+	for (auto& readback: m_readbacks)
+	{
+		if (readback.fence) {
+			glDeleteSync(readback.fence);
+		}
+		glDeleteBuffers(1, &readback.buffer);
+	}
+	m_readbacks.clear();
+	if (m_framebuffer)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0u;
+	}
+	if (m_renderbuffer)
+	{
+		glDeleteRenderbuffers(1, &m_renderbuffer);
+		m_renderbuffer = 0u;
+	}
+}
+
+
+void
+FrameExporter::begin() noexcept
+{
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_previousDrawFramebuffer);
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &m_previousReadFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, m_previousViewport);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, m_width, m_height);
+}
+
+
+void
+FrameExporter::end()
+{
+	if (m_finished) {
+		return;
+	}
+
+	// The next buffer holds the oldest read, which must be collected first.
+	auto& readback = m_readbacks[m_nextReadback];
+	if (readback.fence && !collect(readback, false))
+	{
+		++m_stalls;
+		collect(readback, true);
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+	glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0u);
+	readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readback.frame = m_framesCaptured++;
+
+	// Make sure the fence is submitted, so that polling it can succeed.
+	glFlush();
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_previousDrawFramebuffer);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_previousReadFramebuffer);
+	glViewport(
+		m_previousViewport[0], m_previousViewport[1], m_previousViewport[2],
+		m_previousViewport[3]);
+
+	// Collect whichever earlier reads have completed, oldest first.
+	m_nextReadback = (m_nextReadback + 1) % m_readbacks.size();
+	for (std::size_t i = 0; i + 1 < m_readbacks.size(); ++i)
+	{
+		auto& pending = m_readbacks[
+			(m_nextReadback + i) % m_readbacks.size()];
+		if (pending.fence && !collect(pending, false)) {
+			break;
+		}
+	}
+}
+
+
+bool
+FrameExporter::collect(Readback& readback, bool const wait)
+{
+	auto const status = glClientWaitSync(
+		readback.fence,
+		wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+		wait ? GL_TIMEOUT_IGNORED : 0);
+	bool const signalled{
+		status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED};
+	if (!signalled && !wait) {
+		return false;
+	}
+	glDeleteSync(readback.fence);
+	readback.fence = nullptr;
+
+	Image image{{}, readback.frame};
+	{
+		// Always wait for the encoder once finishing.
+		std::unique_lock<std::mutex> lock{m_mutex};
+		if (!m_dropFrames || m_finished)
+		{
+			m_condition.wait(lock, [this] {
+				return m_queue.size() < m_maxQueuedFrames;
+			});
+		}
+		if (m_queue.size() >= m_maxQueuedFrames)
+		{
+			++m_framesDropped;
+			return true;
+		}
+		if (!m_spareImages.empty())
+		{
+			image.pixels = std::move(m_spareImages.back().pixels);
+			m_spareImages.pop_back();
+		}
+	}
+
+	std::size_t const size = std::size_t(m_width) * m_height * 4;
+	image.pixels.resize(size);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+	auto const pPixels = glMapBufferRange(
+		GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+	if (pPixels)
+	{
+		std::memcpy(image.pixels.data(), pPixels, size);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0u);
+	if (!pPixels)
+	{
+		++m_framesDropped;
+		return true;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		m_queue.push_back(std::move(image));
+	}
+	m_condition.notify_all();
+	return true;
+}
+
+
+void
+FrameExporter::finish() noexcept
+{
+	if (m_finished) {
+		return;
+	}
+	m_finished = true;
+
+	// Collect outstanding reads in the order they were made.
+	for (std::size_t i = 0; i < m_readbacks.size(); ++i)
+	{
+		auto& readback = m_readbacks[
+			(m_nextReadback + i) % m_readbacks.size()];
+		if (!readback.fence) {
+			continue;
+		}
+		try
+		{
+			collect(readback, true);
+		}
+		catch (...)
+		{
+			++m_framesDropped;
+		}
+	}
+
+	if (m_thread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock{m_mutex};
+			m_stopping = true;
+		}
+		m_condition.notify_one();
+		m_thread.join();
+	}
+	if (m_video.is_open()) {
+		m_video.close();
+	}
+}
+
+
+void
+FrameExporter::run() noexcept
+{
+	std::unique_lock<std::mutex> lock{m_mutex};
+	while (true)
+	{
+		m_condition.wait(lock, [this] {
+			return m_stopping || !m_queue.empty();
+		});
+		if (m_queue.empty()) {
+			return;
+		}
+
+		auto image = std::move(m_queue.front());
+		m_queue.pop_front();
+		lock.unlock();
+
+		bool encoded{false};
+		if (!m_failed)
+		{
+			try
+			{
+				encoded = encode(image);
+			}
+			catch (...)
+			{
+			}
+		}
+		if (encoded) {
+			++m_framesWritten;
+		}
+		else {
+			m_failed = true;
+		}
+
+		lock.lock();
+		m_spareImages.push_back(std::move(image));
+		m_condition.notify_all();
+	}
+}
+
+
+bool
+FrameExporter::encode(Image const& image)
+{
+	switch (m_format)
+	{
+		case Format::png:
+			return writePng(image);
+
+		case Format::y4m:
+			return writeY4m(image);
+
+		default:
+			return false;
+	}
+}
+
+
+bool
+FrameExporter::writePng(Image const& image)
+{
+	// Scanlines, top first, each starting with filter type 0 (none).
+	std::size_t const stride = std::size_t(m_width) * 4;
+	std::vector<unsigned char>& scanlines = m_encoded;
+	scanlines.clear();
+	scanlines.reserve((stride + 1) * m_height);
+	for (std::size_t row = m_height; row-- > 0;)
+	{
+		auto const pRow = image.pixels.data() + row * stride;
+		scanlines.push_back(0u);
+		scanlines.insert(scanlines.end(), pRow, pRow + stride);
+	}
+
+	// A zlib stream of stored deflate blocks.
+	std::vector<unsigned char> stream{0x78, 0x01};
+	stream.reserve(
+		scanlines.size() + 5 * (scanlines.size() / maxStoredBlock + 1) + 6);
+	std::size_t offset{0u};
+	do
+	{
+		auto const size = std::min(scanlines.size() - offset, maxStoredBlock);
+		bool const last{offset + size == scanlines.size()};
+		stream.push_back(last ? 1u : 0u);
+		stream.push_back(static_cast<unsigned char>(size));
+		stream.push_back(static_cast<unsigned char>(size >> 8));
+		stream.push_back(static_cast<unsigned char>(~size));
+		stream.push_back(static_cast<unsigned char>(~size >> 8));
+		stream.insert(
+			stream.end(),
+			scanlines.begin() + offset,
+			scanlines.begin() + offset + size);
+		offset += size;
+	}
+	while (offset < scanlines.size());
+	appendBigEndian(stream, adler32(scanlines.data(), scanlines.size()));
+
+	// 8-bit RGBA, no interlacing.
+	std::vector<unsigned char> header;
+	appendBigEndian(header, std::uint32_t(m_width));
+	appendBigEndian(header, std::uint32_t(m_height));
+	header.insert(header.end(), {8u, 6u, 0u, 0u, 0u});
+
+	char suffix[32];
+	std::snprintf(suffix, sizeof(suffix), "-%06zu.png", image.frame);
+	std::ofstream file{m_path + suffix, std::ios::binary | std::ios::trunc};
+	file.write(
+		reinterpret_cast<char const*>(pngSignature), sizeof(pngSignature));
+	writeChunk(file, "IHDR", header.data(), header.size());
+	writeChunk(file, "IDAT", stream.data(), stream.size());
+	writeChunk(file, "IEND", nullptr, 0u);
+	return bool(file);
+}
+
+
+bool
+FrameExporter::writeY4m(Image const& image)
+{
+	// Planar BT.601 studio-swing YUV, top row first; alpha is dropped.
+	std::size_t const pixels = std::size_t(m_width) * m_height;
+	std::vector<unsigned char>& planes = m_encoded;
+	planes.resize(3 * pixels);
+	std::size_t index{0u};
+	for (std::size_t row = m_height; row-- > 0;)
+	{
+		auto pPixel = image.pixels.data() + row * m_width * 4;
+		for (GLsizei column = 0; column < m_width; ++column, pPixel += 4)
+		{
+			int const r{pPixel[0]};
+			int const g{pPixel[1]};
+			int const b{pPixel[2]};
+			planes[index] = static_cast<unsigned char>(
+				((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+			planes[pixels + index] = static_cast<unsigned char>(
+				((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+			planes[2 * pixels + index] = static_cast<unsigned char>(
+				((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+			++index;
+		}
+	}
+
+	m_video << "FRAME\n";
+	m_video.write(reinterpret_cast<char const*>(planes.data()), planes.size());
+	m_video.flush();
+	return bool(m_video);
+}
+
+
+} // namespace b2draw
@@ -0,0 +1,425 @@
+#include <algorithm>
+#include <cassert>
+
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2World.h>
+
+#include "b2draw/IncrementalTraversal.h"
+#include "ShapeDrawing.h"
+
+
+namespace b2draw {
+namespace {
+
+
+#ifndef NDEBUG
+/** Whether @p pBody is still one of @p world's bodies, without reading it. */
+bool
+inBodyList(b2World& world, b2Body const* const pBody) noexcept
+{
+	for (auto pOther = world.GetBodyList(); pOther; pOther = pOther->GetNext())
+	{
+		if (pOther == pBody) {
+			return true;
+		}
+	}
+	return false;
+}
+#endif
+
+
+} // namespace
+
+
+/** Draws into a chunk's renderers as DebugDraw does, tracking the bounds. */
+class IncrementalTraversal::Recorder
+	:	public b2Draw
+{
+public:
+	Recorder(Chunk& chunk, Settings const& settings) noexcept
+		:	b2Draw{}
+		,	m_chunk(chunk)
+		,	m_fillAlpha{settings.fillAlpha}
+		,	m_axisScale{settings.axisScale}
+		,	m_bounds{}
+		,	m_empty{true}
+	{
+	}
+
+	virtual void DrawPolygon(
+		b2Vec2 const* pVertices,
+		int32 vertexCount,
+		b2Color const& colour
+	) override
+	{
+		m_chunk.lines.addPolygon(pVertices, vertexCount, colour);
+		extend(pVertices, vertexCount, 0.0f);
+	}
+
+	virtual void DrawSolidPolygon(
+		b2Vec2 const* pVertices,
+		int32 vertexCount,
+		b2Color const& colour
+	) override
+	{
+		m_chunk.fills.addPolygon(pVertices, vertexCount, fill(colour));
+		extend(pVertices, vertexCount, 0.0f);
+	}
+
+	virtual void DrawCircle(
+		b2Vec2 const& centre,
+		float32 radius,
+		b2Color const& colour
+	) override
+	{
+		m_chunk.lines.addCircle(centre, radius, colour);
+		extend(&centre, 1, radius);
+	}
+
+	virtual void DrawSolidCircle(
+		b2Vec2 const& centre,
+		float32 radius,
+		b2Vec2 const& axis,
+		b2Color const& colour
+	) override
+	{
+		m_chunk.fills.addCircle(centre, radius, fill(colour));
+		m_chunk.segments.addSegment(
+			centre,
+			centre + radius * axis,
+			b2Color{0.0f, 0.0f, 0.0f, 1.0f}
+		);
+		extend(&centre, 1, radius);
+	}
+
+	virtual void DrawSegment(
+		b2Vec2 const& begin,
+		b2Vec2 const& end,
+		b2Color const& colour
+	) override
+	{
+		m_chunk.segments.addSegment(begin, end, colour);
+		b2Vec2 const points[2] = {begin, end};
+		extend(points, 2, 0.0f);
+	}
+
+	virtual void DrawTransform(b2Transform const& xf) override
+	{
+		m_chunk.segments.addSegment(
+			xf.p,
+			xf.p + m_axisScale * xf.q.GetXAxis(),
+			b2Color{1.0f, 0.0f, 0.0f});
+		m_chunk.segments.addSegment(
+			xf.p,
+			xf.p + m_axisScale * xf.q.GetYAxis(),
+			b2Color{0.0f, 1.0f, 0.0f});
+		extend(&xf.p, 1, m_axisScale);
+	}
+
+	virtual void DrawPoint(b2Vec2 const&, float32, b2Color const&) override
+	{
+		// Neither shapes nor centres of mass are drawn as points.
+	}
+
+	/** The bounds of everything recorded, or a point at the origin. */
+	inline b2AABB bounds() const noexcept
+	{
+		if (!m_empty) {
+			return m_bounds;
+		}
+		b2AABB origin;
+		origin.lowerBound.SetZero();
+		origin.upperBound.SetZero();
+		return origin;
+	}
+
+private:
+	inline b2Color fill(b2Color const& colour) const noexcept
+	{
+		return b2Color{colour.r, colour.g, colour.b, m_fillAlpha};
+	}
+
+	void extend(b2Vec2 const* pPoints, int32 count, float32 margin) noexcept
+	{
+		b2Vec2 const extent{margin, margin};
+		for (int32 i = 0; i < count; ++i)
+		{
+			b2AABB box;
+			box.lowerBound = pPoints[i] - extent;
+			box.upperBound = pPoints[i] + extent;
+			if (m_empty) {
+				m_bounds = box;
+			}
+			else {
+				m_bounds.Combine(box);
+			}
+			m_empty = false;
+		}
+	}
+
+	Chunk& m_chunk;
+	float32 m_fillAlpha;
+	float32 m_axisScale;
+	b2AABB m_bounds;
+	bool m_empty;
+};
+
+
+IncrementalTraversal::IncrementalTraversal(
+	GLint const positionAttribLoc,
+	GLint const colourAttribLoc,
+	ResourcePool& pool
+)
+	:	IncrementalTraversal{
+			positionAttribLoc, colourAttribLoc, Settings{}, pool}
+{
+}
+
+
+IncrementalTraversal::IncrementalTraversal(
+	GLint const positionAttribLoc,
+	GLint const colourAttribLoc,
+	Settings const& settings,
+	ResourcePool& pool
+)
+	:	m_settings(settings)
+	,	m_pPool{&pool}
+	,	m_positionLocation{positionAttribLoc}
+	,	m_colourLocation{colourAttribLoc}
+	,	m_chunks{}
+	,	m_regionRenderer{
+			positionAttribLoc,
+			colourAttribLoc,
+			settings.numCircleSegments,
+			PrimitiveRenderer::s_defaultBufferCount,
+			pool}
+	,	m_pWorld{nullptr}
+	,	m_pNextBody{nullptr}
+	,	m_nextChunk{0u}
+	,	m_updateCount{0u}
+	,	m_passCount{0u}
+	,	m_uploadCount{0u}
+{
+}
+
+
+IncrementalTraversal::~IncrementalTraversal() noexcept = default;
+
+
+IncrementalTraversal::DestructionListener::DestructionListener(
+	IncrementalTraversal& traversal,
+	b2DestructionListener* const pChained
+) noexcept
+	:	b2DestructionListener{}
+	,	m_traversal(traversal)
+	,	m_pChained{pChained}
+{
+}
+
+
+void
+IncrementalTraversal::DestructionListener::SayGoodbye(b2Joint* const pJoint)
+{
+	if (m_pChained) {
+		m_pChained->SayGoodbye(pJoint);
+	}
+}
+
+
+void
+IncrementalTraversal::DestructionListener::SayGoodbye(
+	b2Fixture* const pFixture
+)
+{
+	// Box2D destroys a body's fixtures only while destroying the body, but
+	// before unlinking it.
+	m_traversal.removeBody(*pFixture->GetBody());
+	if (m_pChained) {
+		m_pChained->SayGoodbye(pFixture);
+	}
+}
+
+
+void
+IncrementalTraversal::removeBody(b2Body const& body) noexcept
+{
+	if (m_pNextBody == &body) {
+		m_pNextBody = m_pNextBody->GetNext();
+	}
+}
+
+
+void
+IncrementalTraversal::restart() noexcept
+{
+	m_pNextBody = nullptr;
+	m_nextChunk = 0u;
+}
+
+
+void
+IncrementalTraversal::update(b2World& world, uint32 const flags)
+{
+	using Clock = std::chrono::steady_clock;
+	auto const deadline = Clock::now() + m_settings.budget;
+	++m_updateCount;
+	m_uploadCount = 0u;
+
+	if (&world != m_pWorld)
+	{
+		m_pWorld = &world;
+		restart();
+	}
+	assert(
+		(!m_pNextBody || inBodyList(world, m_pNextBody)) &&
+		"A body was destroyed without IncrementalTraversal::removeBody");
+
+	do
+	{
+		if (!m_pNextBody)
+		{
+			m_pNextBody = world.GetBodyList();
+			m_nextChunk = 0u;
+			if (!m_pNextBody)
+			{
+				m_chunks.clear();
+				break;
+			}
+		}
+
+		recordChunk(flags);
+
+		// Drop chunks left over from a larger world, and don't record the
+		// same chunks twice in one call.
+		if (!m_pNextBody)
+		{
+			m_chunks.erase(m_chunks.begin() + m_nextChunk, m_chunks.end());
+			++m_passCount;
+			break;
+		}
+	}
+	while (Clock::now() < deadline);
+
+	if (m_settings.showRegions) {
+		updateRegions();
+	}
+}
+
+
+void
+IncrementalTraversal::render()
+{
+	for (auto& chunk: m_chunks)
+	{
+		chunk.lines.render(GL_LINE_LOOP);
+	}
+	for (auto& chunk: m_chunks)
+	{
+		chunk.fills.render(GL_TRIANGLE_FAN);
+	}
+	for (auto& chunk: m_chunks)
+	{
+		chunk.segments.render(GL_LINE_STRIP);
+	}
+	if (m_settings.showRegions) {
+		m_regionRenderer.render(GL_LINE_LOOP);
+	}
+}
+
+
+void
+IncrementalTraversal::recordChunk(uint32 const flags)
+{
+	// Each chunk is uploaded once per pass, so one buffer apiece will do.
+	if (m_nextChunk == m_chunks.size())
+	{
+		auto const renderer = [this]() {
+			return PrimitiveRenderer{
+				m_positionLocation,
+				m_colourLocation,
+				m_settings.numCircleSegments,
+				1u,
+				*m_pPool};
+		};
+		m_chunks.push_back(
+			Chunk{renderer(), renderer(), renderer(), Region{b2AABB{}, 0u}});
+		m_chunks.back().segments.setSegmentCoalescing(true);
+	}
+	auto& chunk = m_chunks[m_nextChunk++];
+	chunk.lines.clear();
+	chunk.fills.clear();
+	chunk.segments.clear();
+
+	Recorder recorder{chunk, m_settings};
+	auto const chunkSize = std::max<std::size_t>(m_settings.bodiesPerChunk, 1u);
+	for (std::size_t i = 0; i < chunkSize && m_pNextBody; ++i)
+	{
+		auto const& body = *m_pNextBody;
+		m_pNextBody = m_pNextBody->GetNext();
+
+		if (flags & b2Draw::e_shapeBit)
+		{
+			auto const& xf = body.GetTransform();
+			auto const colour = bodyColour(body);
+			for (
+				auto pFixture = body.GetFixtureList();
+				pFixture;
+				pFixture = pFixture->GetNext()
+			)
+			{
+				drawShape(recorder, *pFixture, xf, colour);
+			}
+		}
+
+		if (flags & b2Draw::e_centerOfMassBit)
+		{
+			b2Transform xf{body.GetTransform()};
+			xf.p = body.GetWorldCenter();
+			recorder.DrawTransform(xf);
+		}
+	}
+
+	chunk.region = Region{recorder.bounds(), m_updateCount};
+	chunk.lines.bufferData();
+	chunk.fills.bufferData();
+	chunk.segments.bufferData();
+	++m_uploadCount;
+}
+
+
+void
+IncrementalTraversal::updateRegions()
+{
+	m_regionRenderer.clear();
+	auto const staleAfter = float32(std::max(m_settings.staleAfter, 1u));
+	for (auto const& chunk: m_chunks)
+	{
+		if (
+			chunk.lines.empty() &&
+			chunk.fills.empty() &&
+			chunk.segments.empty()
+		)
+		{
+			continue;
+		}
+
+		auto const& bounds = chunk.region.bounds;
+		float32 const age{std::min(
+			float32(m_updateCount - chunk.region.recordedAt) / staleAfter,
+			1.0f
+		)};
+		b2Vec2 const corners[4] = {
+			bounds.lowerBound,
+			b2Vec2{bounds.upperBound.x, bounds.lowerBound.y},
+			bounds.upperBound,
+			b2Vec2{bounds.lowerBound.x, bounds.upperBound.y}
+		};
+		m_regionRenderer.addPolygon(
+			corners, 4, b2Color{age, 1.0f - age, 0.0f});
+	}
+	m_regionRenderer.bufferData();
+}
+
+
+} // namespace b2draw
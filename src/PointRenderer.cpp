@@ -0,0 +1,219 @@
+#include "b2draw/PointRenderer.h"
+
+
+namespace b2draw {
+
+
+PointRenderer::PointRenderer(
+	GLint const positionAttribLocation,
+	GLint const colourAttribLocation,
+	GLint const sizeAttribLocation,
+	ResourcePool& pool
+)
+	:	m_vertices{}
+	,	m_sizes{}
+	,	m_viewFirst{0}
+	,	m_viewSize{0}
+	,	m_pPool{&pool}
+	,	m_buffer{0u, 0u, nullptr, 0, 0u, 0u, 0u}
+	,	m_hasBuffer{false}
+	,	m_bufferedCount{0}
+	,	m_positionLocation{positionAttribLocation}
+	,	m_colourLocation{colourAttribLocation}
+	,	m_sizeLocation{sizeAttribLocation}
+	,	m_enabledLocations{{-1, -1, -1}}
+{
+}
+
+
+PointRenderer::PointRenderer(PointRenderer&& other) noexcept
+	:	m_vertices{std::move(other.m_vertices)}
+	,	m_sizes{std::move(other.m_sizes)}
+	,	m_viewFirst{0}
+	,	m_viewSize{other.m_viewSize}
+	,	m_pPool{other.m_pPool}
+	,	m_buffer{other.m_buffer}
+	,	m_hasBuffer{other.m_hasBuffer}
+	,	m_bufferedCount{other.m_bufferedCount}
+	,	m_positionLocation{other.m_positionLocation}
+	,	m_colourLocation{other.m_colourLocation}
+	,	m_sizeLocation{other.m_sizeLocation}
+	,	m_enabledLocations(other.m_enabledLocations)
+{
+	other.m_hasBuffer = false;
+}
+
+
+PointRenderer&
+PointRenderer::operator=(PointRenderer&& other) noexcept
+{
+	if (this != &other)
+	{
+		releaseBuffer();
+		m_vertices = std::move(other.m_vertices);
+		m_sizes = std::move(other.m_sizes);
+		m_viewSize = other.m_viewSize;
+		m_pPool = other.m_pPool;
+		m_buffer = other.m_buffer;
+		m_hasBuffer = other.m_hasBuffer;
+		m_bufferedCount = other.m_bufferedCount;
+		m_positionLocation = other.m_positionLocation;
+		m_colourLocation = other.m_colourLocation;
+		m_sizeLocation = other.m_sizeLocation;
+		m_enabledLocations = other.m_enabledLocations;
+		other.m_hasBuffer = false;
+	}
+	return *this;
+}
+
+
+PointRenderer::~PointRenderer() noexcept
+{
+	releaseBuffer();
+}
+
+
+void
+PointRenderer::releaseBuffer() noexcept
+{
+	if (!m_hasBuffer) {
+		return;
+	}
+
+	glBindVertexArray(m_buffer.vao);
+	for (auto const location: m_enabledLocations)
+	{
+		if (location >= 0) {
+			glDisableVertexAttribArray(location);
+		}
+	}
+	m_enabledLocations.fill(-1);
+	m_pPool->release(m_buffer);
+	m_hasBuffer = false;
+}
+
+
+void
+PointRenderer::clear() noexcept
+{
+	m_vertices.clear();
+	m_sizes.clear();
+	m_viewSize = 0;
+}
+
+
+void
+PointRenderer::bufferData()
+{
+	m_bufferedCount = GLsizei(m_vertices.size());
+	if (!m_bufferedCount) {
+		return;
+	}
+
+	if (!m_hasBuffer)
+	{
+		m_buffer = m_pPool->acquire();
+		m_hasBuffer = true;
+	}
+
+	// Orphan the old storage rather than wait for the GPU to finish with it.
+	auto const vertexBytes = m_vertices.size() * sizeof(Vertex);
+	auto const sizeBytes = m_sizes.size() * sizeof(float32);
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer.vbo);
+	glBufferData(
+		GL_ARRAY_BUFFER, vertexBytes + sizeBytes, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, vertexBytes, m_vertices.data());
+	glBufferSubData(GL_ARRAY_BUFFER, vertexBytes, sizeBytes, m_sizes.data());
+	m_buffer.capacity = vertexBytes + sizeBytes;
+	applyAttribLocations(m_vertices.size());
+}
+
+
+void
+PointRenderer::bufferData(PrimitiveView const& points, float32 const size)
+{
+	m_vertices.assign(points.pVertices, points.pVertices + points.vertexCount);
+	m_sizes.assign(points.vertexCount, size);
+	m_viewSize = GLsizei(points.vertexCount);
+	bufferData();
+}
+
+
+void
+PointRenderer::render() noexcept
+{
+	if (!m_hasBuffer || !m_bufferedCount) {
+		return;
+	}
+
+	// Leave the application's own setting as it was.
+	bool const programSize{m_sizeLocation >= 0};
+	bool const wasEnabled{glIsEnabled(GL_PROGRAM_POINT_SIZE) == GL_TRUE};
+	if (programSize && !wasEnabled) {
+		glEnable(GL_PROGRAM_POINT_SIZE);
+	}
+
+	glBindVertexArray(m_buffer.vao);
+	glDrawArrays(GL_POINTS, 0, m_bufferedCount);
+
+	if (programSize && !wasEnabled) {
+		glDisable(GL_PROGRAM_POINT_SIZE);
+	}
+}
+
+
+PrimitiveView
+PointRenderer::view() const noexcept
+{
+	return PrimitiveView{
+		m_vertices.data(),
+		m_vertices.size(),
+		&m_viewFirst,
+		&m_viewSize,
+		m_vertices.empty() ? 0u : 1u
+	};
+}
+
+
+void
+PointRenderer::applyAttribLocations(std::size_t const count) noexcept
+{
+	glBindVertexArray(m_buffer.vao);
+	for (auto const location: m_enabledLocations)
+	{
+		if (location >= 0) {
+			glDisableVertexAttribArray(location);
+		}
+	}
+
+	if (m_positionLocation >= 0)
+	{
+		glEnableVertexAttribArray(m_positionLocation);
+		glVertexAttribPointer(
+			m_positionLocation, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+			nullptr);
+	}
+
+	if (m_colourLocation >= 0)
+	{
+		glEnableVertexAttribArray(m_colourLocation);
+		glVertexAttribPointer(
+			m_colourLocation, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+			reinterpret_cast<void const*>(offsetof(Vertex, second)));
+	}
+
+	// Sizes follow the vertices, so move whenever the count changes.
+	if (m_sizeLocation >= 0)
+	{
+		glEnableVertexAttribArray(m_sizeLocation);
+		glVertexAttribPointer(
+			m_sizeLocation, 1, GL_FLOAT, GL_FALSE, sizeof(float32),
+			reinterpret_cast<void const*>(count * sizeof(Vertex)));
+	}
+
+	m_enabledLocations = {{
+		m_positionLocation, m_colourLocation, m_sizeLocation}};
+}
+
+
+} // namespace b2draw
@@ -1,88 +1,626 @@
 #include <cassert>
 #include <algorithm>
+#include <cmath>
 #include <iterator>
+#include <cstring>
 #include <stdexcept>
 
 #include "b2draw/algorithm.h"
 #include "b2draw/PrimitiveRenderer.h"
 
 namespace b2draw {
+namespace {
+
+
+char const* const strategyNames[] = {"multi-draw", "indexed", "indirect"};
+
+static_assert(
+	sizeof(strategyNames) / sizeof(strategyNames[0]) ==
+		static_cast<std::size_t>(SubmissionStrategy::count),
+	"Every SubmissionStrategy needs a name");
+
+static_assert(
+	sizeof(b2Vec2) == 2 * sizeof(GLfloat),
+	"Cullable bounds must match the culling shader's vec4");
+
+
+/** Whether two colours are exactly the same, as palette entries must be. */
+inline bool
+sameColour(b2Color const& a, b2Color const& b) noexcept
+{
+	return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+
+/** The mode used to draw indexed primitives, or 0 if not supported. */
+GLenum
+elementModeFor(GLenum const mode) noexcept
+{
+	switch (mode)
+	{
+		case GL_TRIANGLE_FAN:
+			return GL_TRIANGLES;
+
+		case GL_LINE_LOOP:
+		case GL_LINE_STRIP:
+			return GL_LINES;
+
+		default:
+			return 0u;
+	}
+}
+
+
+/** The squared distance from a point to the segment from @p p to @p q. */
+float32
+distanceSquared(b2Vec2 const& point, b2Vec2 const& p, b2Vec2 const& q) noexcept
+{
+	b2Vec2 const edge{q - p};
+	b2Vec2 const offset{point - p};
+	float32 const lengthSquared{b2Dot(edge, edge)};
+	float32 const t{lengthSquared > 0.0f
+		? b2Clamp(b2Dot(offset, edge) / lengthSquared, 0.0f, 1.0f)
+		: 0.0f};
+	b2Vec2 const nearest{offset - t * edge};
+	return b2Dot(nearest, nearest);
+}
+
+
+/**
+ * Whether a primitive's outline passes within a distance of a point, or, if
+ * @p closed, the point is inside it.
+ */
+bool
+hits(
+	Vertex const* const pVertices,
+	std::size_t const count,
+	bool const closed,
+	b2Vec2 const& point,
+	float32 const radius
+) noexcept
+{
+	float32 const radiusSquared{radius * radius};
+	if (count == 1u)
+	{
+		b2Vec2 const offset{point - pVertices[0].first};
+		return b2Dot(offset, offset) <= radiusSquared;
+	}
+
+	bool inside{false};
+	for (std::size_t i = closed ? 0u : 1u; i < count; ++i)
+	{
+		auto const& p = pVertices[i ? i - 1u : count - 1u].first;
+		auto const& q = pVertices[i].first;
+		if (distanceSquared(point, p, q) <= radiusSquared)
+		{
+			return true;
+		}
+
+		// Count crossings of a ray from the point towards +x.
+		if (
+			(p.y > point.y) != (q.y > point.y) &&
+			point.x < p.x + (point.y - p.y) * (q.x - p.x) / (q.y - p.y)
+		)
+		{
+			inside = !inside;
+		}
+	}
+	return closed && inside;
+}
+
+
+/**
+ * Make room for @p needed values, growing at least geometrically and to
+ * @p hint, as reserving exactly what's needed would copy every value on
+ * every add.
+ */
+template <typename T>
+void
+reserveGeometric(
+	ArenaVector<T>& values,
+	std::size_t const needed,
+	std::size_t const hint
+)
+{
+	if (needed > values.capacity()) {
+		values.reserve(std::max({needed, 2u * values.capacity(), hint}));
+	}
+}
+
+
+} // namespace
+
+
+char const*
+toString(SubmissionStrategy const strategy) noexcept
+{
+	auto const index = static_cast<std::size_t>(strategy);
+	return index < static_cast<std::size_t>(SubmissionStrategy::count)
+		? strategyNames[index]
+		: "";
+}
+
+
+bool
+fromString(char const* const pName, SubmissionStrategy& strategy) noexcept
+{
+	for (unsigned i = 0; i < unsigned(SubmissionStrategy::count); ++i)
+	{
+		if (std::strcmp(pName, strategyNames[i]) == 0)
+		{
+			strategy = static_cast<SubmissionStrategy>(i);
+			return true;
+		}
+	}
+	return false;
+}
 
 
 PrimitiveRenderer::PrimitiveRenderer(
 	GLint const positionAttribLocation,
 	GLint const colourAttribLocation,
-	unsigned const numCircleSegments
+	unsigned const numCircleSegments,
+	unsigned const numBuffers,
+	ResourcePool& pool,
+	Arena* const pArena
 )
-	:	m_vertices{}
-	,	m_firstIndices{}
-	,	m_polygonSizes{}
-	,	m_tmpCircleBuffer{std::max(numCircleSegments, 3u)}
-	,	m_vbo{0u}
-	,	m_vao{0u}
+	:	m_vertices{ArenaAllocator<Vertex>{pArena}}
+	,	m_firstIndices{ArenaAllocator<GLint>{pArena}}
+	,	m_polygonSizes{ArenaAllocator<GLsizei>{pArena}}
+	,	m_tmpCircleBuffer{ArenaAllocator<b2Vec2>{pArena}}
+	,	m_numCircleSegments{std::max(numCircleSegments, 3u)}
+	,	m_vertexHint{0u}
+	,	m_polygonHint{0u}
+	,	m_tags{}
+	,	m_tag{nullptr}
+	,	m_tagging{false}
+	,	m_index{}
+	,	m_tmpBounds{}
+	,	m_tmpPicks{}
+	,	m_indexed{false}
+	,	m_pPool{&pool}
+	,	m_buffers{}
+	,	m_numBuffers{std::max(numBuffers, 1u)}
+	,	m_currentBuffer{0u}
+	,	m_positionLocation{positionAttribLocation}
+	,	m_colourLocation{colourAttribLocation}
+	,	m_useFences{false}
+	,	m_useDirectStateAccess{false}
+	,	m_uploadStats{}
+	,	m_submissionStrategy{SubmissionStrategy::multiDraw}
+	,	m_tmpIndices{}
+	,	m_tmpCommands{}
+	,	m_elementMode{0u}
+	,	m_elementCount{0}
+	,	m_groupElementOffsets{}
+	,	m_preparedMode{0u}
+	,	m_prepared{false}
+	,	m_externalPrimitives{nullptr, 0u, nullptr, nullptr, 0u}
+	,	m_useExternalPrimitives{false}
+	,	m_groups{}
+	,	m_worldTransformLocation{-1}
+	,	m_cullSlots{}
+	,	m_tmpCullables{}
+	,	m_culledCommandOffset{0}
+	,	m_cullableOffset{0}
+	,	m_cullPrepared{false}
+	,	m_previousPositionLocation{-1}
+	,	m_previousBuffer{0u}
+	,	m_topology{}
+	,	m_previousTopology{}
+	,	m_canInterpolate{false}
+	,	m_coalesceSegments{false}
+	,	m_palette{}
+	,	m_paletteIndexLocation{-1}
+	,	m_tmpPaletteVertices{}
+	,	m_paletteBuffers{}
+{
+}
+
+
+PrimitiveRenderer::PrimitiveRenderer(PrimitiveRenderer&& other) noexcept
+	:	m_vertices{std::move(other.m_vertices)}
+	,	m_firstIndices{std::move(other.m_firstIndices)}
+	,	m_polygonSizes{std::move(other.m_polygonSizes)}
+	,	m_tmpCircleBuffer{std::move(other.m_tmpCircleBuffer)}
+	,	m_numCircleSegments{other.m_numCircleSegments}
+	,	m_vertexHint{other.m_vertexHint}
+	,	m_polygonHint{other.m_polygonHint}
+	,	m_tags{std::move(other.m_tags)}
+	,	m_tag{other.m_tag}
+	,	m_tagging{other.m_tagging}
+	,	m_index{std::move(other.m_index)}
+	,	m_tmpBounds{std::move(other.m_tmpBounds)}
+	,	m_tmpPicks{std::move(other.m_tmpPicks)}
+	,	m_indexed{other.m_indexed}
+	,	m_pPool{other.m_pPool}
+	,	m_buffers{std::move(other.m_buffers)}
+	,	m_numBuffers{other.m_numBuffers}
+	,	m_currentBuffer{other.m_currentBuffer}
+	,	m_positionLocation{other.m_positionLocation}
+	,	m_colourLocation{other.m_colourLocation}
+	,	m_useFences{other.m_useFences}
+	,	m_useDirectStateAccess{other.m_useDirectStateAccess}
+	,	m_uploadStats{other.m_uploadStats}
+	,	m_submissionStrategy{other.m_submissionStrategy}
+	,	m_tmpIndices{std::move(other.m_tmpIndices)}
+	,	m_tmpCommands{std::move(other.m_tmpCommands)}
+	,	m_elementMode{other.m_elementMode}
+	,	m_elementCount{other.m_elementCount}
+	,	m_groupElementOffsets{std::move(other.m_groupElementOffsets)}
+	,	m_preparedMode{other.m_preparedMode}
+	,	m_prepared{other.m_prepared}
+	,	m_externalPrimitives{other.m_externalPrimitives}
+	,	m_useExternalPrimitives{other.m_useExternalPrimitives}
+	,	m_groups{std::move(other.m_groups)}
+	,	m_worldTransformLocation{other.m_worldTransformLocation}
+	,	m_cullSlots{std::move(other.m_cullSlots)}
+	,	m_tmpCullables{std::move(other.m_tmpCullables)}
+	,	m_culledCommandOffset{other.m_culledCommandOffset}
+	,	m_cullableOffset{other.m_cullableOffset}
+	,	m_cullPrepared{other.m_cullPrepared}
+	,	m_previousPositionLocation{other.m_previousPositionLocation}
+	,	m_previousBuffer{other.m_previousBuffer}
+	,	m_topology{std::move(other.m_topology)}
+	,	m_previousTopology{std::move(other.m_previousTopology)}
+	,	m_canInterpolate{other.m_canInterpolate}
+	,	m_coalesceSegments{other.m_coalesceSegments}
+	,	m_palette{std::move(other.m_palette)}
+	,	m_paletteIndexLocation{other.m_paletteIndexLocation}
+	,	m_tmpPaletteVertices{std::move(other.m_tmpPaletteVertices)}
+	,	m_paletteBuffers{std::move(other.m_paletteBuffers)}
+{
+	other.m_buffers.clear();
+	other.m_paletteBuffers.clear();
+}
+
+
+PrimitiveRenderer&
+PrimitiveRenderer::operator=(PrimitiveRenderer&& other) noexcept
 {
-	// This is a debugging library, so if we encounter GL errors, we prefer to
-	// fail hard.
-	auto error = glGetError();
-	if (error != GL_NO_ERROR) {
-		throw std::runtime_error{
-			reinterpret_cast<char const*>(glewGetErrorString(error))};
+	if (this != &other)
+	{
+		releaseBuffers();
+		m_vertices = std::move(other.m_vertices);
+		m_firstIndices = std::move(other.m_firstIndices);
+		m_polygonSizes = std::move(other.m_polygonSizes);
+		m_tmpCircleBuffer = std::move(other.m_tmpCircleBuffer);
+		m_numCircleSegments = other.m_numCircleSegments;
+		m_vertexHint = other.m_vertexHint;
+		m_polygonHint = other.m_polygonHint;
+		m_tags = std::move(other.m_tags);
+		m_tag = other.m_tag;
+		m_tagging = other.m_tagging;
+		m_index = std::move(other.m_index);
+		m_tmpBounds = std::move(other.m_tmpBounds);
+		m_tmpPicks = std::move(other.m_tmpPicks);
+		m_indexed = other.m_indexed;
+		m_pPool = other.m_pPool;
+		m_buffers = std::move(other.m_buffers);
+		m_numBuffers = other.m_numBuffers;
+		m_currentBuffer = other.m_currentBuffer;
+		m_positionLocation = other.m_positionLocation;
+		m_colourLocation = other.m_colourLocation;
+		m_useFences = other.m_useFences;
+		m_useDirectStateAccess = other.m_useDirectStateAccess;
+		m_uploadStats = other.m_uploadStats;
+		m_submissionStrategy = other.m_submissionStrategy;
+		m_tmpIndices = std::move(other.m_tmpIndices);
+		m_tmpCommands = std::move(other.m_tmpCommands);
+		m_elementMode = other.m_elementMode;
+		m_elementCount = other.m_elementCount;
+		m_groupElementOffsets = std::move(other.m_groupElementOffsets);
+		m_preparedMode = other.m_preparedMode;
+		m_prepared = other.m_prepared;
+		m_externalPrimitives = other.m_externalPrimitives;
+		m_useExternalPrimitives = other.m_useExternalPrimitives;
+		m_groups = std::move(other.m_groups);
+		m_worldTransformLocation = other.m_worldTransformLocation;
+		m_cullSlots = std::move(other.m_cullSlots);
+		m_tmpCullables = std::move(other.m_tmpCullables);
+		m_culledCommandOffset = other.m_culledCommandOffset;
+		m_cullableOffset = other.m_cullableOffset;
+		m_cullPrepared = other.m_cullPrepared;
+		m_previousPositionLocation = other.m_previousPositionLocation;
+		m_previousBuffer = other.m_previousBuffer;
+		m_topology = std::move(other.m_topology);
+		m_previousTopology = std::move(other.m_previousTopology);
+		m_canInterpolate = other.m_canInterpolate;
+		m_coalesceSegments = other.m_coalesceSegments;
+		m_palette = std::move(other.m_palette);
+		m_paletteIndexLocation = other.m_paletteIndexLocation;
+		m_tmpPaletteVertices = std::move(other.m_tmpPaletteVertices);
+		m_paletteBuffers = std::move(other.m_paletteBuffers);
+		other.m_buffers.clear();
+		other.m_paletteBuffers.clear();
 	}
+	return *this;
+}
+
+
+PrimitiveRenderer::~PrimitiveRenderer() noexcept
+{
+	releaseBuffers();
+}
 
-	glGenBuffers(1, &m_vbo);
-	if (m_vbo == 0u) {
-		throw std::runtime_error{"Invalid VBO"};
+
+void
+PrimitiveRenderer::acquireBuffers()
+{
+	m_useFences = m_pPool->usesFences();
+	m_useDirectStateAccess = m_pPool->usesDirectStateAccess();
+
+	m_buffers.reserve(m_numBuffers);
+	m_paletteBuffers.reserve(m_numBuffers);
+	while (m_buffers.size() < m_numBuffers)
+	{
+		auto const buffer = m_pPool->acquire();
+		m_buffers.push_back(buffer);
+		m_paletteBuffers.push_back(false);
+		applyAttribLocations(buffer, false);
 	}
+	m_currentBuffer = 0u;
+}
+
 
-	glGenVertexArrays(1, &m_vao);
-	if (!m_vao)
+void
+PrimitiveRenderer::releaseBuffers() noexcept
+{
+	for (auto const& buffer: m_buffers)
 	{
-		glDeleteBuffers(1, &m_vbo);
-		throw std::runtime_error{"Invalid VAO"};
+		disableAttribLocations(buffer);
+		m_pPool->release(buffer);
 	}
+	m_buffers.clear();
+	m_paletteBuffers.clear();
+}
+
 
-	glBindVertexArray(m_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+void
+PrimitiveRenderer::setPositionAttribLocation(GLint const location) noexcept
+{
+	m_positionLocation = location;
+	applyAttribLocations();
+}
 
-	if (positionAttribLocation >= 0)
+
+void
+PrimitiveRenderer::setColourAttribLocation(GLint const location) noexcept
+{
+	m_colourLocation = location;
+	applyAttribLocations();
+}
+
+
+void
+PrimitiveRenderer::setAttribLocations(
+	GLint const positionLocation,
+	GLint const colourLocation
+) noexcept
+{
+	m_positionLocation = positionLocation;
+	m_colourLocation = colourLocation;
+	applyAttribLocations();
+}
+
+
+void
+PrimitiveRenderer::setPreviousPositionAttribLocation(
+	GLint const location
+) noexcept
+{
+	for (auto& buffer: m_buffers)
 	{
-		setPositionAttribLocation(positionAttribLocation);
+		bindPreviousPositions(buffer, false);
 	}
-	error = glGetError();
-	if (error != GL_NO_ERROR) {
-		throw std::runtime_error{
-			reinterpret_cast<char const*>(glewGetErrorString(error))};
+	m_previousPositionLocation = location;
+	m_topology = Topology{};
+	m_canInterpolate = false;
+}
+
+
+void
+PrimitiveRenderer::setPalette(
+	b2Color const* const pColours,
+	std::size_t const count
+)
+{
+	m_palette.assign(
+		pColours, pColours + std::min(count, std::size_t{s_maxPaletteSize}));
+}
+
+
+void
+PrimitiveRenderer::setPaletteIndexAttribLocation(GLint const location) noexcept
+{
+	for (auto const& buffer: m_buffers)
+	{
+		disableAttribLocations(buffer);
 	}
+	m_paletteIndexLocation = location;
+	applyAttribLocations();
+}
+
 
-	if (colourAttribLocation >= 0)
+bool
+PrimitiveRenderer::indexPalette(
+	Vertex const* const pVertices,
+	std::size_t const count
+)
+{
+	if (m_palette.empty() || m_paletteIndexLocation < 0) {
+		return false;
+	}
+
+	m_tmpPaletteVertices.clear();
+	m_tmpPaletteVertices.reserve(count);
+	std::size_t entry{0u};
+	for (std::size_t i = 0; i < count; ++i)
 	{
-		setColourAttribLocation(colourAttribLocation);
+		// Primitives are mostly one colour, so try the last entry first.
+		auto const& colour = pVertices[i].second;
+		if (!sameColour(m_palette[entry], colour))
+		{
+			auto const found = std::find_if(
+				m_palette.begin(),
+				m_palette.end(),
+				[&colour](b2Color const& other) {
+					return sameColour(other, colour);
+				});
+			if (found == m_palette.end()) {
+				return false;
+			}
+			entry = std::size_t(found - m_palette.begin());
+		}
+		m_tmpPaletteVertices.push_back(
+			PaletteVertex{pVertices[i].first, GLuint(entry + 1u)});
 	}
-	error = glGetError();
-	if (error != GL_NO_ERROR) {
-		throw std::runtime_error{
-			reinterpret_cast<char const*>(glewGetErrorString(error))};
+	return true;
+}
+
+
+void
+PrimitiveRenderer::applyAttribLocations() const noexcept
+{
+	for (std::size_t i = 0; i < m_buffers.size(); ++i)
+	{
+		applyAttribLocations(m_buffers[i], m_paletteBuffers[i]);
 	}
 }
 
 
-PrimitiveRenderer::PrimitiveRenderer(PrimitiveRenderer&& other) noexcept
-	:	m_vertices{std::move(other.m_vertices)}
-	,	m_firstIndices{std::move(other.m_firstIndices)}
-	,	m_polygonSizes{std::move(other.m_polygonSizes)}
-	,	m_tmpCircleBuffer{std::move(other.m_tmpCircleBuffer)}
-	,	m_vbo{other.m_vbo}
-	,	m_vao{other.m_vao}
+void
+PrimitiveRenderer::applyAttribLocations(
+	VertexBuffer const& buffer,
+	bool const palette
+) const noexcept
 {
-	other.m_vbo = 0;
-	other.m_vao = 0;
+	// Palette vertices have an index where full ones have a colour.
+	GLsizei const stride{
+		palette ? GLsizei(sizeof(PaletteVertex)) : GLsizei(sizeof(Vertex))};
+	GLint const colourLocation{palette ? -1 : m_colourLocation};
+	GLint const indexLocation{palette ? m_paletteIndexLocation : -1};
+	GLint const unusedLocation{
+		palette ? m_colourLocation : m_paletteIndexLocation};
+
+	if (m_useDirectStateAccess)
+	{
+		// Attach the VBO and describe the attribute formats without touching
+		// any global state.
+		glVertexArrayVertexBuffer(
+			buffer.vao, s_vertexBindingIndex, buffer.vbo, 0, stride);
+
+		if (m_positionLocation >= 0)
+		{
+			glEnableVertexArrayAttrib(buffer.vao, m_positionLocation);
+			glVertexArrayAttribFormat(
+				buffer.vao, m_positionLocation, 2, GL_FLOAT, GL_FALSE, 0);
+			glVertexArrayAttribBinding(
+				buffer.vao, m_positionLocation, s_vertexBindingIndex);
+		}
+
+		if (colourLocation >= 0)
+		{
+			glEnableVertexArrayAttrib(buffer.vao, colourLocation);
+			glVertexArrayAttribFormat(
+				buffer.vao, colourLocation, 4, GL_FLOAT, GL_FALSE,
+				offsetof(Vertex, second));
+			glVertexArrayAttribBinding(
+				buffer.vao, colourLocation, s_vertexBindingIndex);
+		}
+
+		if (indexLocation >= 0)
+		{
+			glEnableVertexArrayAttrib(buffer.vao, indexLocation);
+			glVertexArrayAttribFormat(
+				buffer.vao, indexLocation, 1, GL_UNSIGNED_INT, GL_FALSE,
+				offsetof(PaletteVertex, index));
+			glVertexArrayAttribBinding(
+				buffer.vao, indexLocation, s_vertexBindingIndex);
+		}
+
+		if (unusedLocation >= 0) {
+			glDisableVertexArrayAttrib(buffer.vao, unusedLocation);
+		}
+		return;
+	}
+
+	glBindVertexArray(buffer.vao);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
+
+	if (m_positionLocation >= 0)
+	{
+		glEnableVertexAttribArray(m_positionLocation);
+		glVertexAttribPointer(
+			m_positionLocation, 2, GL_FLOAT, GL_FALSE, stride, nullptr);
+	}
+
+	if (colourLocation >= 0)
+	{
+		glEnableVertexAttribArray(colourLocation);
+		glVertexAttribPointer(
+			colourLocation, 4, GL_FLOAT, GL_FALSE, stride,
+			reinterpret_cast<void const*>(offsetof(Vertex, second)));
+	}
+
+	if (indexLocation >= 0)
+	{
+		glEnableVertexAttribArray(indexLocation);
+		glVertexAttribPointer(
+			indexLocation, 1, GL_UNSIGNED_INT, GL_FALSE, stride,
+			reinterpret_cast<void const*>(offsetof(PaletteVertex, index)));
+	}
+
+	if (unusedLocation >= 0) {
+		glDisableVertexAttribArray(unusedLocation);
+	}
 }
 
 
-PrimitiveRenderer::~PrimitiveRenderer() noexcept
+void
+PrimitiveRenderer::disableAttribLocations(
+	VertexBuffer const& buffer
+) const noexcept
 {
-	glDeleteBuffers(1, &m_vbo);
-	glDeleteVertexArrays(1, &m_vao);
+	GLint const locations[] = {
+		m_positionLocation,
+		m_colourLocation,
+		m_previousPositionLocation,
+		m_paletteIndexLocation};
+	if (!m_useDirectStateAccess) {
+		glBindVertexArray(buffer.vao);
+	}
+	for (auto const location: locations)
+	{
+		if (location < 0) {
+			continue;
+		}
+		if (m_useDirectStateAccess) {
+			glDisableVertexArrayAttrib(buffer.vao, location);
+		}
+		else {
+			glDisableVertexAttribArray(location);
+		}
+	}
+}
+
+
+bool
+PrimitiveRenderer::isAvailable(VertexBuffer& buffer) noexcept
+{
+	if (!buffer.fence) {
+		return true;
+	}
+
+	// A zero timeout only polls the fence.
+	auto const status = glClientWaitSync(buffer.fence, 0, 0);
+	if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+	{
+		glDeleteSync(buffer.fence);
+		buffer.fence = nullptr;
+		return true;
+	}
+	return false;
 }
 
 
@@ -95,15 +633,13 @@ PrimitiveRenderer::addPolygon(
 {
 	assert(numNewVertices != 0 && "Can't render an empty polygon!");
 	// Reserve the space before we do anything.
-	auto const totalVertices = m_vertices.size() + numNewVertices;
-	m_vertices.reserve(totalVertices);
-	auto const newPolygonCount = m_polygonSizes.size() + 1;
-	m_firstIndices.reserve(newPolygonCount);
-	m_polygonSizes.reserve(newPolygonCount);
+	reservePrimitive(std::size_t(numNewVertices));
 
 	// Create a new polygon.
+	addTag();
 	m_firstIndices.push_back(m_vertices.size());
 	m_polygonSizes.push_back(numNewVertices);
+	m_indexed = false;
 
 	// Copy vertices.
 	b2Vec2 const* const pEnd = pVertices + numNewVertices;
@@ -114,6 +650,24 @@ PrimitiveRenderer::addPolygon(
 }
 
 
+void
+PrimitiveRenderer::reservePrimitive(std::size_t const vertices)
+{
+	reserveGeometric(m_vertices, m_vertices.size() + vertices, m_vertexHint);
+	reserveGeometric(
+		m_firstIndices, m_firstIndices.size() + 1u, m_polygonHint);
+	reserveGeometric(
+		m_polygonSizes, m_polygonSizes.size() + 1u, m_polygonHint);
+}
+
+
+void
+PrimitiveRenderer::setCircleSegments(unsigned const count)
+{
+	m_numCircleSegments = std::max(count, 3u);
+}
+
+
 void
 PrimitiveRenderer::addCircle(
 	b2Vec2 const& centre,
@@ -122,6 +676,7 @@ PrimitiveRenderer::addCircle(
 	float32 const initialAngle
 )
 {
+	m_tmpCircleBuffer.resize(m_numCircleSegments);
 	algorithm::chebyshevSegments(
 		m_tmpCircleBuffer.data(),
 		m_tmpCircleBuffer.size(),
@@ -142,54 +697,962 @@ PrimitiveRenderer::addSegment(
 	b2Color const& colour
 )
 {
-	m_vertices.reserve(m_vertices.size() + 2);
-	auto const polygonCount = m_polygonSizes.size() + 1;
-	m_polygonSizes.reserve(polygonCount);
-	m_firstIndices.reserve(polygonCount);
+	// Extend the last primitive if this segment continues it, e.g. the next
+	// edge of a chain. A new group must start a new primitive.
+	if (
+		m_coalesceSegments &&
+		!m_vertices.empty() &&
+		(m_groups.empty() || m_groups.back().firstPrimitive < polygonCount()) &&
+		(!m_tagging || m_tags.back() == m_tag)
+	)
+	{
+		auto const& last = m_vertices.back();
+		if (
+			last.first.x == begin.x && last.first.y == begin.y &&
+			last.second.r == colour.r && last.second.g == colour.g &&
+			last.second.b == colour.b && last.second.a == colour.a
+		)
+		{
+			m_vertices.emplace_back(end, colour);
+			++m_polygonSizes.back();
+			m_indexed = false;
+			return;
+		}
+	}
 
+	reservePrimitive(2u);
+	addTag();
 	m_polygonSizes.push_back(2);
 	m_firstIndices.push_back(m_vertices.size());
 	m_vertices.emplace_back(begin, colour);
 	m_vertices.emplace_back(end, colour);
+	m_indexed = false;
+}
+
+
+void
+PrimitiveRenderer::beginGroup(b2Vec2 const& offset, float32 const scale)
+{
+	m_groups.push_back(Group{m_polygonSizes.size(), offset, scale});
+	m_indexed = false;
+}
+
+
+void
+PrimitiveRenderer::setTagging(bool const enable)
+{
+	m_tagging = enable;
+	m_tags.resize(enable ? polygonCount() : 0u, nullptr);
+}
+
+
+void
+PrimitiveRenderer::groupTransform(
+	std::size_t const primitive,
+	b2Vec2& offset,
+	float32& scale
+) const noexcept
+{
+	offset.Set(0.0f, 0.0f);
+	scale = 1.0f;
+	if (m_worldTransformLocation < 0)
+	{
+		return;
+	}
+
+	// The last group starting at or before the primitive.
+	auto const pGroup = std::upper_bound(
+		m_groups.begin(),
+		m_groups.end(),
+		primitive,
+		[](std::size_t const i, Group const& group) {
+			return i < group.firstPrimitive;
+		}
+	);
+	if (pGroup != m_groups.begin())
+	{
+		offset = std::prev(pGroup)->offset;
+		scale = std::prev(pGroup)->scale;
+	}
+}
+
+
+void
+PrimitiveRenderer::buildIndex()
+{
+	m_tmpBounds.clear();
+	m_tmpBounds.reserve(polygonCount());
+	b2Vec2 offset;
+	float32 scale;
+	for (std::size_t i = 0; i < polygonCount(); ++i)
+	{
+		auto pVertex = m_vertices.data() + m_firstIndices[i];
+		auto const pEnd = pVertex + m_polygonSizes[i];
+		b2Vec2 lower{pVertex->first};
+		b2Vec2 upper{lower};
+		for (++pVertex; pVertex < pEnd; ++pVertex)
+		{
+			lower = b2Min(lower, pVertex->first);
+			upper = b2Max(upper, pVertex->first);
+		}
+
+		// A negative scale swaps the corners.
+		groupTransform(i, offset, scale);
+		lower = offset + scale * lower;
+		upper = offset + scale * upper;
+		m_tmpBounds.push_back(
+			SpatialIndex::Bounds{b2Min(lower, upper), b2Max(lower, upper)});
+	}
+	m_index.build(m_tmpBounds.data(), m_tmpBounds.size());
+	m_indexed = true;
+}
+
+
+void
+PrimitiveRenderer::pick(
+	GLenum const mode,
+	b2Vec2 const& point,
+	float32 const radius,
+	std::vector<std::size_t>& primitives
+)
+{
+	if (!m_indexed) {
+		buildIndex();
+	}
+
+	b2Vec2 const reach{radius, radius};
+	m_tmpPicks.clear();
+	m_index.query(
+		SpatialIndex::Bounds{point - reach, point + reach}, m_tmpPicks);
+
+	// Test each candidate's geometry in its group's space.
+	bool const closed{mode == GL_TRIANGLE_FAN || mode == GL_LINE_LOOP};
+	b2Vec2 offset;
+	float32 scale;
+	for (auto const i: m_tmpPicks)
+	{
+		groupTransform(i, offset, scale);
+		if (scale == 0.0f) {
+			continue;
+		}
+		if (
+			hits(
+				m_vertices.data() + m_firstIndices[i],
+				std::size_t(m_polygonSizes[i]),
+				closed,
+				(1.0f / scale) * (point - offset),
+				radius / std::abs(scale))
+		)
+		{
+			primitives.push_back(i);
+		}
+	}
+}
+
+
+void
+PrimitiveRenderer::compact(std::vector<unsigned char> const& strides)
+{
+	assert(strides.size() == m_polygonSizes.size());
+
+	// Vertices only ever move towards the front, so compact in place.
+	std::size_t group{0u};
+	std::size_t kept{0u};
+	std::size_t keptVertices{0u};
+	for (std::size_t i = 0; i < m_polygonSizes.size(); ++i)
+	{
+		while (group < m_groups.size() && m_groups[group].firstPrimitive == i)
+		{
+			m_groups[group++].firstPrimitive = kept;
+		}
+
+		auto const stride = strides[i];
+		if (stride == 0) {
+			continue;
+		}
+
+		std::size_t const first = m_firstIndices[i];
+		std::size_t const size = m_polygonSizes[i];
+		std::size_t const newFirst = keptVertices;
+		for (std::size_t j = 0; j < size; j += stride)
+		{
+			m_vertices[keptVertices++] = m_vertices[first + j];
+		}
+		m_firstIndices[kept] = newFirst;
+		m_polygonSizes[kept] = keptVertices - newFirst;
+		if (m_tagging) {
+			m_tags[kept] = m_tags[i];
+		}
+		++kept;
+	}
+	for (; group < m_groups.size(); ++group)
+	{
+		m_groups[group].firstPrimitive = kept;
+	}
+
+	m_vertices.resize(keptVertices);
+	m_firstIndices.resize(kept);
+	m_polygonSizes.resize(kept);
+	if (m_tagging) {
+		m_tags.resize(kept);
+	}
+	m_indexed = false;
 }
 
 
 void
 PrimitiveRenderer::bufferData()
 {
-	glBindVertexArray(m_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-	glBufferData(
-		GL_ARRAY_BUFFER,
-		m_vertices.size() * sizeof(Vertex),
-		m_vertices.data(),
-		GL_DYNAMIC_DRAW
+	m_useExternalPrimitives = false;
+	uploadVertices(m_vertices.data(), m_vertices.size());
+	updateTopology();
+}
+
+
+void
+PrimitiveRenderer::bufferData(PrimitiveView const& primitives)
+{
+	m_externalPrimitives = primitives;
+	m_useExternalPrimitives = true;
+	uploadVertices(primitives.pVertices, primitives.vertexCount);
+	updateTopology();
+}
+
+
+void
+PrimitiveRenderer::updateTopology()
+{
+	if (!keepsPrevious())
+	{
+		m_canInterpolate = false;
+		return;
+	}
+
+	auto const primitives = drawnPrimitives();
+	std::swap(m_topology, m_previousTopology);
+	m_topology.firstIndices.assign(
+		primitives.pFirstIndices,
+		primitives.pFirstIndices + primitives.polygonCount
+	);
+	m_topology.polygonSizes.assign(
+		primitives.pPolygonSizes,
+		primitives.pPolygonSizes + primitives.polygonCount
 	);
+
+	// The first upload has nothing to blend from.
+	m_canInterpolate = m_previousBuffer != m_currentBuffer &&
+		m_topology.firstIndices == m_previousTopology.firstIndices &&
+		m_topology.polygonSizes == m_previousTopology.polygonSizes;
+}
+
+
+void
+PrimitiveRenderer::uploadVertices(
+	Vertex const* const pVertices,
+	std::size_t const count
+)
+{
+	if (m_buffers.empty()) {
+		acquireBuffers();
+	}
+	bool const palette{indexPalette(pVertices, count)};
+
+	auto const numBuffers = m_buffers.size();
+	auto next = (m_currentBuffer + 1) % numBuffers;
+	bool available{true};
+
+	// Find the first buffer, starting after the current one, which the GPU has
+	// finished reading from. When interpolating, the current buffer becomes
+	// the previous one, so mustn't be overwritten.
+	if (m_useFences)
+	{
+		auto const start = std::chrono::steady_clock::now();
+		auto const candidates = keepsPrevious() ? numBuffers - 1 : numBuffers;
+		available = false;
+		for (std::size_t i = 0; i < candidates; ++i)
+		{
+			auto const index = (m_currentBuffer + 1 + i) % numBuffers;
+			if (isAvailable(m_buffers[index]))
+			{
+				next = index;
+				available = true;
+				break;
+			}
+		}
+		m_uploadStats.fenceWaitTime += std::chrono::steady_clock::now() - start;
+	}
+
+	m_previousBuffer = m_buffers.size() > 1 ? m_currentBuffer : next;
+	m_currentBuffer = next;
+	m_prepared = false;
+	m_cullPrepared = false;
+	++m_uploadStats.uploads;
+
+	auto& buffer = m_buffers[next];
+	if (m_paletteBuffers[next] != palette)
+	{
+		m_paletteBuffers[next] = palette;
+		applyAttribLocations(buffer, palette);
+	}
+	void const* const pData{palette
+		? static_cast<void const*>(m_tmpPaletteVertices.data())
+		: static_cast<void const*>(pVertices)};
+	GLsizeiptr const size = count * vertexStride(next);
+	if (!available) {
+		++m_uploadStats.busyUploads;
+	}
+
+	// If the buffer is idle and large enough, overwrite it in place; otherwise
+	// (re)allocate, which orphans any storage still in use by the GPU.
+	bool const reallocate{!available || size > buffer.capacity};
+	if (reallocate) {
+		buffer.capacity = size;
+	}
+
+	if (m_useDirectStateAccess)
+	{
+		if (reallocate) {
+			glNamedBufferData(buffer.vbo, size, pData, GL_DYNAMIC_DRAW);
+		}
+		else {
+			glNamedBufferSubData(buffer.vbo, 0, size, pData);
+		}
+		return;
+	}
+
+	glBindVertexArray(buffer.vao);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
+	if (reallocate) {
+		glBufferData(GL_ARRAY_BUFFER, size, pData, GL_DYNAMIC_DRAW);
+	}
+	else {
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, pData);
+	}
 }
 
 
 void
 PrimitiveRenderer::render(GLenum const mode)
 {
-	if (empty()) {
+	draw(mode, 0.0f);
+}
+
+
+void
+PrimitiveRenderer::render(GLenum const mode, float32 const alpha)
+{
+	draw(mode, m_canInterpolate ? 1.0f - b2Clamp(alpha, 0.0f, 1.0f) : 0.0f);
+}
+
+
+void
+PrimitiveRenderer::draw(GLenum const mode, float32 const previousWeight)
+{
+	auto const primitives = drawnPrimitives();
+	if (primitives.polygonCount == 0 || m_buffers.empty()) {
+		return;
+	}
+
+	auto& buffer = m_buffers[m_currentBuffer];
+	bool const prepare{!m_prepared || m_preparedMode != mode};
+	m_prepared = true;
+	m_preparedMode = mode;
+
+	bool const interpolate{
+		m_canInterpolate && m_worldTransformLocation >= 0 &&
+		previousWeight > 0.0f
+	};
+	if (m_previousPositionLocation >= 0) {
+		bindPreviousPositions(buffer, interpolate);
+	}
+
+	glBindVertexArray(buffer.vao);
+	switch (m_submissionStrategy)
+	{
+		case SubmissionStrategy::indexed:
+			if (prepare) {
+				m_elementMode = prepareIndices(buffer, mode);
+			}
+			break;
+
+		case SubmissionStrategy::indirect:
+			if (prepare) {
+				prepareCommands(buffer);
+			}
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer.commandBuffer);
+			break;
+
+		default:
+			break;
+	}
+
+	// Zero unless interpolating, in which case the previous positions are
+	// blended in by the shader.
+	float32 const weight{interpolate ? previousWeight : 0.0f};
+	b2Vec2 const origin{0.0f, 0.0f};
+	if (weight > 0.0f) {
+		setWorldTransform(origin, weight, 1.0f);
+	}
+
+	if (!isGrouped()) {
+		drawRange(mode, 0u, primitives.polygonCount, 0, m_elementCount);
+	}
+	else
+	{
+		// Anything added before the first group is drawn untransformed.
+		drawRange(
+			mode,
+			0u,
+			m_groups.front().firstPrimitive,
+			0,
+			groupElementOffset(0u)
+		);
+		for (std::size_t i = 0; i < m_groups.size(); ++i)
+		{
+			auto const& group = m_groups[i];
+			auto const end = i + 1 < m_groups.size()
+				? m_groups[i + 1].firstPrimitive
+				: primitives.polygonCount;
+			if (group.firstPrimitive == end) {
+				continue;
+			}
+			setWorldTransform(group.offset, weight, group.scale);
+			drawRange(
+				mode,
+				group.firstPrimitive,
+				end,
+				groupElementOffset(i),
+				groupElementOffset(i + 1)
+			);
+		}
+	}
+
+	if (weight > 0.0f || isGrouped()) {
+		setWorldTransform(origin, 0.0f, 1.0f);
+	}
+
+	// The previous buffer was read too, and mustn't be overwritten until the
+	// GPU is done with it.
+	fence(buffer);
+	if (interpolate) {
+		fence(m_buffers[m_previousBuffer]);
+	}
+}
+
+
+void
+PrimitiveRenderer::renderCulled(
+	GLenum const mode,
+	b2Vec2 const& lower,
+	b2Vec2 const& upper,
+	GLuint const cullProgram,
+	GLuint const drawProgram,
+	float32 const minSize
+)
+{
+	auto const primitives = drawnPrimitives();
+	if (primitives.polygonCount == 0 || m_buffers.empty()) {
+		return;
+	}
+
+	auto& buffer = m_buffers[m_currentBuffer];
+	if (!m_cullPrepared)
+	{
+		prepareCulling(buffer);
+		m_cullPrepared = true;
+	}
+
+	// Without a draw count read from a buffer, cull in place instead.
+	bool const compact{GLEW_VERSION_4_6 || GLEW_ARB_indirect_parameters};
+	auto const count = primitives.polygonCount;
+	auto const slots = m_cullSlots.size() - 1;
+	GLsizeiptr const countBytes = slots * sizeof(GLuint);
+	GLsizeiptr const commandBytes = count * sizeof(DrawArraysCommand);
+	GLuint const zero{0u};
+	if (m_useDirectStateAccess)
+	{
+		glClearNamedBufferSubData(
+			buffer.cullBuffer, GL_R32UI, 0, countBytes, GL_RED_INTEGER,
+			GL_UNSIGNED_INT, &zero);
+	}
+	else
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer.cullBuffer);
+		glClearBufferSubData(
+			GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, countBytes, GL_RED_INTEGER,
+			GL_UNSIGNED_INT, &zero);
+	}
+
+	// Bindings and locations as in the culling shader.
+	glUseProgram(cullProgram);
+	glUniform4f(0, lower.x, lower.y, upper.x, upper.y);
+	glUniform1ui(1, GLuint(count));
+	glUniform1i(2, compact ? 1 : 0);
+	glUniform1f(3, minSize);
+	glBindBufferRange(
+		GL_SHADER_STORAGE_BUFFER, 0, buffer.cullBuffer, m_cullableOffset,
+		count * sizeof(Cullable));
+	glBindBufferRange(
+		GL_SHADER_STORAGE_BUFFER, 1, buffer.commandBuffer, 0, commandBytes);
+	glBindBufferRange(
+		GL_SHADER_STORAGE_BUFFER, 2, buffer.cullBuffer, m_culledCommandOffset,
+		commandBytes);
+	glBindBufferRange(
+		GL_SHADER_STORAGE_BUFFER, 3, buffer.cullBuffer, 0, countBytes);
+	glDispatchCompute(
+		GLuint((count + s_cullGroupSize - 1) / s_cullGroupSize), 1u, 1u);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+	glUseProgram(drawProgram);
+
+	if (m_previousPositionLocation >= 0) {
+		bindPreviousPositions(buffer, false);
+	}
+	glBindVertexArray(buffer.vao);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer.cullBuffer);
+	if (compact) {
+		glBindBuffer(GL_PARAMETER_BUFFER_ARB, buffer.cullBuffer);
+	}
+
+	auto const multiDrawIndirectCount = GLEW_VERSION_4_6
+		? glMultiDrawArraysIndirectCount
+		: glMultiDrawArraysIndirectCountARB;
+	bool const grouped{isGrouped()};
+	for (std::size_t slot = 0; slot < slots; ++slot)
+	{
+		auto const begin = m_cullSlots[slot];
+		auto const end = m_cullSlots[slot + 1];
+		if (begin == end) {
+			continue;
+		}
+
+		// The first slot holds anything added before the first group.
+		if (grouped && slot > 0)
+		{
+			auto const& group = m_groups[slot - 1];
+			setWorldTransform(group.offset, 0.0f, group.scale);
+		}
+		auto const pCommands = reinterpret_cast<void const*>(
+			m_culledCommandOffset + begin * sizeof(DrawArraysCommand));
+		if (compact)
+		{
+			multiDrawIndirectCount(
+				mode, pCommands, GLintptr(slot * sizeof(GLuint)),
+				GLsizei(end - begin), 0);
+		}
+		else {
+			glMultiDrawArraysIndirect(mode, pCommands, end - begin, 0);
+		}
+	}
+
+	if (grouped) {
+		setWorldTransform(b2Vec2{0.0f, 0.0f}, 0.0f, 1.0f);
+	}
+	fence(buffer);
+}
+
+
+void
+PrimitiveRenderer::fence(VertexBuffer& buffer) noexcept
+{
+	if (!m_useFences) {
 		return;
 	}
-	glBindVertexArray(m_vao);
+
+	if (buffer.fence) {
+		glDeleteSync(buffer.fence);
+	}
+	buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+
+void
+PrimitiveRenderer::bindPreviousPositions(
+	VertexBuffer& buffer,
+	bool const enable
+) noexcept
+{
+	auto const location = m_previousPositionLocation;
+	if (location < 0) {
+		return;
+	}
+
+	if (!enable)
+	{
+		if (m_useDirectStateAccess) {
+			glDisableVertexArrayAttrib(buffer.vao, location);
+		}
+		else
+		{
+			glBindVertexArray(buffer.vao);
+			glDisableVertexAttribArray(location);
+		}
+		return;
+	}
+
+	// Read the previous upload's positions, vertex for vertex, whether or
+	// not it was of palette vertices.
+	auto const previousVbo = m_buffers[m_previousBuffer].vbo;
+	auto const stride = vertexStride(m_previousBuffer);
+	if (m_useDirectStateAccess)
+	{
+		glVertexArrayVertexBuffer(
+			buffer.vao, s_previousBindingIndex, previousVbo, 0, stride);
+		glEnableVertexArrayAttrib(buffer.vao, location);
+		glVertexArrayAttribFormat(
+			buffer.vao, location, 2, GL_FLOAT, GL_FALSE, 0);
+		glVertexArrayAttribBinding(
+			buffer.vao, location, s_previousBindingIndex);
+		return;
+	}
+
+	glBindVertexArray(buffer.vao);
+	glBindBuffer(GL_ARRAY_BUFFER, previousVbo);
+	glEnableVertexAttribArray(location);
+	glVertexAttribPointer(location, 2, GL_FLOAT, GL_FALSE, stride, nullptr);
+}
+
+
+void
+PrimitiveRenderer::drawRange(
+	GLenum const mode,
+	std::size_t const begin,
+	std::size_t const end,
+	GLsizei const beginElement,
+	GLsizei const endElement
+) noexcept
+{
+	switch (m_submissionStrategy)
+	{
+		case SubmissionStrategy::indexed:
+			if (m_elementMode)
+			{
+				glDrawElements(
+					m_elementMode,
+					endElement - beginElement,
+					GL_UNSIGNED_INT,
+					reinterpret_cast<void const*>(
+						beginElement * sizeof(GLuint))
+				);
+				break;
+			}
+			// Not an indexable mode, so fall back to multi-draw.
+			multiDraw(mode, begin, end);
+			break;
+
+		case SubmissionStrategy::indirect:
+			glMultiDrawArraysIndirect(
+				mode,
+				reinterpret_cast<void const*>(
+					begin * sizeof(DrawArraysCommand)),
+				end - begin,
+				0
+			);
+			break;
+
+		default:
+			multiDraw(mode, begin, end);
+			break;
+	}
+}
+
+
+void
+PrimitiveRenderer::multiDraw(
+	GLenum const mode,
+	std::size_t const begin,
+	std::size_t const end
+) noexcept
+{
+	auto const primitives = drawnPrimitives();
 	glMultiDrawArrays(
 		mode,
-		m_firstIndices.data(),
-		m_polygonSizes.data(),
-		m_polygonSizes.size()
+		primitives.pFirstIndices + begin,
+		primitives.pPolygonSizes + begin,
+		end - begin
 	);
 }
 
 
+bool
+PrimitiveRenderer::isSupported(SubmissionStrategy const strategy) noexcept
+{
+	switch (strategy)
+	{
+		case SubmissionStrategy::multiDraw:
+		case SubmissionStrategy::indexed:
+			return true;
+
+		case SubmissionStrategy::indirect:
+			return GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect;
+
+		default:
+			return false;
+	}
+}
+
+
+bool
+PrimitiveRenderer::supportsCulling() noexcept
+{
+	return GLEW_VERSION_4_3 ||
+		(GLEW_ARB_compute_shader && GLEW_ARB_multi_draw_indirect);
+}
+
+
+void
+PrimitiveRenderer::setSubmissionStrategy(
+	SubmissionStrategy const strategy
+) noexcept
+{
+	m_submissionStrategy = isSupported(strategy)
+		? strategy
+		: SubmissionStrategy::multiDraw;
+	m_prepared = false;
+}
+
+
+GLenum
+PrimitiveRenderer::prepareIndices(VertexBuffer& buffer, GLenum const mode)
+{
+	auto const elementMode = elementModeFor(mode);
+	if (!elementMode) {
+		return 0u;
+	}
+
+	auto const primitives = drawnPrimitives();
+	bool const grouped{isGrouped()};
+	std::size_t group{0u};
+	m_tmpIndices.clear();
+	m_groupElementOffsets.clear();
+	for (std::size_t i = 0; i < primitives.polygonCount; ++i)
+	{
+		while (
+			grouped &&
+			group < m_groups.size() &&
+			m_groups[group].firstPrimitive == i
+		)
+		{
+			m_groupElementOffsets.push_back(m_tmpIndices.size());
+			++group;
+		}
+
+		GLuint const first = primitives.pFirstIndices[i];
+		GLuint const size = primitives.pPolygonSizes[i];
+		if (mode == GL_TRIANGLE_FAN)
+		{
+			for (GLuint j = 1; j + 1 < size; ++j)
+			{
+				m_tmpIndices.push_back(first);
+				m_tmpIndices.push_back(first + j);
+				m_tmpIndices.push_back(first + j + 1);
+			}
+			continue;
+		}
+
+		for (GLuint j = 0; j + 1 < size; ++j)
+		{
+			m_tmpIndices.push_back(first + j);
+			m_tmpIndices.push_back(first + j + 1);
+		}
+		if (mode == GL_LINE_LOOP && size > 1)
+		{
+			m_tmpIndices.push_back(first + size - 1);
+			m_tmpIndices.push_back(first);
+		}
+	}
+
+	if (!buffer.elementBuffer)
+	{
+		// The element buffer binding is part of the VAO, so set it once.
+		buffer.elementBuffer = m_pPool->createBuffer();
+		if (m_useDirectStateAccess) {
+			glVertexArrayElementBuffer(buffer.vao, buffer.elementBuffer);
+		}
+		else {
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.elementBuffer);
+		}
+	}
+
+	if (grouped)
+	{
+		// Close any trailing empty groups, then the last group.
+		m_groupElementOffsets.resize(m_groups.size(), m_tmpIndices.size());
+		m_groupElementOffsets.push_back(m_tmpIndices.size());
+	}
+
+	uploadBuffer(
+		buffer.elementBuffer,
+		GL_ELEMENT_ARRAY_BUFFER,
+		m_tmpIndices.size() * sizeof(GLuint),
+		m_tmpIndices.data()
+	);
+	m_elementCount = m_tmpIndices.size();
+	return elementMode;
+}
+
+
+void
+PrimitiveRenderer::prepareCommands(VertexBuffer& buffer)
+{
+	auto const primitives = drawnPrimitives();
+	m_tmpCommands.clear();
+	m_tmpCommands.reserve(primitives.polygonCount);
+	for (std::size_t i = 0; i < primitives.polygonCount; ++i)
+	{
+		m_tmpCommands.push_back(DrawArraysCommand{
+			GLuint(primitives.pPolygonSizes[i]),
+			1u,
+			GLuint(primitives.pFirstIndices[i]),
+			0u
+		});
+	}
+
+	if (!buffer.commandBuffer) {
+		buffer.commandBuffer = m_pPool->createBuffer();
+	}
+	uploadBuffer(
+		buffer.commandBuffer,
+		GL_DRAW_INDIRECT_BUFFER,
+		m_tmpCommands.size() * sizeof(DrawArraysCommand),
+		m_tmpCommands.data()
+	);
+}
+
+
+void
+PrimitiveRenderer::prepareCulling(VertexBuffer& buffer)
+{
+	auto const primitives = drawnPrimitives();
+
+	// Each group is a slot, after one for anything added before the first.
+	m_cullSlots.assign(1u, 0u);
+	if (isGrouped())
+	{
+		for (auto const& group: m_groups)
+		{
+			m_cullSlots.push_back(group.firstPrimitive);
+		}
+	}
+	m_cullSlots.push_back(primitives.polygonCount);
+
+	m_tmpCullables.clear();
+	m_tmpCullables.reserve(primitives.polygonCount);
+	for (std::size_t slot = 0; slot + 1 < m_cullSlots.size(); ++slot)
+	{
+		b2Vec2 offset{0.0f, 0.0f};
+		float32 scale{1.0f};
+		if (slot > 0)
+		{
+			offset = m_groups[slot - 1].offset;
+			scale = m_groups[slot - 1].scale;
+		}
+
+		for (auto i = m_cullSlots[slot]; i < m_cullSlots[slot + 1]; ++i)
+		{
+			auto pVertex = primitives.pVertices + primitives.pFirstIndices[i];
+			auto const pEnd = pVertex + primitives.pPolygonSizes[i];
+			b2Vec2 lower{0.0f, 0.0f};
+			if (pVertex < pEnd) {
+				lower = pVertex->first;
+			}
+			b2Vec2 upper{lower};
+			for (; pVertex < pEnd; ++pVertex)
+			{
+				lower = b2Min(lower, pVertex->first);
+				upper = b2Max(upper, pVertex->first);
+			}
+
+			// A negative scale swaps the corners.
+			lower = offset + scale * lower;
+			upper = offset + scale * upper;
+			m_tmpCullables.push_back(Cullable{
+				b2Min(lower, upper),
+				b2Max(lower, upper),
+				GLuint(slot),
+				GLuint(m_cullSlots[slot]),
+				{0u, 0u}
+			});
+		}
+	}
+
+	// The commands to cull are the ones indirect submission would draw.
+	prepareCommands(buffer);
+
+	auto const align = [](GLintptr const offset) {
+		return (offset + s_cullAlignment - 1) / s_cullAlignment *
+			s_cullAlignment;
+	};
+	auto const count = primitives.polygonCount;
+	m_culledCommandOffset = align((m_cullSlots.size() - 1) * sizeof(GLuint));
+	m_cullableOffset =
+		align(m_culledCommandOffset + count * sizeof(DrawArraysCommand));
+	GLsizeiptr const cullableBytes = count * sizeof(Cullable);
+
+	if (!buffer.cullBuffer) {
+		buffer.cullBuffer = m_pPool->createBuffer();
+	}
+	uploadBuffer(
+		buffer.cullBuffer,
+		GL_SHADER_STORAGE_BUFFER,
+		m_cullableOffset + cullableBytes,
+		nullptr
+	);
+	if (m_useDirectStateAccess)
+	{
+		glNamedBufferSubData(
+			buffer.cullBuffer, m_cullableOffset, cullableBytes,
+			m_tmpCullables.data());
+	}
+	else
+	{
+		glBufferSubData(
+			GL_SHADER_STORAGE_BUFFER, m_cullableOffset, cullableBytes,
+			m_tmpCullables.data());
+	}
+}
+
+
+void
+PrimitiveRenderer::uploadBuffer(
+	GLuint const buffer,
+	GLenum const target,
+	GLsizeiptr const size,
+	void const* const pData
+) const noexcept
+{
+	if (m_useDirectStateAccess)
+	{
+		glNamedBufferData(buffer, size, pData, GL_DYNAMIC_DRAW);
+		return;
+	}
+	glBindBuffer(target, buffer);
+	glBufferData(target, size, pData, GL_DYNAMIC_DRAW);
+}
+
+
 void
 PrimitiveRenderer::clear()
 {
+	if (arena())
+	{
+		// Free the storage, so the arena can rewind for the next frame.
+		m_vertexHint = m_vertices.size();
+		m_polygonHint = m_polygonSizes.size();
+		decltype(m_vertices){m_vertices.get_allocator()}.swap(m_vertices);
+		decltype(m_firstIndices){m_firstIndices.get_allocator()}.swap(
+			m_firstIndices);
+		decltype(m_polygonSizes){m_polygonSizes.get_allocator()}.swap(
+			m_polygonSizes);
+		decltype(m_tmpCircleBuffer){m_tmpCircleBuffer.get_allocator()}.swap(
+			m_tmpCircleBuffer);
+	}
 	m_vertices.clear();
 	m_firstIndices.clear();
 	m_polygonSizes.clear();
+	m_groups.clear();
+	m_tags.clear();
+	m_tag = nullptr;
+	m_indexed = false;
 }
 
 
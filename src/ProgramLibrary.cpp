@@ -0,0 +1,621 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "b2draw/ProgramLibrary.h"
+
+
+namespace b2draw {
+namespace {
+
+
+/**
+ * A program's shader sources. Compute programs have no fragment shader, and
+ * keep their compute shader in `pVertex`.
+ */
+struct ProgramSource
+{
+	char const* pName;
+	char const* pVertex;
+	char const* pFragment;
+};
+
+
+constexpr char const* const pColourFragmentSource = R"GLS(
+#version 330 core
+
+in vec4 fsColour;
+out vec4 fragColour;
+
+void main() {
+	fragColour = fsColour;
+}
+)GLS";
+
+
+ProgramSource const programSources[] = {
+	{
+		"plain",
+		R"GLS(
+#version 330 core
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec4 colour;
+layout(location = 4) in vec4 worldTransform; // Offset, blend, scale.
+layout(location = 5) in vec2 previousPosition;
+layout(location = 6) in float pointSize;
+
+uniform mat4 u_mvp;
+uniform float u_pointScale;
+
+out vec4 fsColour;
+
+void main() {
+	vec2 blended = mix(position, previousPosition, worldTransform.z);
+	vec2 placed = worldTransform.xy + worldTransform.w * blended;
+	gl_Position = u_mvp * vec4(placed, 0.0, 1.0);
+	gl_PointSize = pointSize * u_pointScale;
+	fsColour = colour;
+}
+)GLS",
+		pColourFragmentSource
+	},
+	{
+		"instanced-circle",
+		R"GLS(
+#version 330 core
+
+layout(location = 1) in vec4 colour;
+layout(location = 2) in vec3 circle; // Centre and radius.
+layout(location = 10) in float segments;
+
+uniform mat4 u_mvp;
+
+out vec4 fsColour;
+
+const float TWO_PI = 6.28318530718;
+
+void main() {
+	// Match the vertex order of algorithm::chebyshevSegments.
+	float angle = TWO_PI * float(gl_VertexID) / segments;
+	vec2 position = circle.xy + circle.z * vec2(-sin(angle), cos(angle));
+	gl_Position = u_mvp * vec4(position, 0.0, 1.0);
+	fsColour = colour;
+}
+)GLS",
+		pColourFragmentSource
+	},
+	{
+		"palette-colour",
+		R"GLS(
+#version 330 core
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec4 colour;
+layout(location = 3) in float paletteIndex;
+layout(location = 4) in vec4 worldTransform; // Offset, blend, scale.
+layout(location = 5) in vec2 previousPosition;
+layout(location = 6) in float pointSize;
+
+uniform mat4 u_mvp;
+uniform float u_pointScale;
+uniform vec4 u_palette[64];
+
+out vec4 fsColour;
+
+void main() {
+	vec2 blended = mix(position, previousPosition, worldTransform.z);
+	vec2 placed = worldTransform.xy + worldTransform.w * blended;
+	gl_Position = u_mvp * vec4(placed, 0.0, 1.0);
+	gl_PointSize = pointSize * u_pointScale;
+
+	// Index zero, the attribute's default, keeps the vertex's own colour.
+	int index = int(paletteIndex + 0.5);
+	fsColour = index == 0 ? colour : u_palette[(index - 1) % 64];
+}
+)GLS",
+		pColourFragmentSource
+	},
+	{
+		"density",
+		R"GLS(
+#version 330 core
+
+out vec2 fsTexCoord;
+
+void main() {
+	// A triangle strip covering the viewport.
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+	gl_Position = vec4(2.0 * corner - 1.0, 0.0, 1.0);
+	fsTexCoord = corner;
+}
+)GLS",
+		R"GLS(
+#version 330 core
+
+in vec2 fsTexCoord;
+out vec4 fragColour;
+
+uniform sampler2D u_density;
+
+void main() {
+	float level = texture(u_density, fsTexCoord).r;
+	if (level == 0.0) {
+		discard;
+	}
+
+	// Blue through yellow to red, more opaque as density rises.
+	float t = 2.0 * level;
+	vec3 colour = t < 1.0
+		? mix(vec3(0.0, 0.3, 1.0), vec3(1.0, 1.0, 0.0), t)
+		: mix(vec3(1.0, 1.0, 0.0), vec3(1.0, 0.0, 0.0), t - 1.0);
+	fragColour = vec4(colour, 0.35 + 0.65 * level);
+}
+)GLS"
+	},
+	{
+		"cull-primitives",
+		R"GLS(
+#version 430 core
+
+layout(local_size_x = 64) in;
+
+// As laid out by PrimitiveRenderer.
+struct Command {
+	uint count;
+	uint instanceCount;
+	uint first;
+	uint baseInstance;
+};
+
+struct Cullable {
+	vec4 bounds; // Lower and upper corners.
+	uint slot; // The transform the primitive is drawn with.
+	uint slotStart; // Where the slot's culled commands start.
+};
+
+layout(std430, binding = 0) readonly buffer Cullables {
+	Cullable cullables[];
+};
+layout(std430, binding = 1) readonly buffer Commands {
+	Command commands[];
+};
+layout(std430, binding = 2) writeonly buffer Culled {
+	Command culled[];
+};
+layout(std430, binding = 3) buffer Counts {
+	uint counts[];
+};
+
+layout(location = 0) uniform vec4 u_view; // Lower and upper corners.
+layout(location = 1) uniform uint u_count;
+layout(location = 2) uniform bool u_compact;
+layout(location = 3) uniform float u_minSize;
+
+void main() {
+	uint i = gl_GlobalInvocationID.x;
+	if (i >= u_count) {
+		return;
+	}
+
+	Cullable cullable = cullables[i];
+	vec2 size = cullable.bounds.zw - cullable.bounds.xy;
+	bool visible =
+		all(lessThanEqual(cullable.bounds.xy, u_view.zw)) &&
+		all(lessThanEqual(u_view.xy, cullable.bounds.zw)) &&
+		max(size.x, size.y) >= u_minSize;
+	Command command = commands[i];
+	if (!u_compact) {
+		// Keep every command in place, and draw culled ones no times.
+		command.instanceCount = visible ? 1u : 0u;
+		culled[i] = command;
+	}
+	else if (visible) {
+		uint index = atomicAdd(counts[cullable.slot], 1u);
+		culled[cullable.slotStart + index] = command;
+	}
+}
+)GLS",
+		nullptr
+	},
+	{
+		"contact",
+		R"GLS(
+#version 330 core
+
+layout(location = 1) in vec4 colour;
+layout(location = 7) in vec4 contact; // Point and unit normal.
+layout(location = 8) in float impulse;
+layout(location = 9) in vec2 contactScale; // Length per impulse, cross size.
+
+uniform mat4 u_mvp;
+
+out vec4 fsColour;
+
+void main() {
+	// The normal, then the two diagonals of a cross on the point.
+	vec2 offset;
+	if (gl_VertexID < 2) {
+		offset = float(gl_VertexID) * impulse * contactScale.x * contact.zw;
+	}
+	else {
+		float side = (gl_VertexID & 1) == 0 ? -1.0 : 1.0;
+		offset = contactScale.y * vec2(side, gl_VertexID < 4 ? side : -side);
+	}
+	gl_Position = u_mvp * vec4(contact.xy + offset, 0.0, 1.0);
+	fsColour = colour;
+}
+)GLS",
+		pColourFragmentSource
+	}
+};
+
+static_assert(
+	sizeof(programSources) / sizeof(programSources[0]) ==
+		static_cast<std::size_t>(ProgramKind::count),
+	"Every ProgramKind needs a source");
+
+
+/** Magic number at the start of cached program binaries ("B2PB"). */
+constexpr std::uint32_t cacheMagic = 0x42503242u;
+constexpr std::uint32_t cacheVersion = 1u;
+
+
+/** 64-bit FNV-1a hash, used to key cache entries. */
+std::uint64_t
+fnv1a(std::string const& data, std::uint64_t hash = 0xcbf29ce484222325ull)
+{
+	for (unsigned char const c: data)
+	{
+		hash ^= c;
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+
+std::string
+glString(GLenum const name)
+{
+	auto const pString = glGetString(name);
+	return pString ? reinterpret_cast<char const*>(pString) : "";
+}
+
+
+std::string
+getLog(
+	GLuint const handle,
+	decltype(glGetShaderiv) writeLength,
+	decltype(glGetShaderInfoLog) writeLog
+)
+{
+	GLint length{0};
+	writeLength(handle, GL_INFO_LOG_LENGTH, &length);
+	std::string log(length, '\0');
+	if (length > 0)
+	{
+		writeLog(handle, length, nullptr, &log[0]);
+	}
+	return log;
+}
+
+
+GLuint
+compileShader(GLenum const type, char const* pSource)
+{
+	GLuint const shader{glCreateShader(type)};
+	glShaderSource(shader, 1, &pSource, nullptr);
+	glCompileShader(shader);
+
+	GLint compiled{GL_FALSE};
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+	if (compiled != GL_TRUE)
+	{
+		auto const log = getLog(shader, glGetShaderiv, glGetShaderInfoLog);
+		glDeleteShader(shader);
+		throw std::runtime_error{"Shader compilation failed: " + log};
+	}
+	return shader;
+}
+
+
+GLuint
+linkProgram(ProgramSource const& source, bool const retrievable)
+{
+	bool const compute{source.pFragment == nullptr};
+	GLuint const firstShader{compileShader(
+		compute ? GL_COMPUTE_SHADER : GL_VERTEX_SHADER, source.pVertex)};
+	GLuint fragmentShader{0u};
+	if (!compute)
+	{
+		try
+		{
+			fragmentShader =
+				compileShader(GL_FRAGMENT_SHADER, source.pFragment);
+		}
+		catch (...)
+		{
+			glDeleteShader(firstShader);
+			throw;
+		}
+	}
+
+	GLuint const program{glCreateProgram()};
+	if (retrievable) {
+		glProgramParameteri(
+			program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	glAttachShader(program, firstShader);
+	if (fragmentShader) {
+		glAttachShader(program, fragmentShader);
+	}
+	glLinkProgram(program);
+	glDetachShader(program, firstShader);
+	glDeleteShader(firstShader);
+	if (fragmentShader)
+	{
+		glDetachShader(program, fragmentShader);
+		glDeleteShader(fragmentShader);
+	}
+
+	GLint linked{GL_FALSE};
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (linked != GL_TRUE)
+	{
+		auto const log = getLog(program, glGetProgramiv, glGetProgramInfoLog);
+		glDeleteProgram(program);
+		throw std::runtime_error{
+			std::string{"Failed to link program '"} + source.pName + "': " +
+			log};
+	}
+	return program;
+}
+
+
+} // namespace
+
+
+ProgramLibrary::ProgramLibrary(std::string cacheDirectory)
+	:	m_programs{}
+	,	m_matrix{{
+			1.0f, 0.0f, 0.0f, 0.0f,
+			0.0f, 1.0f, 0.0f, 0.0f,
+			0.0f, 0.0f, 1.0f, 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f
+		}}
+	,	m_palette{}
+	,	m_cacheDirectory{std::move(cacheDirectory)}
+	,	m_driverKey{}
+	,	m_pointScale{1.0f}
+	,	m_cacheHits{0u}
+{
+	m_programs.fill(Program{0u, -1, -1, -1, e_allBits});
+
+	if (m_cacheDirectory.empty()) {
+		return;
+	}
+
+	GLint numFormats{0};
+	if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary) {
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+	}
+	if (numFormats <= 0)
+	{
+		// Binaries can't be retrieved, so there is nothing to cache.
+		m_cacheDirectory.clear();
+		return;
+	}
+
+	m_driverKey = glString(GL_VENDOR) + '\n' + glString(GL_RENDERER) + '\n' +
+		glString(GL_VERSION);
+}
+
+
+ProgramLibrary::~ProgramLibrary() noexcept
+{
+	for (auto const& program: m_programs)
+	{
+		if (program.id) {
+			glDeleteProgram(program.id);
+		}
+	}
+}
+
+
+GLuint
+ProgramLibrary::program(ProgramKind const kind)
+{
+	auto& program = m_programs[static_cast<std::size_t>(kind)];
+	if (program.id) {
+		return program.id;
+	}
+
+	auto const& source = programSources[static_cast<std::size_t>(kind)];
+	std::string path;
+	if (cachesBinaries())
+	{
+		path = cachePath(kind);
+		program.id = loadCachedProgram(path);
+		if (program.id) {
+			++m_cacheHits;
+		}
+	}
+
+	if (!program.id)
+	{
+		program.id = linkProgram(source, cachesBinaries());
+		if (cachesBinaries()) {
+			saveCachedProgram(program.id, path);
+		}
+	}
+
+	program.matrixLocation = glGetUniformLocation(program.id, "u_mvp");
+	program.pointScaleLocation =
+		glGetUniformLocation(program.id, "u_pointScale");
+	program.paletteLocation = glGetUniformLocation(program.id, "u_palette");
+	program.dirty = e_allBits;
+	return program.id;
+}
+
+
+void
+ProgramLibrary::use(ProgramKind const kind)
+{
+	auto const id = program(kind);
+	auto& program = m_programs[static_cast<std::size_t>(kind)];
+	glUseProgram(id);
+
+	if ((program.dirty & e_matrixBit) && program.matrixLocation >= 0) {
+		glUniformMatrix4fv(
+			program.matrixLocation, 1, GL_FALSE, m_matrix.data());
+	}
+	if ((program.dirty & e_pointScaleBit) && program.pointScaleLocation >= 0)
+	{
+		glUniform1f(program.pointScaleLocation, m_pointScale);
+	}
+	if ((program.dirty & e_paletteBit) && program.paletteLocation >= 0) {
+		glUniform4fv(
+			program.paletteLocation, s_paletteSize, m_palette.data());
+	}
+	program.dirty = 0u;
+}
+
+
+void
+ProgramLibrary::setMatrix(GLfloat const* const pMatrix) noexcept
+{
+	std::copy(pMatrix, pMatrix + m_matrix.size(), m_matrix.begin());
+	markDirty(e_matrixBit);
+}
+
+
+void
+ProgramLibrary::setPointScale(GLfloat const scale) noexcept
+{
+	m_pointScale = scale;
+	markDirty(e_pointScaleBit);
+}
+
+
+void
+ProgramLibrary::setPalette(
+	b2Color const* const pColours,
+	std::size_t const count
+) noexcept
+{
+	auto const used = std::min(count, std::size_t{s_paletteSize});
+	for (std::size_t i = 0; i < used; ++i)
+	{
+		m_palette[4 * i + 0] = pColours[i].r;
+		m_palette[4 * i + 1] = pColours[i].g;
+		m_palette[4 * i + 2] = pColours[i].b;
+		m_palette[4 * i + 3] = pColours[i].a;
+	}
+	markDirty(e_paletteBit);
+}
+
+
+void
+ProgramLibrary::markDirty(unsigned const bits) noexcept
+{
+	for (auto& program: m_programs)
+	{
+		program.dirty |= bits;
+	}
+}
+
+
+std::string
+ProgramLibrary::cachePath(ProgramKind const kind) const
+{
+	auto const& source = programSources[static_cast<std::size_t>(kind)];
+	auto hash = fnv1a(m_driverKey);
+	hash = fnv1a(source.pVertex, hash);
+	if (source.pFragment) {
+		hash = fnv1a(source.pFragment, hash);
+	}
+
+	char hex[17];
+	std::snprintf(
+		hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+	return m_cacheDirectory + "/b2draw-" + source.pName + '-' + hex + ".bin";
+}
+
+
+GLuint
+ProgramLibrary::loadCachedProgram(std::string const& path) const
+{
+	std::ifstream file{path, std::ios::binary};
+	std::uint32_t header[4] = {0u, 0u, 0u, 0u};
+	if (!file.read(reinterpret_cast<char*>(header), sizeof(header))) {
+		return 0u;
+	}
+
+	auto const format = static_cast<GLenum>(header[2]);
+	auto const length = static_cast<GLsizei>(header[3]);
+	if (header[0] != cacheMagic || header[1] != cacheVersion || length <= 0) {
+		return 0u;
+	}
+
+	std::vector<char> binary(length);
+	if (!file.read(binary.data(), length)) {
+		return 0u;
+	}
+
+	// Drivers may reject binaries for any reason, in which case we fall back
+	// to compiling from source.
+	GLuint const program{glCreateProgram()};
+	glProgramBinary(program, format, binary.data(), length);
+	GLint linked{GL_FALSE};
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (linked != GL_TRUE)
+	{
+		glDeleteProgram(program);
+		return 0u;
+	}
+	return program;
+}
+
+
+void
+ProgramLibrary::saveCachedProgram(
+	GLuint const program,
+	std::string const& path
+) const
+{
+	GLint length{0};
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return;
+	}
+
+	std::vector<char> binary(length);
+	GLenum format{0u};
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+
+	// Write to a temporary file and rename it, so that concurrent processes
+	// never read a partial entry. Failing to cache is not an error.
+	auto const tmpPath = path + ".tmp";
+	{
+		std::ofstream file{tmpPath, std::ios::binary | std::ios::trunc};
+		std::uint32_t const header[4] = {
+			cacheMagic,
+			cacheVersion,
+			static_cast<std::uint32_t>(format),
+			static_cast<std::uint32_t>(length)
+		};
+		file.write(reinterpret_cast<char const*>(header), sizeof(header));
+		file.write(binary.data(), length);
+		if (!file) {
+			std::remove(tmpPath.c_str());
+			return;
+		}
+	}
+	std::rename(tmpPath.c_str(), path.c_str());
+}
+
+
+} // namespace b2draw
@@ -0,0 +1,182 @@
+#include <iostream>
+#include <stdexcept>
+
+#include "b2draw/ResourcePool.h"
+
+
+namespace b2draw {
+namespace {
+
+
+#ifndef NDEBUG
+void APIENTRY
+reportDebugMessage(
+	GLenum /* source */,
+	GLenum const type,
+	GLuint const id,
+	GLenum /* severity */,
+	GLsizei const length,
+	GLchar const* const pMessage,
+	void const* /* pUserParam */
+)
+{
+	if (type != GL_DEBUG_TYPE_ERROR) {
+		return;
+	}
+	std::cerr << "[b2draw] GL error " << id << ": ";
+	std::cerr.write(pMessage, length < 0 ? 0 : length);
+	std::cerr << std::endl;
+}
+
+
+/** Report GL errors as they happen, rather than polling glGetError. */
+void
+installDebugCallback() noexcept
+{
+	if (!(GLEW_VERSION_4_3 || GLEW_KHR_debug)) {
+		return;
+	}
+
+	// Don't replace a callback installed by the application.
+	void* pCallback{nullptr};
+	glGetPointerv(GL_DEBUG_CALLBACK_FUNCTION, &pCallback);
+	if (pCallback) {
+		return;
+	}
+
+	glEnable(GL_DEBUG_OUTPUT);
+	glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	glDebugMessageCallback(reportDebugMessage, nullptr);
+}
+#endif
+
+
+} // namespace
+
+
+ResourcePool::ResourcePool() noexcept
+	:	m_buffers{}
+	,	m_initialised{false}
+	,	m_useFences{false}
+	,	m_useDirectStateAccess{false}
+{
+}
+
+
+// No GL calls: the shared pool is destroyed after any context is gone.
+ResourcePool::~ResourcePool() noexcept = default;
+
+
+ResourcePool&
+ResourcePool::shared() noexcept
+{
+	static ResourcePool pool;
+	return pool;
+}
+
+
+void
+ResourcePool::initialise() noexcept
+{
+	if (m_initialised) {
+		return;
+	}
+	m_initialised = true;
+	m_useFences = GLEW_VERSION_3_2 || GLEW_ARB_sync;
+	m_useDirectStateAccess = GLEW_VERSION_4_5 || GLEW_ARB_direct_state_access;
+
+#ifndef NDEBUG
+	installDebugCallback();
+#endif
+}
+
+
+VertexBuffer
+ResourcePool::acquire()
+{
+	if (!m_buffers.empty())
+	{
+		auto const buffer = m_buffers.back();
+		m_buffers.pop_back();
+		return buffer;
+	}
+
+	VertexBuffer buffer{0u, 0u, nullptr, 0, 0u, 0u, 0u};
+	buffer.vbo = createBuffer();
+
+	if (m_useDirectStateAccess) {
+		glCreateVertexArrays(1, &buffer.vao);
+	}
+	else {
+		glGenVertexArrays(1, &buffer.vao);
+	}
+	if (!buffer.vao)
+	{
+		glDeleteBuffers(1, &buffer.vbo);
+		throw std::runtime_error{"Invalid VAO"};
+	}
+	return buffer;
+}
+
+
+GLuint
+ResourcePool::createBuffer()
+{
+	initialise();
+	GLuint buffer{0u};
+	if (m_useDirectStateAccess) {
+		glCreateBuffers(1, &buffer);
+	}
+	else {
+		glGenBuffers(1, &buffer);
+	}
+	if (buffer == 0u) {
+		throw std::runtime_error{"Invalid VBO"};
+	}
+	return buffer;
+}
+
+
+void
+ResourcePool::release(VertexBuffer const& buffer) noexcept
+{
+	try
+	{
+		m_buffers.push_back(buffer);
+	}
+	catch (...)
+	{
+		destroy(buffer);
+	}
+}
+
+
+void
+ResourcePool::clear() noexcept
+{
+	for (auto const& buffer: m_buffers)
+	{
+		destroy(buffer);
+	}
+	m_buffers.clear();
+}
+
+
+void
+ResourcePool::destroy(VertexBuffer const& buffer) noexcept
+{
+	if (buffer.fence) {
+		glDeleteSync(buffer.fence);
+	}
+	GLuint const buffers[] = {
+		buffer.vbo,
+		buffer.elementBuffer,
+		buffer.commandBuffer,
+		buffer.cullBuffer
+	};
+	glDeleteBuffers(4, buffers);
+	glDeleteVertexArrays(1, &buffer.vao);
+}
+
+
+} // namespace b2draw
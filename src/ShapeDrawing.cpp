@@ -0,0 +1,101 @@
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2EdgeShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+
+#include "ShapeDrawing.h"
+
+
+namespace b2draw {
+
+
+/** The colour b2World::DrawDebugData gives a body's shapes. */
+b2Color
+bodyColour(b2Body const& body) noexcept
+{
+	if (!body.IsActive()) {
+		return b2Color{0.5f, 0.5f, 0.3f};
+	}
+	if (body.GetType() == b2_staticBody) {
+		return b2Color{0.5f, 0.9f, 0.5f};
+	}
+	if (body.GetType() == b2_kinematicBody) {
+		return b2Color{0.5f, 0.5f, 0.9f};
+	}
+	if (!body.IsAwake()) {
+		return b2Color{0.6f, 0.6f, 0.6f};
+	}
+	return b2Color{0.9f, 0.7f, 0.7f};
+}
+
+
+/** Draw a fixture's shape as b2World::DrawShape does. */
+void
+drawShape(
+	b2Draw& draw,
+	b2Fixture const& fixture,
+	b2Transform const& xf,
+	b2Color const& colour
+)
+{
+	switch (fixture.GetType())
+	{
+		case b2Shape::e_circle:
+		{
+			auto const& circle =
+				static_cast<b2CircleShape const&>(*fixture.GetShape());
+			draw.DrawSolidCircle(
+				b2Mul(xf, circle.m_p),
+				circle.m_radius,
+				b2Mul(xf.q, b2Vec2{1.0f, 0.0f}),
+				colour
+			);
+			break;
+		}
+
+		case b2Shape::e_edge:
+		{
+			auto const& edge =
+				static_cast<b2EdgeShape const&>(*fixture.GetShape());
+			draw.DrawSegment(
+				b2Mul(xf, edge.m_vertex1), b2Mul(xf, edge.m_vertex2), colour);
+			break;
+		}
+
+		case b2Shape::e_chain:
+		{
+			auto const& chain =
+				static_cast<b2ChainShape const&>(*fixture.GetShape());
+			b2Vec2 v1{b2Mul(xf, chain.m_vertices[0])};
+			for (int32 i = 1; i < chain.m_count; ++i)
+			{
+				b2Vec2 const v2{b2Mul(xf, chain.m_vertices[i])};
+				draw.DrawSegment(v1, v2, colour);
+				draw.DrawCircle(v1, 0.05f, colour);
+				v1 = v2;
+			}
+			break;
+		}
+
+		case b2Shape::e_polygon:
+		{
+			auto const& polygon =
+				static_cast<b2PolygonShape const&>(*fixture.GetShape());
+			b2Vec2 vertices[b2_maxPolygonVertices];
+			for (int32 i = 0; i < polygon.m_count; ++i)
+			{
+				vertices[i] = b2Mul(xf, polygon.m_vertices[i]);
+			}
+			draw.DrawSolidPolygon(vertices, polygon.m_count, colour);
+			break;
+		}
+
+		default:
+			break;
+	}
+}
+
+
+} // namespace b2draw
@@ -0,0 +1,28 @@
+#ifndef HEADER_INCLUDE__RECURSION__PHYSICS__B2__SHAPEDRAWING__H
+#define HEADER_INCLUDE__RECURSION__PHYSICS__B2__SHAPEDRAWING__H
+#include <Box2D/Common/b2Draw.h>
+#include <Box2D/Common/b2Math.h>
+
+class b2Body;
+class b2Fixture;
+
+
+namespace b2draw {
+
+
+/** The colour b2World::DrawDebugData gives a body's shapes. */
+b2Color bodyColour(b2Body const& body) noexcept;
+
+/** Draw a fixture's shape as b2World::DrawShape does. */
+void drawShape(
+	b2Draw& draw,
+	b2Fixture const& fixture,
+	b2Transform const& xf,
+	b2Color const& colour
+);
+
+
+} // namespace b2draw
+
+
+#endif
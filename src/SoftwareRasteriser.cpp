@@ -0,0 +1,754 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "b2draw/algorithm.h"
+#include "b2draw/PointRenderer.h"
+#include "b2draw/SoftwareRasteriser.h"
+
+
+namespace b2draw {
+namespace {
+
+
+/** Fewer vertices than this per thread aren't worth waking a thread for. */
+constexpr std::size_t minVerticesPerWorker{1u << 14};
+
+/** Fewer primitives than this per thread aren't worth binning in parallel. */
+constexpr std::size_t minPrimitivesPerWorker{1u << 12};
+
+/**
+ * How far outside the image vertices may lie, in pixels; further vertices
+ * are clamped. Bounds edge functions so that a tile's row fits 32 bits.
+ */
+constexpr float32 guardBand{16384.0f};
+
+/** Sub-pixel precision of vertex positions, as a power of two. */
+constexpr int subpixelBits{4};
+constexpr int subpixels{1 << subpixelBits};
+
+/**
+ * Edge functions stepped across a tile row stay within 32 bits, and keep
+ * their sign, once their start is clamped to this.
+ */
+constexpr std::int64_t rowLimit{std::int64_t{1} << 30};
+
+
+/** A vertex position, in sixteenths of a pixel. */
+struct Fixed
+{
+	std::int32_t x;
+	std::int32_t y;
+};
+
+
+inline Fixed
+toFixed(b2Vec2 const& position) noexcept
+{
+	// Round by truncating positive values, as positions are within the
+	// guard band.
+	constexpr float32 offset{4.0f * guardBand * subpixels + 0.5f};
+	constexpr std::int32_t bias{std::int32_t(4.0f * guardBand * subpixels)};
+	return Fixed{
+		std::int32_t(position.x * subpixels + offset) - bias,
+		std::int32_t(position.y * subpixels + offset) - bias
+	};
+}
+
+
+inline unsigned char
+toByte(float32 const channel) noexcept
+{
+	return static_cast<unsigned char>(
+		std::min(std::max(channel, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+
+/** Pack a colour so its bytes are in R, G, B, A order in memory. */
+inline std::uint32_t
+pack(b2Color const& colour) noexcept
+{
+	unsigned char const bytes[4] = {
+		toByte(colour.r), toByte(colour.g), toByte(colour.b), toByte(colour.a)
+	};
+	std::uint32_t packed;
+	std::memcpy(&packed, bytes, sizeof(packed));
+	return packed;
+}
+
+
+/**
+ * Blend one pixel as `glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA)`.
+ *
+ * Every channel, alpha included, is `(d * (255 - a) + s * a) / 255`, rounded;
+ * @p source holds `s * a + 128` for each byte of the colour.
+ */
+inline std::uint32_t
+blend(
+	std::uint32_t const destination,
+	std::uint32_t const* const source,
+	std::uint32_t const inverseAlpha
+) noexcept
+{
+	unsigned char bytes[4];
+	std::memcpy(bytes, &destination, sizeof(bytes));
+	for (unsigned i = 0; i < 4; ++i)
+	{
+		std::uint32_t const x{bytes[i] * inverseAlpha + source[i]};
+		bytes[i] = static_cast<unsigned char>((x + (x >> 8)) >> 8);
+	}
+	std::uint32_t result;
+	std::memcpy(&result, bytes, sizeof(result));
+	return result;
+}
+
+
+/** The setup of one polygon edge, `w = a * x + b * y + c`. */
+struct Edge
+{
+	std::int64_t a;
+	std::int64_t b;
+	std::int64_t c;
+
+	/** The edge function at a pixel's centre. */
+	std::int64_t at(int const x, int const y) const noexcept
+	{
+		return
+			a * (x * subpixels + subpixels / 2) +
+			b * (y * subpixels + subpixels / 2) + c;
+	}
+};
+
+
+/** Set up the edge from @p p to @p q, whose inside is on its left. */
+inline Edge
+makeEdge(Fixed const& p, Fixed const& q) noexcept
+{
+	Edge edge{
+		std::int64_t{p.y} - q.y,
+		std::int64_t{q.x} - p.x,
+		std::int64_t{p.x} * q.y - std::int64_t{q.x} * p.y
+	};
+	// Pixel centres exactly on an edge shared by two polygons belong to
+	// exactly one of them, as the edge's direction is reversed in the other.
+	// Bias the owner's edge function so that zero is inside.
+	if (edge.a > 0 || (edge.a == 0 && edge.b > 0))
+	{
+		edge.c += 1;
+	}
+	return edge;
+}
+
+
+/** Clamp an edge function so that stepping along a tile row keeps its sign. */
+inline std::int32_t
+clampRow(std::int64_t const w) noexcept
+{
+	return std::int32_t(std::min(std::max(w, -rowLimit), rowLimit));
+}
+
+
+/**
+ * Fill convex polygons' pixels within a tile, in one colour.
+ *
+ * Box2D only draws convex polygons, so whole fans and line quads are filled
+ * in one pass, rather than set up triangle by triangle.
+ */
+class ConvexFiller
+{
+public:
+	/** The most vertices filled in one pass. */
+	static constexpr unsigned s_maxVertices = 32u;
+
+	ConvexFiller(
+		std::uint32_t* const pPixels,
+		unsigned const stride,
+		std::uint32_t const colour,
+		std::uint32_t const alpha
+	) noexcept
+		:	m_pPixels{pPixels}
+		,	m_stride{stride}
+		,	m_source{}
+		,	m_inverseAlpha{255u - alpha}
+	{
+		unsigned char bytes[4];
+		std::memcpy(bytes, &colour, sizeof(bytes));
+		for (unsigned i = 0; i < 4; ++i)
+		{
+			m_source[i] = bytes[i] * alpha + 128u;
+		}
+	}
+
+	/**
+	 * Fill a polygon, wound either way.
+	 *
+	 * @returns false, filling nothing, if the polygon has too many vertices
+	 * or isn't convex; true otherwise, including if it's degenerate.
+	 */
+	bool fill(
+		Fixed const* const pVertices,
+		unsigned const count,
+		int const (&clip)[4]
+	) const noexcept
+	{
+		if (count > s_maxVertices)
+		{
+			return false;
+		}
+
+		// Pixels whose centres lie within the bounds, and the tile.
+		Fixed lower{pVertices[0]};
+		Fixed upper{pVertices[0]};
+		for (unsigned i = 1; i < count; ++i)
+		{
+			lower.x = std::min(lower.x, pVertices[i].x);
+			lower.y = std::min(lower.y, pVertices[i].y);
+			upper.x = std::max(upper.x, pVertices[i].x);
+			upper.y = std::max(upper.y, pVertices[i].y);
+		}
+		auto const firstPixel = [](std::int32_t const v) {
+			return int((v - subpixels / 2 + subpixels - 1) >> subpixelBits);
+		};
+		auto const lastPixel = [](std::int32_t const v) {
+			return int((v - subpixels / 2) >> subpixelBits);
+		};
+		int const minX{std::max(firstPixel(lower.x), clip[0])};
+		int const minY{std::max(firstPixel(lower.y), clip[1])};
+		int const maxX{std::min(lastPixel(upper.x), clip[2] - 1)};
+		int const maxY{std::min(lastPixel(upper.y), clip[3] - 1)};
+		if (minX > maxX || minY > maxY)
+		{
+			return true;
+		}
+
+		// Every turn must be the same way; wind so that the inside is on the
+		// left of each edge, skipping repeated vertices.
+		int winding{0};
+		for (unsigned i = 0; i < count; ++i)
+		{
+			auto const& p = pVertices[i];
+			auto const& q = pVertices[(i + 1) % count];
+			auto const& r = pVertices[(i + 2) % count];
+			std::int64_t const turn{
+				(std::int64_t{q.x} - p.x) * (std::int64_t{r.y} - q.y) -
+				(std::int64_t{q.y} - p.y) * (std::int64_t{r.x} - q.x)};
+			int const sign{(turn > 0) - (turn < 0)};
+			if (sign && winding && sign != winding)
+			{
+				return false;
+			}
+			winding = sign ? sign : winding;
+		}
+		if (!winding)
+		{
+			return true;
+		}
+
+		Edge edges[s_maxVertices];
+		unsigned edgeCount{0u};
+		for (unsigned i = 0; i < count; ++i)
+		{
+			auto const& p = pVertices[i];
+			auto const& q = pVertices[(i + 1) % count];
+			if (p.x != q.x || p.y != q.y)
+			{
+				edges[edgeCount++] =
+					winding > 0 ? makeEdge(p, q) : makeEdge(q, p);
+			}
+		}
+		fillEdges(edges, edgeCount, minX, minY, maxX, maxY);
+		return true;
+	}
+
+	/** Fill a triangle, wound either way. */
+	void fill(
+		Fixed const& a,
+		Fixed const& b,
+		Fixed const& c,
+		int const (&clip)[4]
+	) const noexcept
+	{
+		Fixed const vertices[3] = {a, b, c};
+		fill(vertices, 3u, clip);
+	}
+
+private:
+	void fillEdges(
+		Edge const* const pEdges,
+		unsigned const count,
+		int const minX,
+		int const minY,
+		int const maxX,
+		int const maxY
+	) const noexcept
+	{
+		// Start on a multiple of four, so that groups never cross a row.
+		int const startX{minX & ~3};
+		std::int64_t rows[s_maxVertices];
+		std::int32_t steps[s_maxVertices];
+		for (unsigned i = 0; i < count; ++i)
+		{
+			rows[i] = pEdges[i].at(startX, minY);
+			steps[i] = std::int32_t(pEdges[i].a * subpixels);
+		}
+
+#if defined(__SSE2__)
+		__m128i const zero{_mm_setzero_si128()};
+		__m128i const source{_mm_setr_epi16(
+			short(m_source[0]), short(m_source[1]),
+			short(m_source[2]), short(m_source[3]),
+			short(m_source[0]), short(m_source[1]),
+			short(m_source[2]), short(m_source[3]))};
+		__m128i const inverseAlpha{_mm_set1_epi16(short(m_inverseAlpha))};
+		auto const blendHalf = [&](__m128i half) {
+			half = _mm_add_epi16(_mm_mullo_epi16(half, inverseAlpha), source);
+			half = _mm_add_epi16(half, _mm_srli_epi16(half, 8));
+			return _mm_srli_epi16(half, 8);
+		};
+
+		// Each lane's offset along the row; SSE2 has no 32-bit multiply.
+		__m128i offsets[s_maxVertices];
+		__m128i groupSteps[s_maxVertices];
+		for (unsigned i = 0; i < count; ++i)
+		{
+			__m128i const step{_mm_set1_epi32(steps[i])};
+			offsets[i] = _mm_add_epi32(
+				_mm_and_si128(step, _mm_setr_epi32(0, -1, 0, -1)),
+				_mm_and_si128(
+					_mm_add_epi32(step, step), _mm_setr_epi32(0, 0, -1, -1)));
+			groupSteps[i] = _mm_slli_epi32(step, 2);
+		}
+		__m128i const columns{_mm_add_epi32(
+			_mm_set1_epi32(startX), _mm_setr_epi32(0, 1, 2, 3))};
+		__m128i const first{_mm_set1_epi32(minX - 1)};
+		__m128i const last{_mm_set1_epi32(maxX + 1)};
+
+		__m128i w[s_maxVertices];
+		for (int y = minY; y <= maxY; ++y)
+		{
+			auto const pRow = m_pPixels + std::size_t(y) * m_stride;
+			for (unsigned i = 0; i < count; ++i)
+			{
+				w[i] = _mm_add_epi32(
+					_mm_set1_epi32(clampRow(rows[i])), offsets[i]);
+				rows[i] += pEdges[i].b * subpixels;
+			}
+			__m128i column{columns};
+			for (int x = startX; x <= maxX; x += 4)
+			{
+				__m128i mask{_mm_and_si128(
+					_mm_cmpgt_epi32(column, first),
+					_mm_cmplt_epi32(column, last))};
+				column = _mm_add_epi32(column, _mm_set1_epi32(4));
+				for (unsigned i = 0; i < count; ++i)
+				{
+					mask = _mm_and_si128(mask, _mm_cmpgt_epi32(w[i], zero));
+					w[i] = _mm_add_epi32(w[i], groupSteps[i]);
+				}
+				if (!_mm_movemask_epi8(mask))
+				{
+					continue;
+				}
+
+				auto const pGroup = reinterpret_cast<__m128i*>(pRow + x);
+				__m128i const destination{_mm_loadu_si128(pGroup)};
+				__m128i const blended{_mm_packus_epi16(
+					blendHalf(_mm_unpacklo_epi8(destination, zero)),
+					blendHalf(_mm_unpackhi_epi8(destination, zero)))};
+				_mm_storeu_si128(pGroup, _mm_or_si128(
+					_mm_and_si128(mask, blended),
+					_mm_andnot_si128(mask, destination)));
+			}
+		}
+#else
+		std::int32_t w[s_maxVertices];
+		for (int y = minY; y <= maxY; ++y)
+		{
+			auto const pRow = m_pPixels + std::size_t(y) * m_stride;
+			for (unsigned i = 0; i < count; ++i)
+			{
+				w[i] = clampRow(rows[i]);
+				rows[i] += pEdges[i].b * subpixels;
+			}
+			for (int x = startX; x <= maxX; ++x)
+			{
+				bool inside{x >= minX};
+				for (unsigned i = 0; i < count; ++i)
+				{
+					inside = inside && w[i] > 0;
+					w[i] += steps[i];
+				}
+				if (inside)
+				{
+					pRow[x] = blend(pRow[x], m_source, m_inverseAlpha);
+				}
+			}
+		}
+#endif
+	}
+
+	std::uint32_t* m_pPixels;
+	unsigned m_stride;
+	std::uint32_t m_source[4];
+	std::uint32_t m_inverseAlpha;
+};
+
+
+} // namespace
+
+
+SoftwareRasteriser::SoftwareRasteriser(
+	unsigned const width,
+	unsigned const height,
+	unsigned const threads,
+	WorkerPool& workers
+)
+	:	m_width{width}
+	,	m_height{height}
+	,	m_stride{(width + 3u) & ~3u}
+	,	m_tileColumns{(width + s_tileSize - 1u) / s_tileSize}
+	,	m_tileRows{(height + s_tileSize - 1u) / s_tileSize}
+	,	m_threads{threads ?
+			threads : std::max(std::thread::hardware_concurrency(), 1u)}
+	,	m_pWorkers{&workers}
+	,	m_pixels{}
+	,	m_lower{0.0f, float32(height)}
+	,	m_scale{1.0f, -1.0f}
+	,	m_pointSize{PointRenderer::s_defaultSize}
+	,	m_positions{}
+	,	m_primitives{}
+	,	m_bins{}
+	,	m_binWorkers{0u}
+{
+	if (float32(width) > guardBand || float32(height) > guardBand)
+	{
+		throw std::runtime_error{"SoftwareRasteriser: image too large"};
+	}
+	m_pixels.assign(std::size_t(m_stride) * m_height, 0u);
+}
+
+
+void
+SoftwareRasteriser::setView(b2Vec2 const& lower, b2Vec2 const& upper) noexcept
+{
+	// Flip vertically, so that the top row comes first.
+	b2Vec2 const extents{upper - lower};
+	m_lower.Set(lower.x, upper.y);
+	m_scale.Set(
+		extents.x > 0.0f ? m_width / extents.x : 0.0f,
+		extents.y > 0.0f ? -(m_height / extents.y) : 0.0f);
+}
+
+
+b2Vec2
+SoftwareRasteriser::toPixels(b2Vec2 const& position) const noexcept
+{
+	auto const limit = [](float32 const value) {
+		// Also sends NaNs out of sight.
+		return value >= -guardBand ? std::min(value, guardBand) : -guardBand;
+	};
+	return b2Vec2{
+		limit((position.x - m_lower.x) * m_scale.x),
+		limit((position.y - m_lower.y) * m_scale.y)
+	};
+}
+
+
+void
+SoftwareRasteriser::clear(b2Color const& colour)
+{
+	std::fill(m_pixels.begin(), m_pixels.end(), pack(colour));
+}
+
+
+void
+SoftwareRasteriser::draw(GLenum const mode, PrimitiveView const& primitives)
+{
+	FrameView frame;
+	frame.flags = 0u;
+	frame.sectionCount = 1u;
+	frame.sections[0] = FrameSection{mode, primitives};
+	draw(frame);
+}
+
+
+void
+SoftwareRasteriser::draw(FrameView const& frame)
+{
+	std::size_t const tiles{std::size_t(m_tileColumns) * m_tileRows};
+	if (!tiles)
+	{
+		return;
+	}
+	bin(frame);
+	if (m_primitives.empty())
+	{
+		return;
+	}
+
+	std::atomic<std::size_t> nextTile{0u};
+	m_pWorkers->parallelFor(
+		std::min<std::size_t>(m_threads, tiles),
+		std::min<std::size_t>(m_threads, tiles),
+		[&](std::size_t, std::size_t, std::size_t) {
+			std::size_t tile;
+			while ((tile = nextTile.fetch_add(1u)) < tiles)
+			{
+				drawTile(tile);
+			}
+		}
+	);
+}
+
+
+void
+SoftwareRasteriser::bin(FrameView const& frame)
+{
+	// Lay out every section's vertices and primitives end to end, in the
+	// order drawn.
+	std::size_t vertexCount{0u};
+	std::size_t sectionStarts[FrameView::s_maxSections + 1u];
+	m_primitives.clear();
+	for (std::size_t i = 0; i < frame.sectionCount; ++i)
+	{
+		auto const& section = frame.sections[i];
+		auto const& view = section.primitives;
+		sectionStarts[i] = vertexCount;
+		for (std::size_t j = 0; j < view.polygonCount; ++j)
+		{
+			auto const first = std::size_t(view.pFirstIndices[j]);
+			auto const count = std::size_t(view.pPolygonSizes[j]);
+			if (!count || first + count > view.vertexCount)
+			{
+				continue;
+			}
+			auto const& colour = view.pVertices[first].second;
+			std::uint32_t const alpha{toByte(colour.a)};
+			if (alpha)
+			{
+				m_primitives.push_back(Primitive{
+					std::uint32_t(vertexCount + first),
+					std::uint32_t(count),
+					section.mode,
+					pack(colour),
+					alpha
+				});
+			}
+		}
+		vertexCount += view.vertexCount;
+	}
+	sectionStarts[frame.sectionCount] = vertexCount;
+
+	m_positions.resize(vertexCount);
+	m_pWorkers->parallelFor(
+		vertexCount,
+		std::min<std::size_t>(
+			m_threads,
+			algorithm::workerCount(vertexCount, minVerticesPerWorker)),
+		[&](std::size_t begin, std::size_t const end, std::size_t) {
+			std::size_t section{0u};
+			for (; begin < end; ++begin)
+			{
+				while (begin >= sectionStarts[section + 1u])
+				{
+					++section;
+				}
+				auto const& view = frame.sections[section].primitives;
+				m_positions[begin] = toPixels(
+					view.pVertices[begin - sectionStarts[section]].first);
+			}
+		}
+	);
+
+	// Each worker bins a contiguous slice, so reading the bins in worker
+	// order keeps every tile's primitives in drawing order.
+	std::size_t const tiles{std::size_t(m_tileColumns) * m_tileRows};
+	m_binWorkers = std::min<std::size_t>(
+		m_threads,
+		algorithm::workerCount(m_primitives.size(), minPrimitivesPerWorker));
+	if (m_bins.size() < m_binWorkers * tiles)
+	{
+		m_bins.resize(m_binWorkers * tiles);
+	}
+	m_pWorkers->parallelFor(
+		m_primitives.size(),
+		m_binWorkers,
+		[&](std::size_t begin, std::size_t const end, std::size_t worker) {
+			auto const pBins = m_bins.data() + worker * tiles;
+			for (auto pBin = pBins; pBin < pBins + tiles; ++pBin)
+			{
+				pBin->clear();
+			}
+			for (; begin < end; ++begin)
+			{
+				auto const& primitive = m_primitives[begin];
+				auto const pFirst = m_positions.data() + primitive.firstVertex;
+				b2Vec2 lower{pFirst[0]};
+				b2Vec2 upper{pFirst[0]};
+				std::for_each(
+					pFirst + 1,
+					pFirst + primitive.vertexCount,
+					[&](b2Vec2 const& position) {
+						lower = b2Min(lower, position);
+						upper = b2Max(upper, position);
+					}
+				);
+				// Lines and points reach beyond their vertices.
+				float32 const margin{
+					primitive.mode == GL_TRIANGLE_FAN ? 0.0f :
+					primitive.mode == GL_POINTS ? 0.5f * m_pointSize + 1.0f :
+					1.0f};
+				lower -= b2Vec2{margin, margin};
+				upper += b2Vec2{margin, margin};
+				if (
+					upper.x < 0.0f || upper.y < 0.0f ||
+					lower.x >= m_width || lower.y >= m_height
+				)
+				{
+					continue;
+				}
+
+				auto const tile = [](float32 const pixels, unsigned const n) {
+					unsigned const index{
+						unsigned(std::max(pixels, 0.0f)) / s_tileSize};
+					return std::min(index, n - 1u);
+				};
+				unsigned const minColumn{tile(lower.x, m_tileColumns)};
+				unsigned const maxColumn{tile(upper.x, m_tileColumns)};
+				unsigned const minRow{tile(lower.y, m_tileRows)};
+				unsigned const maxRow{tile(upper.y, m_tileRows)};
+				for (unsigned row = minRow; row <= maxRow; ++row)
+				{
+					auto const pRow = pBins + row * m_tileColumns;
+					for (auto c = minColumn; c <= maxColumn; ++c)
+					{
+						pRow[c].push_back(std::uint32_t(begin));
+					}
+				}
+			}
+		}
+	);
+}
+
+
+void
+SoftwareRasteriser::drawTile(std::size_t const tile) noexcept
+{
+	std::size_t const tiles{std::size_t(m_tileColumns) * m_tileRows};
+	int const column{int(tile % m_tileColumns)};
+	int const row{int(tile / m_tileColumns)};
+	Rect const clip{
+		column * int(s_tileSize),
+		row * int(s_tileSize),
+		std::min((column + 1) * int(s_tileSize), int(m_width)),
+		std::min((row + 1) * int(s_tileSize), int(m_height))
+	};
+	for (std::size_t worker = 0; worker < m_binWorkers; ++worker)
+	{
+		for (auto const index: m_bins[worker * tiles + tile])
+		{
+			drawPrimitive(m_primitives[index], clip);
+		}
+	}
+}
+
+
+void
+SoftwareRasteriser::drawPrimitive(
+	Primitive const& primitive,
+	Rect const& clip
+) noexcept
+{
+	int const bounds[4] = {clip.minX, clip.minY, clip.maxX, clip.maxY};
+	ConvexFiller const filler{
+		m_pixels.data(), m_stride, primitive.colour, primitive.alpha};
+	auto const pVertices = m_positions.data() + primitive.firstVertex;
+	auto const count = primitive.vertexCount;
+
+	// Lines are one pixel wide, and points @ref m_pointSize; both are drawn
+	// as quads.
+	auto const fillQuad = [&](
+		b2Vec2 const& p,
+		b2Vec2 const& q,
+		b2Vec2 const& halfWidth
+	) {
+		Fixed const corners[4] = {
+			toFixed(p + halfWidth),
+			toFixed(q + halfWidth),
+			toFixed(q - halfWidth),
+			toFixed(p - halfWidth)
+		};
+		filler.fill(corners, 4u, bounds);
+	};
+	auto const drawLine = [&](b2Vec2 const& p, b2Vec2 const& q) {
+		b2Vec2 direction{q - p};
+		if (direction.Normalize() > 0.0f)
+		{
+			fillQuad(p, q, 0.5f * b2Vec2{-direction.y, direction.x});
+		}
+	};
+
+	switch (primitive.mode)
+	{
+	case GL_TRIANGLE_FAN:
+		{
+			Fixed fan[ConvexFiller::s_maxVertices];
+			if (count <= ConvexFiller::s_maxVertices)
+			{
+				std::transform(pVertices, pVertices + count, fan, toFixed);
+				if (filler.fill(fan, count, bounds))
+				{
+					break;
+				}
+			}
+
+			// Concave or very round; fill triangle by triangle instead.
+			Fixed const centre{toFixed(pVertices[0])};
+			for (std::uint32_t i = 2; i < count; ++i)
+			{
+				filler.fill(
+					centre,
+					toFixed(pVertices[i - 1]),
+					toFixed(pVertices[i]),
+					bounds);
+			}
+		}
+		break;
+
+	case GL_LINE_LOOP:
+	case GL_LINE_STRIP:
+		for (std::uint32_t i = 1; i < count; ++i)
+		{
+			drawLine(pVertices[i - 1], pVertices[i]);
+		}
+		if (primitive.mode == GL_LINE_LOOP && count > 1)
+		{
+			drawLine(pVertices[count - 1], pVertices[0]);
+		}
+		break;
+
+	case GL_POINTS:
+		{
+			float32 const half{0.5f * m_pointSize};
+			for (std::uint32_t i = 0; i < count; ++i)
+			{
+				b2Vec2 const left{pVertices[i].x - half, pVertices[i].y};
+				b2Vec2 const right{pVertices[i].x + half, pVertices[i].y};
+				fillQuad(left, right, b2Vec2{0.0f, half});
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+
+} // namespace b2draw
@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include "b2draw/SpatialIndex.h"
+
+
+namespace b2draw {
+namespace {
+
+
+/** The most cells per box; more only add empty cells to search. */
+constexpr std::size_t maxCellsPerBox{4u};
+
+
+inline bool
+isFinite(SpatialIndex::Bounds const& box) noexcept
+{
+	return
+		std::isfinite(box.lower.x) && std::isfinite(box.lower.y) &&
+		std::isfinite(box.upper.x) && std::isfinite(box.upper.y);
+}
+
+
+} // namespace
+
+
+SpatialIndex::SpatialIndex()
+	:	m_boxes{}
+	,	m_lower{0.0f, 0.0f}
+	,	m_inverseCellSize{1.0f}
+	,	m_columns{0u}
+	,	m_rows{0u}
+	,	m_cellStarts(1u, 0u)
+	,	m_entries{}
+{
+}
+
+
+void
+SpatialIndex::build(Bounds const* const pBoxes, std::size_t const count)
+{
+	m_boxes.assign(pBoxes, pBoxes + count);
+	m_columns = 0u;
+	m_rows = 0u;
+	m_cellStarts.assign(1u, 0u);
+	m_entries.clear();
+
+	// Size cells to the average box, so most boxes cover only a few.
+	float32 constexpr infinity{std::numeric_limits<float32>::infinity()};
+	b2Vec2 lower{infinity, infinity};
+	b2Vec2 upper{-infinity, -infinity};
+	double totalSize{0.0};
+	std::size_t finiteCount{0u};
+	for (auto const& box: m_boxes)
+	{
+		if (!isFinite(box)) {
+			continue;
+		}
+		lower = b2Min(lower, box.lower);
+		upper = b2Max(upper, box.upper);
+		totalSize += std::max(
+			box.upper.x - box.lower.x, box.upper.y - box.lower.y);
+		++finiteCount;
+	}
+	if (!finiteCount)
+	{
+		return;
+	}
+
+	b2Vec2 const extents{upper - lower};
+	float32 cellSize{std::max({
+		float32(totalSize / finiteCount),
+		std::sqrt(extents.x * extents.y / finiteCount),
+		std::max(extents.x, extents.y) / finiteCount,
+		std::numeric_limits<float32>::min()
+	})};
+	auto const side = [&](float32 const extent) {
+		return std::size_t(extent / cellSize) + 1u;
+	};
+	while (side(extents.x) * side(extents.y) > maxCellsPerBox * finiteCount)
+	{
+		cellSize *= 2.0f;
+	}
+	m_lower = lower;
+	m_inverseCellSize = 1.0f / cellSize;
+	m_columns = unsigned(side(extents.x));
+	m_rows = unsigned(side(extents.y));
+
+	// Count each cell's entries, then lay the cells out end to end, each
+	// start temporarily pointing at the end of its cell while filling.
+	m_cellStarts.assign(cellCount() + 1u, 0u);
+	for (auto const& box: m_boxes)
+	{
+		if (!isFinite(box)) {
+			continue;
+		}
+		auto const range = cells(box);
+		for (auto row = range.minRow; row <= range.maxRow; ++row)
+		{
+			auto const pRow = m_cellStarts.data() + row * m_columns + 1u;
+			for (auto c = range.minColumn; c <= range.maxColumn; ++c)
+			{
+				++pRow[c];
+			}
+		}
+	}
+	std::partial_sum(
+		m_cellStarts.begin(), m_cellStarts.end(), m_cellStarts.begin());
+
+	m_entries.resize(m_cellStarts.back());
+	for (std::size_t i = 0; i < m_boxes.size(); ++i)
+	{
+		if (!isFinite(m_boxes[i])) {
+			continue;
+		}
+		auto const range = cells(m_boxes[i]);
+		for (auto row = range.minRow; row <= range.maxRow; ++row)
+		{
+			auto const pRow = m_cellStarts.data() + row * m_columns;
+			for (auto c = range.minColumn; c <= range.maxColumn; ++c)
+			{
+				m_entries[pRow[c]++] = std::uint32_t(i);
+			}
+		}
+	}
+	std::copy_backward(
+		m_cellStarts.begin(), m_cellStarts.end() - 1u, m_cellStarts.end());
+	m_cellStarts.front() = 0u;
+}
+
+
+void
+SpatialIndex::query(
+	Bounds const& bounds,
+	std::vector<std::size_t>& indices
+) const
+{
+	if (!cellCount())
+	{
+		return;
+	}
+
+	auto const begin = indices.size();
+	auto const range = cells(bounds);
+	for (auto row = range.minRow; row <= range.maxRow; ++row)
+	{
+		for (auto c = range.minColumn; c <= range.maxColumn; ++c)
+		{
+			auto const cell = row * m_columns + c;
+			auto const pEnd = m_entries.data() + m_cellStarts[cell + 1u];
+			auto pEntry = m_entries.data() + m_cellStarts[cell];
+			for (; pEntry < pEnd; ++pEntry)
+			{
+				auto const& box = m_boxes[*pEntry];
+				if (
+					box.lower.x <= bounds.upper.x &&
+					box.lower.y <= bounds.upper.y &&
+					box.upper.x >= bounds.lower.x &&
+					box.upper.y >= bounds.lower.y
+				)
+				{
+					indices.push_back(*pEntry);
+				}
+			}
+		}
+	}
+
+	// Boxes covering several cells are found in each.
+	std::sort(indices.begin() + begin, indices.end());
+	indices.erase(
+		std::unique(indices.begin() + begin, indices.end()), indices.end());
+}
+
+
+SpatialIndex::CellRange
+SpatialIndex::cells(Bounds const& bounds) const noexcept
+{
+	auto const toCell = [this](float32 const value, unsigned const count) {
+		// Also sends NaNs to the first cell.
+		float32 const cell{value * m_inverseCellSize};
+		return cell >= 0.0f
+			? unsigned(std::min(cell, float32(count - 1u)))
+			: 0u;
+	};
+	b2Vec2 const lower{bounds.lower - m_lower};
+	b2Vec2 const upper{bounds.upper - m_lower};
+	return CellRange{
+		toCell(lower.x, m_columns),
+		toCell(lower.y, m_rows),
+		toCell(upper.x, m_columns),
+		toCell(upper.y, m_rows)
+	};
+}
+
+
+} // namespace b2draw
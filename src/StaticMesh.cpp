@@ -0,0 +1,370 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+#include <unordered_map>
+
+#include "b2draw/StaticMesh.h"
+
+
+namespace b2draw {
+namespace {
+
+
+/** Merges vertices of the same colour lying within a distance of each other. */
+class Welder
+{
+public:
+	explicit Welder(float32 const epsilon)
+		:	m_epsilon{std::max(epsilon, b2_epsilon)}
+		,	m_vertices{}
+		,	m_cells{}
+	{
+	}
+
+	/** @returns the index of the welded vertex. */
+	GLuint add(Vertex const& vertex)
+	{
+		auto const cx = cell(vertex.first.x);
+		auto const cy = cell(vertex.first.y);
+
+		// A match may lie in a neighbouring cell if near the boundary.
+		for (std::int32_t x = cx - 1; x <= cx + 1; ++x)
+		{
+			for (std::int32_t y = cy - 1; y <= cy + 1; ++y)
+			{
+				auto const found = m_cells.find(key(x, y));
+				if (found == m_cells.end()) {
+					continue;
+				}
+				for (auto const index: found->second)
+				{
+					if (matches(m_vertices[index], vertex)) {
+						return index;
+					}
+				}
+			}
+		}
+
+		GLuint const index = m_vertices.size();
+		m_vertices.push_back(vertex);
+		m_cells[key(cx, cy)].push_back(index);
+		return index;
+	}
+
+	inline std::vector<Vertex> const& vertices() const noexcept
+	{ return m_vertices; }
+
+private:
+	inline std::int32_t cell(float32 const coordinate) const noexcept
+	{ return std::int32_t(std::floor(coordinate / m_epsilon)); }
+
+	static inline std::uint64_t key(
+		std::int32_t const x,
+		std::int32_t const y
+	) noexcept
+	{
+		return (std::uint64_t(std::uint32_t(x)) << 32) | std::uint32_t(y);
+	}
+
+	inline bool matches(Vertex const& a, Vertex const& b) const noexcept
+	{
+		return
+			std::abs(a.first.x - b.first.x) <= m_epsilon &&
+			std::abs(a.first.y - b.first.y) <= m_epsilon &&
+			a.second.r == b.second.r && a.second.g == b.second.g &&
+			a.second.b == b.second.b && a.second.a == b.second.a;
+	}
+
+	float32 m_epsilon;
+	std::vector<Vertex> m_vertices;
+	std::unordered_map<std::uint64_t, std::vector<GLuint>> m_cells;
+};
+
+
+/** A line edge between welded vertices, lowest index first. */
+struct Edge
+{
+	GLuint a;
+	GLuint b;
+
+	/** The loop the edge outlines, or -1 for strips, which have no inside. */
+	std::ptrdiff_t loop;
+
+	inline bool operator<(Edge const& other) const noexcept
+	{
+		return std::tie(a, b, loop) < std::tie(other.a, other.b, other.loop);
+	}
+};
+
+
+/** Add the edges of each of a section's primitives. */
+void
+addEdges(
+	Welder& welder,
+	PrimitiveView const& primitives,
+	bool const loops,
+	std::ptrdiff_t& nextLoop,
+	std::vector<Edge>& edges
+)
+{
+	for (std::size_t i = 0; i < primitives.polygonCount; ++i)
+	{
+		auto const pFirst = primitives.pVertices + primitives.pFirstIndices[i];
+		auto const size = primitives.pPolygonSizes[i];
+		if (size < 2) {
+			continue;
+		}
+
+		auto const loop = loops ? nextLoop++ : -1;
+		GLuint const first = welder.add(pFirst[0]);
+		GLuint previous = first;
+		for (GLsizei j = 1; j < size; ++j)
+		{
+			GLuint const current = welder.add(pFirst[j]);
+			edges.push_back(Edge{
+				std::min(previous, current),
+				std::max(previous, current),
+				loop
+			});
+			previous = current;
+		}
+
+		// Two-vertex loops are segments, so would otherwise be drawn twice.
+		if (loops && size > 2) {
+			edges.push_back(Edge{
+				std::min(previous, first), std::max(previous, first), loop});
+		}
+	}
+}
+
+
+/** Add fan-triangulated triangles for each of a section's primitives. */
+void
+addTriangles(
+	Welder& welder,
+	PrimitiveView const& primitives,
+	std::vector<GLuint>& indices
+)
+{
+	for (std::size_t i = 0; i < primitives.polygonCount; ++i)
+	{
+		auto const pFirst = primitives.pVertices + primitives.pFirstIndices[i];
+		auto const size = primitives.pPolygonSizes[i];
+		if (size < 3) {
+			continue;
+		}
+
+		GLuint const first = welder.add(pFirst[0]);
+		GLuint previous = welder.add(pFirst[1]);
+		for (GLsizei j = 2; j < size; ++j)
+		{
+			GLuint const current = welder.add(pFirst[j]);
+			if (first != previous && previous != current && current != first)
+			{
+				indices.push_back(first);
+				indices.push_back(previous);
+				indices.push_back(current);
+			}
+			previous = current;
+		}
+	}
+}
+
+
+} // namespace
+
+
+StaticMesh::StaticMesh(
+	GLint const positionAttribLocation,
+	GLint const colourAttribLocation,
+	ResourcePool& pool
+)
+	:	m_pPool{&pool}
+	,	m_buffer{0u, 0u, nullptr, 0, 0u, 0u, 0u}
+	,	m_hasBuffer{false}
+	,	m_positionLocation{positionAttribLocation}
+	,	m_colourLocation{colourAttribLocation}
+	,	m_lineIndexCount{0}
+	,	m_triangleIndexCount{0}
+	,	m_stats{}
+{
+}
+
+
+StaticMesh::~StaticMesh() noexcept
+{
+	if (!m_hasBuffer) {
+		return;
+	}
+
+	glBindVertexArray(m_buffer.vao);
+	for (auto const location: {m_positionLocation, m_colourLocation})
+	{
+		if (location >= 0) {
+			glDisableVertexAttribArray(location);
+		}
+	}
+	m_pPool->release(m_buffer);
+}
+
+
+void
+StaticMesh::build(FrameView const& frame, float32 const epsilon)
+{
+	auto const geometry = weld(frame, epsilon);
+	auto const& vertices = geometry.vertices;
+	auto const& indices = geometry.indices;
+	m_lineIndexCount = geometry.lineIndexCount;
+	m_triangleIndexCount = indices.size() - geometry.lineIndexCount;
+	m_stats = geometry.stats;
+
+	if (!m_hasBuffer)
+	{
+		m_buffer = m_pPool->acquire();
+		m_hasBuffer = true;
+		if (!m_buffer.elementBuffer) {
+			m_buffer.elementBuffer = m_pPool->createBuffer();
+		}
+		applyAttribLocations();
+	}
+
+	// The element buffer binding is part of the vertex array.
+	glBindVertexArray(m_buffer.vao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer.vbo);
+	glBufferData(
+		GL_ARRAY_BUFFER,
+		vertices.size() * sizeof(Vertex),
+		vertices.data(),
+		GL_STATIC_DRAW
+	);
+	m_buffer.capacity = vertices.size() * sizeof(Vertex);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_buffer.elementBuffer);
+	glBufferData(
+		GL_ELEMENT_ARRAY_BUFFER,
+		indices.size() * sizeof(GLuint),
+		indices.data(),
+		GL_STATIC_DRAW
+	);
+}
+
+
+StaticMesh::Geometry
+StaticMesh::weld(FrameView const& frame, float32 const epsilon)
+{
+	Welder welder{epsilon};
+	std::vector<Edge> edges;
+	std::vector<GLuint> triangles;
+	std::ptrdiff_t nextLoop{0};
+	Geometry geometry{{}, {}, 0u, Stats{}};
+	auto& stats = geometry.stats;
+
+	for (std::size_t i = 0; i < frame.sectionCount; ++i)
+	{
+		auto const& section = frame.sections[i];
+		switch (section.mode)
+		{
+			case GL_LINE_LOOP:
+			case GL_LINE_STRIP:
+				addEdges(
+					welder,
+					section.primitives,
+					section.mode == GL_LINE_LOOP,
+					nextLoop,
+					edges
+				);
+				break;
+
+			case GL_TRIANGLE_FAN:
+				addTriangles(welder, section.primitives, triangles);
+				break;
+
+			default:
+				continue;
+		}
+		stats.inputVertices += section.primitives.vertexCount;
+	}
+
+	// Sort coincident edges together, then keep one of each, unless it's
+	// shared by exactly two loops, and so inside the shape they form.
+	std::sort(edges.begin(), edges.end());
+	auto& indices = geometry.indices;
+	indices.reserve(2 * edges.size() + triangles.size());
+	for (auto begin = edges.begin(); begin != edges.end();)
+	{
+		auto end = begin + 1;
+		while (end != edges.end() && end->a == begin->a && end->b == begin->b) {
+			++end;
+		}
+
+		bool const internal{
+			end - begin == 2 && begin->loop >= 0 &&
+			begin->loop != (begin + 1)->loop
+		};
+		if (!internal && begin->a != begin->b)
+		{
+			indices.push_back(begin->a);
+			indices.push_back(begin->b);
+		}
+		begin = end;
+	}
+	geometry.lineIndexCount = indices.size();
+	indices.insert(indices.end(), triangles.begin(), triangles.end());
+
+	geometry.vertices = welder.vertices();
+	stats.vertices = geometry.vertices.size();
+	stats.edges = geometry.lineIndexCount / 2;
+	stats.droppedEdges = edges.size() - stats.edges;
+	stats.triangles = triangles.size() / 3;
+	return geometry;
+}
+
+
+void
+StaticMesh::render() noexcept
+{
+	if (empty()) {
+		return;
+	}
+
+	glBindVertexArray(m_buffer.vao);
+	if (m_lineIndexCount) {
+		glDrawElements(GL_LINES, m_lineIndexCount, GL_UNSIGNED_INT, nullptr);
+	}
+	if (m_triangleIndexCount)
+	{
+		glDrawElements(
+			GL_TRIANGLES,
+			m_triangleIndexCount,
+			GL_UNSIGNED_INT,
+			reinterpret_cast<void const*>(m_lineIndexCount * sizeof(GLuint))
+		);
+	}
+}
+
+
+void
+StaticMesh::applyAttribLocations() const noexcept
+{
+	glBindVertexArray(m_buffer.vao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer.vbo);
+
+	if (m_positionLocation >= 0)
+	{
+		glEnableVertexAttribArray(m_positionLocation);
+		glVertexAttribPointer(
+			m_positionLocation, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+			nullptr);
+	}
+
+	if (m_colourLocation >= 0)
+	{
+		glEnableVertexAttribArray(m_colourLocation);
+		glVertexAttribPointer(
+			m_colourLocation, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+			reinterpret_cast<void const*>(offsetof(Vertex, second)));
+	}
+}
+
+
+} // namespace b2draw
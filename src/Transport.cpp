@@ -0,0 +1,488 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "b2draw/Transport.h"
+
+
+namespace b2draw {
+namespace {
+
+
+constexpr std::uint32_t ringMagic = 0x52443242u; // "B2DR"
+constexpr std::uint32_t ringVersion = 1u;
+
+// The largest frame a socket subscriber will accept.
+constexpr std::uint64_t maxSocketRecordSize = std::uint64_t(1u) << 30;
+
+
+static_assert(
+	ATOMIC_LLONG_LOCK_FREE == 2,
+	"Shared-memory sequence numbers must be lock-free"
+);
+
+
+struct RingHeader
+{
+	std::uint32_t magic;
+	std::uint32_t version;
+	std::uint32_t slotCount;
+	std::uint32_t reserved;
+	std::uint64_t slotSize;
+
+	/** The number of frames published; frame n is in slot n % slotCount. */
+	std::atomic<std::uint64_t> framesPublished;
+};
+
+
+struct SlotHeader
+{
+	/** 2n + 1 while frame n is being written, and 2n + 2 once written. */
+	std::atomic<std::uint64_t> sequence;
+	std::uint64_t size;
+};
+
+
+static_assert(sizeof(RingHeader) % 8 == 0, "Slots must stay aligned");
+static_assert(sizeof(SlotHeader) % 8 == 0, "Records must stay aligned");
+
+
+inline std::size_t
+slotStride(std::size_t const slotSize) noexcept
+{
+	return sizeof(SlotHeader) + slotSize;
+}
+
+
+sockaddr_un
+socketAddress(std::string const& path)
+{
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(address.sun_path)) {
+		throw std::runtime_error{"Socket path too long: " + path};
+	}
+	std::memcpy(address.sun_path, path.c_str(), path.size());
+	return address;
+}
+
+
+bool
+sendAll(int const socket, char const* pData, std::size_t size) noexcept
+{
+	while (size > 0u)
+	{
+		auto const sent = ::send(socket, pData, size, MSG_NOSIGNAL);
+		if (sent < 0)
+		{
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		pData += sent;
+		size -= std::size_t(sent);
+	}
+	return true;
+}
+
+
+} // namespace
+
+
+SharedMemoryPublisher::SharedMemoryPublisher(
+	std::string const& name,
+	std::size_t const slotSize,
+	unsigned const slotCount,
+	bool const replace
+)
+	:	m_name{name}
+	,	m_pData{nullptr}
+	,	m_size{0u}
+	,	m_slotSize{(slotSize + 7u) & ~std::size_t(7u)}
+	,	m_slotCount{std::max(slotCount, 2u)}
+	,	m_framesPublished{0u}
+	,	m_framesDropped{0u}
+{
+	m_size = sizeof(RingHeader) + m_slotCount * slotStride(m_slotSize);
+
+	// Never share a segment: another publisher may still be writing to it.
+	// Replacing one unlinks it, leaving its readers with their mapping.
+	if (replace) {
+		::shm_unlink(name.c_str());
+	}
+	int const fd{::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644)};
+	if (fd < 0 && errno == EEXIST)
+	{
+		throw std::runtime_error{
+			"Shared memory " + name + " already exists; another publisher "
+			"may be using it, or pass replace to take it over"};
+	}
+	if (fd < 0) {
+		throw std::runtime_error{"Unable to create shared memory " + name};
+	}
+	if (::ftruncate(fd, off_t(m_size)) != 0)
+	{
+		::close(fd);
+		::shm_unlink(name.c_str());
+		throw std::runtime_error{"Unable to size shared memory " + name};
+	}
+
+	void* const pMapping{
+		::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)};
+	::close(fd);
+	if (pMapping == MAP_FAILED)
+	{
+		::shm_unlink(name.c_str());
+		throw std::runtime_error{"Unable to map shared memory " + name};
+	}
+	m_pData = static_cast<char*>(pMapping);
+
+	for (unsigned i = 0; i < m_slotCount; ++i)
+	{
+		auto const pSlot = new (m_pData + sizeof(RingHeader) +
+			i * slotStride(m_slotSize)) SlotHeader;
+		pSlot->sequence.store(0u, std::memory_order_relaxed);
+		pSlot->size = 0u;
+	}
+
+	// Readers check the magic number last, so write it last.
+	auto const pHeader = new (m_pData) RingHeader;
+	pHeader->version = ringVersion;
+	pHeader->slotCount = m_slotCount;
+	pHeader->reserved = 0u;
+	pHeader->slotSize = m_slotSize;
+	pHeader->framesPublished.store(0u, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	pHeader->magic = ringMagic;
+}
+
+
+SharedMemoryPublisher::~SharedMemoryPublisher() noexcept
+{
+	::munmap(m_pData, m_size);
+	::shm_unlink(m_name.c_str());
+}
+
+
+void
+SharedMemoryPublisher::write(FrameView const& frame)
+{
+	auto const size = frameRecordSize(frame);
+	if (size > m_slotSize)
+	{
+		++m_framesDropped;
+		return;
+	}
+
+	auto const frameNumber = m_framesPublished;
+	auto const pSlotData = m_pData + sizeof(RingHeader) +
+		(frameNumber % m_slotCount) * slotStride(m_slotSize);
+	auto const pSlot = reinterpret_cast<SlotHeader*>(pSlotData);
+
+	pSlot->sequence.store(2u * frameNumber + 1u, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	pSlot->size = size;
+	writeFrameRecord(frame, pSlotData + sizeof(SlotHeader));
+	pSlot->sequence.store(2u * frameNumber + 2u, std::memory_order_release);
+
+	++m_framesPublished;
+	reinterpret_cast<RingHeader*>(m_pData)->framesPublished.store(
+		m_framesPublished, std::memory_order_release);
+}
+
+
+SharedMemorySubscriber::SharedMemorySubscriber(std::string const& name)
+	:	m_pData{nullptr}
+	,	m_size{0u}
+	,	m_framesSeen{0u}
+	,	m_frameNumber{0u}
+{
+	int const fd{::shm_open(name.c_str(), O_RDONLY, 0)};
+	if (fd < 0) {
+		throw std::runtime_error{"Unable to open shared memory " + name};
+	}
+
+	struct stat status;
+	if (::fstat(fd, &status) != 0 || std::size_t(status.st_size) <
+		sizeof(RingHeader))
+	{
+		::close(fd);
+		throw std::runtime_error{"Invalid shared memory " + name};
+	}
+	m_size = status.st_size;
+
+	void* const pMapping{
+		::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0)};
+	::close(fd);
+	if (pMapping == MAP_FAILED) {
+		throw std::runtime_error{"Unable to map shared memory " + name};
+	}
+	m_pData = static_cast<char const*>(pMapping);
+
+	auto const pHeader = reinterpret_cast<RingHeader const*>(m_pData);
+	bool const valid{
+		pHeader->magic == ringMagic &&
+		pHeader->version == ringVersion &&
+		pHeader->slotCount > 0u &&
+		sizeof(RingHeader) + pHeader->slotCount *
+			slotStride(pHeader->slotSize) <= m_size
+	};
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (!valid)
+	{
+		::munmap(pMapping, m_size);
+		throw std::runtime_error{"Invalid shared memory " + name};
+	}
+}
+
+
+SharedMemorySubscriber::~SharedMemorySubscriber() noexcept
+{
+	::munmap(const_cast<char*>(m_pData), m_size);
+}
+
+
+char const*
+SharedMemorySubscriber::slot(std::uint64_t const frameNumber) const noexcept
+{
+	auto const pHeader = reinterpret_cast<RingHeader const*>(m_pData);
+	return m_pData + sizeof(RingHeader) +
+		(frameNumber % pHeader->slotCount) * slotStride(pHeader->slotSize);
+}
+
+
+bool
+SharedMemorySubscriber::poll(FrameView& frame)
+{
+	auto const pHeader = reinterpret_cast<RingHeader const*>(m_pData);
+	auto const framesPublished = pHeader->framesPublished.load(
+		std::memory_order_acquire);
+	if (framesPublished == m_framesSeen) {
+		return false;
+	}
+	m_framesSeen = framesPublished;
+
+	auto const frameNumber = framesPublished - 1u;
+	auto const pSlotData = slot(frameNumber);
+	auto const pSlot = reinterpret_cast<SlotHeader const*>(pSlotData);
+	if (
+		pSlot->sequence.load(std::memory_order_acquire) !=
+			2u * frameNumber + 2u
+	)
+	{
+		// Already being overwritten; a newer frame will be along shortly.
+		return false;
+	}
+
+	auto const size = std::min<std::uint64_t>(
+		pSlot->size, pHeader->slotSize);
+	m_frameNumber = frameNumber;
+	return readFrameRecord(pSlotData + sizeof(SlotHeader), size, frame) &&
+		intact();
+}
+
+
+bool
+SharedMemorySubscriber::intact() const noexcept
+{
+	if (m_framesSeen == 0u) {
+		return false;
+	}
+	auto const pSlot = reinterpret_cast<SlotHeader const*>(
+		slot(m_frameNumber));
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return pSlot->sequence.load(std::memory_order_relaxed) ==
+		2u * m_frameNumber + 2u;
+}
+
+
+SocketPublisher::SocketPublisher(
+	std::string const& path,
+	std::size_t const maxQueuedFrames
+)
+	:	AsyncFrameSink{maxQueuedFrames}
+	,	m_path{path}
+	,	m_listener{::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0)}
+	,	m_clients{}
+{
+	if (m_listener < 0) {
+		throw std::runtime_error{"Unable to create socket " + path};
+	}
+
+	auto const address = socketAddress(path);
+	::unlink(path.c_str());
+	if (
+		::bind(
+			m_listener,
+			reinterpret_cast<sockaddr const*>(&address),
+			sizeof(address)
+		) != 0 ||
+		::listen(m_listener, 8) != 0
+	)
+	{
+		::close(m_listener);
+		throw std::runtime_error{"Unable to listen on socket " + path};
+	}
+
+	start();
+}
+
+
+SocketPublisher::~SocketPublisher() noexcept
+{
+	stop();
+	for (int const client: m_clients) {
+		::close(client);
+	}
+	::close(m_listener);
+	::unlink(m_path.c_str());
+}
+
+
+bool
+SocketPublisher::consume(void const* const pRecord, std::size_t const size)
+{
+	int accepted;
+	while ((accepted = ::accept4(m_listener, nullptr, nullptr, 0)) >= 0)
+	{
+		// Don't let a stalled reader hold up the others indefinitely.
+		timeval const timeout{1, 0};
+		::setsockopt(
+			accepted, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+		m_clients.push_back(accepted);
+	}
+
+	std::uint64_t const recordSize{size};
+	auto const pBytes = static_cast<char const*>(pRecord);
+	m_clients.erase(
+		std::remove_if(
+			m_clients.begin(),
+			m_clients.end(),
+			[&](int const client) {
+				if (
+					sendAll(
+						client,
+						reinterpret_cast<char const*>(&recordSize),
+						sizeof(recordSize)
+					) &&
+					sendAll(client, pBytes, size)
+				)
+				{
+					return false;
+				}
+				::close(client);
+				return true;
+			}
+		),
+		m_clients.end()
+	);
+
+	// Readers coming and going isn't a failure of the publisher.
+	return true;
+}
+
+
+SocketSubscriber::SocketSubscriber(std::string const& path)
+	:	m_socket{::socket(AF_UNIX, SOCK_STREAM, 0)}
+	,	m_incoming{}
+	,	m_record{}
+{
+	if (m_socket < 0) {
+		throw std::runtime_error{"Unable to create socket " + path};
+	}
+
+	auto const address = socketAddress(path);
+	if (
+		::connect(
+			m_socket,
+			reinterpret_cast<sockaddr const*>(&address),
+			sizeof(address)
+		) != 0
+	)
+	{
+		::close(m_socket);
+		throw std::runtime_error{"Unable to connect to socket " + path};
+	}
+}
+
+
+SocketSubscriber::~SocketSubscriber() noexcept
+{
+	if (m_socket >= 0) {
+		::close(m_socket);
+	}
+}
+
+
+bool
+SocketSubscriber::poll(FrameView& frame)
+{
+	constexpr std::size_t chunkSize{1u << 16};
+	while (m_socket >= 0)
+	{
+		auto const offset = m_incoming.size();
+		m_incoming.resize(offset + chunkSize);
+		auto const received = ::recv(
+			m_socket, m_incoming.data() + offset, chunkSize, MSG_DONTWAIT);
+		m_incoming.resize(offset + std::max<ssize_t>(received, 0));
+
+		if (received == 0 || (received < 0 && errno != EAGAIN &&
+			errno != EWOULDBLOCK && errno != EINTR))
+		{
+			::close(m_socket);
+			m_socket = -1;
+		}
+		else if (received < 0 && errno != EINTR) {
+			break;
+		}
+	}
+
+	// Find the last complete record.
+	std::size_t offset{0u};
+	std::size_t newest{0u};
+	std::uint64_t newestSize{0u};
+	while (m_incoming.size() - offset >= sizeof(std::uint64_t))
+	{
+		std::uint64_t size;
+		std::memcpy(&size, m_incoming.data() + offset, sizeof(size));
+		if (size > maxSocketRecordSize || size % sizeof(std::uint64_t)) {
+			throw std::runtime_error{"Corrupt frame from socket"};
+		}
+		if (m_incoming.size() - offset - sizeof(size) < size) {
+			break;
+		}
+		newest = offset + sizeof(size);
+		newestSize = size;
+		offset = newest + size;
+	}
+	if (newestSize == 0u)
+	{
+		m_incoming.erase(m_incoming.begin(), m_incoming.begin() + offset);
+		return false;
+	}
+
+	// Copy out for alignment, and so that the frame outlives later reads.
+	m_record.resize(newestSize / sizeof(std::uint64_t));
+	std::memcpy(m_record.data(), m_incoming.data() + newest, newestSize);
+	m_incoming.erase(m_incoming.begin(), m_incoming.begin() + offset);
+
+	if (!readFrameRecord(m_record.data(), newestSize, frame)) {
+		throw std::runtime_error{"Corrupt frame from socket"};
+	}
+	return true;
+}
+
+
+} // namespace b2draw
@@ -0,0 +1,179 @@
+#include <algorithm>
+
+#include "b2draw/WorkerPool.h"
+
+
+namespace b2draw {
+
+
+WorkerPool::WorkerPool(unsigned const maxThreads)
+	:	m_maxThreads{maxThreads ?
+			maxThreads : std::max(std::thread::hardware_concurrency(), 1u) - 1u}
+	,	m_threads{}
+	,	m_jobMutex{}
+	,	m_mutex{}
+	,	m_start{}
+	,	m_done{}
+	,	m_generation{0u}
+	,	m_stopping{false}
+	,	m_task{nullptr}
+	,	m_pFunction{nullptr}
+	,	m_itemCount{0u}
+	,	m_sliceSize{0u}
+	,	m_sliceCount{0u}
+	,	m_nextSlice{0u}
+	,	m_helpers{0u}
+	,	m_pending{0u}
+	,	m_pError{}
+{
+}
+
+
+WorkerPool::~WorkerPool() noexcept
+{
+	{
+		std::lock_guard<std::mutex> const lock{m_mutex};
+		m_stopping = true;
+	}
+	m_start.notify_all();
+	for (auto& thread: m_threads)
+	{
+		thread.join();
+	}
+}
+
+
+WorkerPool&
+WorkerPool::shared() noexcept
+{
+	static WorkerPool pool;
+	return pool;
+}
+
+
+std::size_t
+WorkerPool::threadCount() const
+{
+	std::lock_guard<std::mutex> const lock{m_mutex};
+	return m_threads.size();
+}
+
+
+void
+WorkerPool::run(
+	std::size_t const itemCount,
+	std::size_t const workers,
+	Task const task,
+	void const* const pFunction
+)
+{
+	auto const slices = std::max<std::size_t>(workers, 1u);
+	std::size_t const sliceSize{(itemCount + slices - 1) / slices};
+	if (slices == 1u)
+	{
+		task(pFunction, 0u, itemCount, 0u);
+		return;
+	}
+
+	std::lock_guard<std::mutex> const job{m_jobMutex};
+	{
+		std::lock_guard<std::mutex> const lock{m_mutex};
+		grow(slices - 1u);
+		m_task = task;
+		m_pFunction = pFunction;
+		m_itemCount = itemCount;
+		m_sliceSize = sliceSize;
+		m_sliceCount = slices;
+		m_nextSlice.store(0u, std::memory_order_relaxed);
+		m_helpers = std::min(m_threads.size(), slices - 1u);
+		m_pending = m_helpers;
+		m_pError = nullptr;
+		++m_generation;
+	}
+	m_start.notify_all();
+
+	// If no threads could be started, the caller runs every slice.
+	work();
+	std::unique_lock<std::mutex> lock{m_mutex};
+	m_done.wait(lock, [this]() { return m_pending == 0u; });
+	if (m_pError) {
+		std::rethrow_exception(m_pError);
+	}
+}
+
+
+void
+WorkerPool::grow(std::size_t const count) noexcept
+{
+	auto const target = std::min(count, m_maxThreads);
+	try
+	{
+		m_threads.reserve(target);
+		while (m_threads.size() < target)
+		{
+			// New threads wait for the next job, not the last.
+			m_threads.emplace_back(
+				&WorkerPool::loop, this, m_threads.size(), m_generation);
+		}
+	}
+	catch (...)
+	{
+		// Run with the threads there are.
+	}
+}
+
+
+void
+WorkerPool::work() noexcept
+{
+	std::size_t slice;
+	while (
+		(slice = m_nextSlice.fetch_add(1u, std::memory_order_relaxed)) <
+			m_sliceCount
+	)
+	{
+		auto const begin = std::min(slice * m_sliceSize, m_itemCount);
+		auto const end = std::min(begin + m_sliceSize, m_itemCount);
+		try
+		{
+			m_task(m_pFunction, begin, end, slice);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> const lock{m_mutex};
+			if (!m_pError) {
+				m_pError = std::current_exception();
+			}
+		}
+	}
+}
+
+
+void
+WorkerPool::loop(std::size_t const index, std::uint64_t generation) noexcept
+{
+	std::unique_lock<std::mutex> lock{m_mutex};
+	while (true)
+	{
+		m_start.wait(lock, [this, generation]() {
+			return m_stopping || m_generation != generation;
+		});
+		if (m_stopping) {
+			return;
+		}
+		generation = m_generation;
+		if (index >= m_helpers) {
+			continue;
+		}
+
+		lock.unlock();
+		work();
+		lock.lock();
+		if (--m_pending == 0u) {
+			m_done.notify_one();
+		}
+	}
+}
+
+
+} // namespace b2draw
@@ -0,0 +1,227 @@
+// Round-trips frames through records and capture files, with and without
+// the capture file's footer.
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "b2draw/Capture.h"
+
+
+namespace {
+
+
+constexpr std::size_t frameCount{12u};
+
+/** A capture file's header: magic, version and a reserved word. */
+constexpr std::size_t headerSize{2u * 4u + 8u};
+
+
+unsigned failures{0u};
+
+
+void
+check(bool const condition, std::string const& what)
+{
+	if (!condition)
+	{
+		std::cerr << "FAILED: " << what << std::endl;
+		++failures;
+	}
+}
+
+
+/** The renderers a frame is viewed from, kept alive alongside it. */
+struct Renderers
+{
+	b2draw::PrimitiveRenderer lines{};
+	b2draw::PrimitiveRenderer fills{};
+	b2draw::PrimitiveRenderer segments{};
+};
+
+
+/** Draw frame @p index, varying in size, and view it. */
+b2draw::FrameView
+drawFrame(Renderers& renderers, std::size_t const index)
+{
+	renderers.lines.clear();
+	renderers.fills.clear();
+	renderers.segments.clear();
+	for (std::size_t i = 0; i < 3u + index % 4u; ++i)
+	{
+		b2Vec2 const centre{float32(i), float32(index)};
+		b2Color const colour{0.1f * float32(i), 0.5f, 0.9f};
+		renderers.lines.addCircle(centre, 0.5f, colour);
+		renderers.fills.addCircle(centre, 0.5f, colour);
+		renderers.segments.addSegment(
+			centre, centre + b2Vec2{0.5f, 0.0f}, colour);
+	}
+
+	b2draw::FrameView frame;
+	frame.flags = b2Draw::e_shapeBit | uint32(index);
+	frame.sectionCount = index % 5u == 0u ? 2u : 3u;
+	frame.sections[0] = {GL_LINE_LOOP, renderers.lines.view()};
+	frame.sections[1] = {GL_TRIANGLE_FAN, renderers.fills.view()};
+	frame.sections[2] = {GL_LINE_STRIP, renderers.segments.view()};
+	return frame;
+}
+
+
+/** Compare two frames exactly, as records store them as-is. */
+void
+compare(
+	b2draw::FrameView const& actual,
+	b2draw::FrameView const& expected,
+	std::string const& name
+)
+{
+	check(actual.flags == expected.flags, name + ": flags");
+	if (actual.sectionCount != expected.sectionCount)
+	{
+		check(false, name + ": section count");
+		return;
+	}
+
+	for (std::size_t i = 0; i < actual.sectionCount; ++i)
+	{
+		auto const& a = actual.sections[i];
+		auto const& e = expected.sections[i];
+		std::string const where{name + ", section " + std::to_string(i)};
+		check(a.mode == e.mode, where + ": mode");
+		if (
+			a.primitives.vertexCount != e.primitives.vertexCount ||
+			a.primitives.polygonCount != e.primitives.polygonCount
+		)
+		{
+			check(false, where + ": counts");
+			continue;
+		}
+
+		bool same{true};
+		for (std::size_t j = 0; j < a.primitives.vertexCount; ++j)
+		{
+			auto const& va = a.primitives.pVertices[j];
+			auto const& ve = e.primitives.pVertices[j];
+			same = same &&
+				va.first.x == ve.first.x && va.first.y == ve.first.y &&
+				va.second.r == ve.second.r && va.second.g == ve.second.g &&
+				va.second.b == ve.second.b && va.second.a == ve.second.a;
+		}
+		for (std::size_t j = 0; j < a.primitives.polygonCount; ++j)
+		{
+			same = same &&
+				a.primitives.pFirstIndices[j] ==
+					e.primitives.pFirstIndices[j] &&
+				a.primitives.pPolygonSizes[j] == e.primitives.pPolygonSizes[j];
+		}
+		check(same, where + ": primitives");
+	}
+}
+
+
+/** Serialise and view frames in memory. */
+void
+checkRecords()
+{
+	Renderers renderers;
+	for (std::size_t i = 0; i < frameCount; ++i)
+	{
+		std::string const name{"record " + std::to_string(i)};
+		auto const frame = drawFrame(renderers, i);
+		auto const size = b2draw::frameRecordSize(frame);
+		check(size % 8u == 0u, name + ": size aligned");
+
+		// Words, so that the record is 8-byte aligned.
+		std::vector<std::uint64_t> record(size / 8u + 1u);
+		b2draw::writeFrameRecord(frame, record.data());
+
+		b2draw::FrameView read;
+		check(
+			b2draw::readFrameRecord(record.data(), size, read),
+			name + ": read");
+		compare(read, frame, name);
+		check(
+			!b2draw::readFrameRecord(record.data(), size - 8u, read),
+			name + ": truncated record rejected");
+	}
+
+	std::vector<std::uint64_t> const garbage(64u, 0x0123456789abcdefu);
+	b2draw::FrameView read;
+	check(
+		!b2draw::readFrameRecord(garbage.data(), 8u * garbage.size(), read),
+		"garbage rejected");
+}
+
+
+/** Check that a capture file holds the first @p count frames. */
+void
+checkCapture(
+	std::string const& path,
+	std::size_t const count,
+	std::string const& name
+)
+{
+	b2draw::CaptureReader reader{path};
+	check(reader.frameCount() == count, name + ": frame count");
+	Renderers renderers;
+	for (std::size_t i = 0; i < count && i < reader.frameCount(); ++i)
+	{
+		compare(
+			reader.frame(i),
+			drawFrame(renderers, i),
+			name + ", frame " + std::to_string(i));
+	}
+}
+
+
+} // namespace
+
+
+int
+main(int argc, char** argv)
+{
+	if (argc != 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " <capture path>" << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::string const path{argv[1]};
+
+	checkRecords();
+
+	// Queue every frame, so none are dropped.
+	std::size_t recordBytes{0u};
+	{
+		b2draw::CaptureWriter writer{path, frameCount};
+		Renderers renderers;
+		for (std::size_t i = 0; i < frameCount; ++i)
+		{
+			auto const frame = drawFrame(renderers, i);
+			recordBytes += b2draw::frameRecordSize(frame);
+			writer.write(frame);
+		}
+		writer.close();
+		check(writer.framesDropped() == 0u, "no frames dropped");
+	}
+	checkCapture(path, frameCount, "with footer");
+
+	// Without the footer's frame table, as if recording crashed, the frames
+	// are found by scanning.
+	auto const framesEnd = off_t(headerSize + recordBytes);
+	check(::truncate(path.c_str(), framesEnd) == 0, "footer removed");
+	checkCapture(path, frameCount, "without footer");
+
+	// A last record cut short is left out.
+	check(::truncate(path.c_str(), framesEnd - 8) == 0, "last record cut");
+	checkCapture(path, frameCount - 1u, "cut short");
+
+	if (failures)
+	{
+		std::cerr << failures << " check(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,165 @@
+// Checks that chained segments coalesce into polylines, and only those.
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "b2draw/PrimitiveRenderer.h"
+
+
+namespace {
+
+
+b2Color const red{1.0f, 0.0f, 0.0f};
+b2Color const green{0.0f, 1.0f, 0.0f};
+
+
+unsigned failures{0u};
+
+
+void
+check(bool const condition, std::string const& what)
+{
+	if (!condition)
+	{
+		std::cerr << "FAILED: " << what << std::endl;
+		++failures;
+	}
+}
+
+
+/** Add a chain of segments through consecutive points. */
+void
+addChain(
+	b2draw::PrimitiveRenderer& renderer,
+	std::vector<b2Vec2> const& points,
+	b2Color const& colour
+)
+{
+	for (std::size_t i = 0; i + 1 < points.size(); ++i)
+	{
+		renderer.addSegment(points[i], points[i + 1], colour);
+	}
+}
+
+
+/** Each primitive's vertex count, in order. */
+std::vector<GLsizei>
+sizesOf(b2draw::PrimitiveRenderer const& renderer)
+{
+	auto const view = renderer.view();
+	return std::vector<GLsizei>(
+		view.pPolygonSizes, view.pPolygonSizes + view.polygonCount);
+}
+
+
+/** Whether each primitive's vertices follow on from the last's. */
+bool
+contiguous(b2draw::PrimitiveRenderer const& renderer)
+{
+	auto const view = renderer.view();
+	GLint next{0};
+	for (std::size_t i = 0; i < view.polygonCount; ++i)
+	{
+		if (view.pFirstIndices[i] != next) {
+			return false;
+		}
+		next += view.pPolygonSizes[i];
+	}
+	return std::size_t(next) == view.vertexCount;
+}
+
+
+} // namespace
+
+
+int
+main()
+{
+	std::vector<b2Vec2> const chain{
+		{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {2.0f, 1.0f}, {2.0f, 3.0f}};
+
+	// A chain becomes one polyline, vertex for vertex.
+	{
+		b2draw::PrimitiveRenderer renderer;
+		renderer.setSegmentCoalescing(true);
+		addChain(renderer, chain, red);
+		check(
+			sizesOf(renderer) == std::vector<GLsizei>{5},
+			"chain: one polyline");
+		auto const view = renderer.view();
+		bool same{view.vertexCount == chain.size()};
+		for (std::size_t i = 0; same && i < chain.size(); ++i)
+		{
+			same = view.pVertices[i].first.x == chain[i].x &&
+				view.pVertices[i].first.y == chain[i].y;
+		}
+		check(same, "chain: vertices in order");
+	}
+
+	// Without coalescing, each segment stands alone.
+	{
+		b2draw::PrimitiveRenderer renderer;
+		addChain(renderer, chain, red);
+		check(
+			sizesOf(renderer) == std::vector<GLsizei>(4u, 2),
+			"disabled: separate segments");
+	}
+
+	// A change of colour, a gap or a new group starts a new polyline.
+	{
+		b2draw::PrimitiveRenderer renderer;
+		renderer.setSegmentCoalescing(true);
+		renderer.addSegment({0.0f, 0.0f}, {1.0f, 0.0f}, red);
+		renderer.addSegment({1.0f, 0.0f}, {2.0f, 0.0f}, red);
+		renderer.addSegment({2.0f, 0.0f}, {3.0f, 0.0f}, green);
+		renderer.addSegment({3.5f, 0.0f}, {4.0f, 0.0f}, green);
+		renderer.addSegment({4.0f, 0.0f}, {5.0f, 0.0f}, green);
+		renderer.beginGroup(b2Vec2{10.0f, 0.0f});
+		renderer.addSegment({5.0f, 0.0f}, {6.0f, 0.0f}, green);
+		renderer.addSegment({6.0f, 0.0f}, {7.0f, 0.0f}, green);
+		check(
+			sizesOf(renderer) == std::vector<GLsizei>({3, 2, 3, 3}),
+			"breaks: polylines split");
+		check(contiguous(renderer), "breaks: ranges contiguous");
+	}
+
+	// Segments tagged differently stay apart, to be picked apart.
+	{
+		int fixtures[2];
+		b2draw::PrimitiveRenderer renderer;
+		renderer.setSegmentCoalescing(true);
+		renderer.setTagging(true);
+		renderer.setTag(&fixtures[0]);
+		renderer.addSegment({0.0f, 0.0f}, {1.0f, 0.0f}, red);
+		renderer.addSegment({1.0f, 0.0f}, {2.0f, 0.0f}, red);
+		renderer.setTag(&fixtures[1]);
+		renderer.addSegment({2.0f, 0.0f}, {3.0f, 0.0f}, red);
+		check(
+			sizesOf(renderer) == std::vector<GLsizei>({3, 2}),
+			"tags: polylines split");
+		check(
+			renderer.tag(0u) == &fixtures[0] &&
+				renderer.tag(1u) == &fixtures[1],
+			"tags: kept per polyline");
+	}
+
+	// After a clear, nothing is continued from the last frame.
+	{
+		b2draw::PrimitiveRenderer renderer;
+		renderer.setSegmentCoalescing(true);
+		renderer.addSegment({0.0f, 0.0f}, {1.0f, 0.0f}, red);
+		renderer.clear();
+		renderer.addSegment({1.0f, 0.0f}, {2.0f, 0.0f}, red);
+		check(
+			sizesOf(renderer) == std::vector<GLsizei>{2},
+			"cleared: a fresh segment");
+	}
+
+	if (failures)
+	{
+		std::cerr << failures << " check(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,329 @@
+// Round-trips synthetic frames through a delta stream.
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "b2draw/DeltaStream.h"
+
+
+namespace {
+
+
+constexpr float quantum{b2draw::DeltaStreamWriter::s_defaultQuantum};
+constexpr unsigned keyframeInterval{4u};
+
+
+/** A section whose storage the test owns. */
+struct Section
+{
+	GLenum mode;
+
+	/** Each primitive's vertices. */
+	std::vector<std::vector<b2draw::Vertex>> primitives;
+};
+
+
+struct Frame
+{
+	uint32 flags;
+	std::vector<Section> sections;
+};
+
+
+/** Flattened storage for viewing a Frame. */
+struct Storage
+{
+	std::vector<b2draw::Vertex> vertices;
+	std::vector<GLint> firstIndices;
+	std::vector<GLsizei> polygonSizes;
+};
+
+
+unsigned failures{0u};
+
+
+void
+check(bool const condition, std::string const& what)
+{
+	if (!condition)
+	{
+		std::cerr << "FAILED: " << what << std::endl;
+		++failures;
+	}
+}
+
+
+b2draw::FrameView
+view(Frame const& frame, std::vector<Storage>& storage)
+{
+	b2draw::FrameView result;
+	result.flags = frame.flags;
+	result.sectionCount = frame.sections.size();
+	storage.resize(frame.sections.size());
+	for (std::size_t i = 0; i < frame.sections.size(); ++i)
+	{
+		auto& store = storage[i];
+		store.vertices.clear();
+		store.firstIndices.clear();
+		store.polygonSizes.clear();
+		for (auto const& primitive: frame.sections[i].primitives)
+		{
+			store.firstIndices.push_back(GLint(store.vertices.size()));
+			store.polygonSizes.push_back(GLsizei(primitive.size()));
+			store.vertices.insert(
+				store.vertices.end(), primitive.begin(), primitive.end());
+		}
+		result.sections[i] = {
+			frame.sections[i].mode,
+			b2draw::PrimitiveView{
+				store.vertices.data(),
+				store.vertices.size(),
+				store.firstIndices.data(),
+				store.polygonSizes.data(),
+				store.polygonSizes.size()
+			}
+		};
+	}
+	return result;
+}
+
+
+std::vector<b2draw::Vertex>
+randomPrimitive(std::mt19937& random)
+{
+	std::uniform_real_distribution<float> position{-100.0f, 100.0f};
+	std::uniform_real_distribution<float> channel{0.0f, 1.0f};
+	std::uniform_int_distribution<int> size{1, 9};
+	b2Color const colour{channel(random), channel(random), channel(random)};
+	b2Vec2 const centre{position(random), position(random)};
+	std::vector<b2draw::Vertex> primitive(size(random));
+	for (auto& vertex: primitive)
+	{
+		vertex.first = centre + b2Vec2{
+			0.01f * position(random), 0.01f * position(random)};
+		vertex.second = colour;
+	}
+	return primitive;
+}
+
+
+void
+move(
+	Section& section,
+	std::size_t begin,
+	std::size_t end,
+	std::mt19937& random
+)
+{
+	std::uniform_real_distribution<float> step{-0.5f, 0.5f};
+	for (std::size_t i = begin; i < end && i < section.primitives.size(); ++i)
+	{
+		b2Vec2 const offset{step(random), step(random)};
+		for (auto& vertex: section.primitives[i])
+		{
+			vertex.first += offset;
+		}
+	}
+}
+
+
+void
+insert(
+	Section& section,
+	std::size_t at,
+	std::size_t count,
+	std::mt19937& random
+)
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		section.primitives.insert(
+			section.primitives.begin() + at + i, randomPrimitive(random));
+	}
+}
+
+
+void
+erase(Section& section, std::size_t begin, std::size_t end)
+{
+	section.primitives.erase(
+		section.primitives.begin() + begin, section.primitives.begin() + end);
+}
+
+
+/** Compare a decoded frame to what was written, within quantisation. */
+void
+compare(
+	b2draw::FrameView const& decoded,
+	Frame const& expected,
+	std::string const& name
+)
+{
+	check(decoded.flags == expected.flags, name + ": flags");
+	if (decoded.sectionCount != expected.sections.size())
+	{
+		check(false, name + ": section count");
+		return;
+	}
+
+	float const positionTolerance{0.5f * quantum + 1.0e-5f};
+	float const colourTolerance{0.5f / 255.0f + 1.0e-6f};
+	for (std::size_t i = 0; i < decoded.sectionCount; ++i)
+	{
+		auto const& section = decoded.sections[i];
+		auto const& primitives = expected.sections[i].primitives;
+		std::string const where{name + ", section " + std::to_string(i)};
+		check(section.mode == expected.sections[i].mode, where + ": mode");
+		if (section.primitives.polygonCount != primitives.size())
+		{
+			check(false, where + ": primitive count");
+			continue;
+		}
+
+		bool sizes{true};
+		bool positions{true};
+		bool colours{true};
+		for (std::size_t j = 0; j < primitives.size(); ++j)
+		{
+			auto const size = std::size_t(
+				section.primitives.pPolygonSizes[j]);
+			if (size != primitives[j].size())
+			{
+				sizes = false;
+				continue;
+			}
+
+			auto const pVertices = section.primitives.pVertices +
+				section.primitives.pFirstIndices[j];
+			for (std::size_t k = 0; k < size; ++k)
+			{
+				auto const& actual = pVertices[k];
+				auto const& wanted = primitives[j][k];
+				positions = positions &&
+					std::abs(actual.first.x - wanted.first.x) <=
+						positionTolerance &&
+					std::abs(actual.first.y - wanted.first.y) <=
+						positionTolerance;
+				colours = colours &&
+					std::abs(actual.second.r - wanted.second.r) <=
+						colourTolerance &&
+					std::abs(actual.second.g - wanted.second.g) <=
+						colourTolerance &&
+					std::abs(actual.second.b - wanted.second.b) <=
+						colourTolerance &&
+					std::abs(actual.second.a - wanted.second.a) <=
+						colourTolerance;
+			}
+		}
+		check(sizes, where + ": primitive sizes");
+		check(positions, where + ": positions");
+		check(colours, where + ": colours");
+	}
+}
+
+
+/** Build a run of frames exercising each kind of change. */
+std::vector<Frame>
+makeFrames()
+{
+	std::mt19937 random{1234u};
+	Frame frame{b2Draw::e_shapeBit | b2Draw::e_jointBit, {}};
+	frame.sections.push_back(Section{GL_LINE_LOOP, {}});
+	frame.sections.push_back(Section{GL_TRIANGLE_FAN, {}});
+	insert(frame.sections[0], 0u, 50u, random);
+	insert(frame.sections[1], 0u, 20u, random);
+
+	std::vector<Frame> frames;
+	frames.push_back(frame); // 0: the first keyframe.
+
+	move(frame.sections[0], 10u, 30u, random);
+	frames.push_back(frame); // 1: some primitives moved.
+
+	insert(frame.sections[0], 20u, 5u, random);
+	insert(frame.sections[1], 20u, 3u, random);
+	frames.push_back(frame); // 2: primitives added.
+
+	erase(frame.sections[0], 0u, 5u);
+	erase(frame.sections[0], 40u, 45u);
+	frames.push_back(frame); // 3: primitives removed.
+
+	frames.push_back(frame); // 4: a keyframe, unchanged.
+
+	// Keep everything moving, adding and removing as it goes.
+	for (unsigned i = 5u; i < 14u; ++i)
+	{
+		move(frame.sections[0], 0u, 60u, random);
+		move(frame.sections[1], 0u, 30u, random);
+		if (i % 3u == 0u) {
+			insert(frame.sections[0], i, 2u, random);
+		}
+		if (i % 3u == 1u) {
+			erase(frame.sections[1], i, i + 1u);
+		}
+		frame.flags ^= b2Draw::e_aabbBit;
+		frames.push_back(frame);
+	}
+	return frames;
+}
+
+
+} // namespace
+
+
+int
+main(int argc, char** argv)
+{
+	if (argc != 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " <stream path>" << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::string const path{argv[1]};
+
+	auto const frames = makeFrames();
+	{
+		b2draw::DeltaStreamWriter writer{
+			path, quantum, keyframeInterval, frames.size()};
+		std::vector<Storage> storage;
+		for (auto const& frame: frames)
+		{
+			writer.write(view(frame, storage));
+		}
+		writer.close();
+		check(writer.framesDropped() == 0u, "no frames dropped");
+	}
+
+	b2draw::DeltaStreamReader reader{path};
+	check(reader.frameCount() == frames.size(), "frame count");
+	check(reader.quantum() == quantum, "quantum");
+	if (reader.frameCount() != frames.size())
+	{
+		std::cerr << failures << " check(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	for (std::size_t i = 0; i < frames.size(); ++i)
+	{
+		compare(reader.frame(i), frames[i], "frame " + std::to_string(i));
+	}
+
+	// Seek backwards and forwards, decoding from the nearest keyframe.
+	std::size_t const seeks[] = {11u, 2u, 13u, 0u, 6u, 6u, 12u, 3u, 8u};
+	for (auto const index: seeks)
+	{
+		compare(
+			reader.frame(index),
+			frames[index],
+			"seek to frame " + std::to_string(index));
+	}
+
+	if (failures)
+	{
+		std::cerr << failures << " check(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+// Checks FrameArena's rewinding and accounting, and that an arena shared by
+// two DebugDraws stays bounded.
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "b2draw/DebugDraw.h"
+#include "b2draw/FrameArena.h"
+
+
+namespace {
+
+
+constexpr std::size_t chunkSize{4096u};
+/** Long enough for every combination of the views' sizes to be drawn. */
+constexpr unsigned warmUpFrames{3u * 5u * 7u};
+constexpr unsigned frameCount{2000u};
+
+b2Color const bodyColour{0.9f, 0.7f, 0.7f};
+
+
+unsigned failures{0u};
+
+
+void
+check(bool const condition, std::string const& what)
+{
+	if (!condition)
+	{
+		std::cerr << "FAILED: " << what << std::endl;
+		++failures;
+	}
+}
+
+
+/** Draw @p count unit squares along the x axis. */
+void
+drawSquares(b2draw::DebugDraw& debugDraw, unsigned const count)
+{
+	for (unsigned i = 0; i < count; ++i)
+	{
+		float32 const x{float32(i)};
+		b2Vec2 const square[4] = {{x, 0.0f}, {x + 1.0f, 0.0f},
+			{x + 1.0f, 1.0f}, {x, 1.0f}};
+		debugDraw.DrawPolygon(square, 4, bodyColour);
+		debugDraw.DrawSolidPolygon(square, 4, bodyColour);
+	}
+}
+
+
+/** Allocate, free and rewind chunks directly. */
+void
+checkRewinding()
+{
+	b2draw::FrameArena arena{chunkSize};
+	check(arena.reservedBytes() == 0u, "nothing reserved until used");
+
+	auto const pFirst = arena.allocate(100u, 8u);
+	auto const pSecond = arena.allocate(200u, 64u);
+	check(
+		reinterpret_cast<std::uintptr_t>(pSecond) % 64u == 0u,
+		"allocations aligned");
+	check(arena.reservedBytes() == chunkSize, "one chunk reserved");
+	auto const used = arena.usedBytes();
+	check(used >= 300u && used < chunkSize, "both allocations used");
+	check(arena.peakBytes() == used, "peak follows use");
+
+	// Freeing only counts memory off; the chunk rewinds once it's empty.
+	arena.deallocate(pFirst, 100u, 8u);
+	check(arena.usedBytes() == used, "partly freed chunk still used");
+	arena.deallocate(pSecond, 200u, 64u);
+	check(arena.usedBytes() == 0u, "empty chunk rewound");
+	check(arena.peakBytes() == used, "peak kept after rewinding");
+	auto const pAgain = arena.allocate(100u, 8u);
+	check(pAgain == pFirst, "rewound chunk reused from its start");
+	check(arena.reservedBytes() == chunkSize, "no chunk added on reuse");
+	arena.resetPeak();
+	check(arena.peakBytes() == arena.usedBytes(), "peak reset to use");
+
+	// Larger requests get a chunk of their own, freed by trimming.
+	auto const pLarge = arena.allocate(4u * chunkSize, 8u);
+	check(arena.reservedBytes() > 5u * chunkSize, "large chunk reserved");
+	check(arena.peakBytes() > 4u * chunkSize, "peak includes large");
+	arena.deallocate(pLarge, 4u * chunkSize, 8u);
+	arena.trim();
+	check(arena.reservedBytes() == chunkSize, "trim frees the empty chunk");
+
+	// After a reset, the next allocation doesn't follow live memory.
+	arena.reset();
+	auto const pReset = arena.allocate(100u, 8u);
+	check(arena.reservedBytes() == 2u * chunkSize, "reset moved chunks");
+	arena.deallocate(pAgain, 100u, 8u);
+	arena.reset();
+	auto const pRewound = arena.allocate(100u, 8u);
+	check(pRewound == pFirst, "reset reuses an emptied chunk");
+	check(arena.reservedBytes() == 2u * chunkSize, "no chunk added");
+	arena.deallocate(pReset, 100u, 8u);
+	arena.deallocate(pRewound, 100u, 8u);
+	check(arena.usedBytes() == 0u, "all rewound");
+}
+
+
+} // namespace
+
+
+int
+main()
+{
+	checkRewinding();
+
+	b2draw::FrameArena arena{chunkSize};
+	auto const buffers = b2draw::PrimitiveRenderer::s_defaultBufferCount;
+	b2draw::DebugDraw mainView{16u, 0.5f, 4.0f, buffers, &arena};
+	b2draw::DebugDraw minimap{8u, 0.5f, 4.0f, buffers, &arena};
+
+	// Alternate the two views' frames, each growing its storage after the
+	// other has cleared, with sizes varying from frame to frame.
+	std::size_t bound{0u};
+	for (unsigned frame = 0; frame < frameCount; ++frame)
+	{
+		mainView.Clear();
+		drawSquares(mainView, 20u + 30u * (frame % 7u));
+		minimap.Clear();
+		drawSquares(minimap, 10u + 20u * (frame % 5u));
+		drawSquares(mainView, 5u + 10u * (frame % 3u));
+
+		if (frame + 1u == warmUpFrames) {
+			bound = arena.reservedBytes();
+		}
+		else if (frame >= warmUpFrames && arena.reservedBytes() > bound)
+		{
+			check(
+				false,
+				"frame " + std::to_string(frame) + ": reserved " +
+				std::to_string(arena.reservedBytes()) + " bytes, more than " +
+				std::to_string(bound) + " after warming up");
+			break;
+		}
+	}
+	check(arena.usedBytes() <= arena.reservedBytes(), "used within reserved");
+	check(arena.peakBytes() <= bound, "peak within the warmed-up reserve");
+
+	if (failures)
+	{
+		std::cerr << failures << " check(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
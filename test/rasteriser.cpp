@@ -0,0 +1,154 @@
+// Checks SoftwareRasteriser output at widths that aren't a multiple of four,
+// where the last pixels of each row fall in a partial group.
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "b2draw/SoftwareRasteriser.h"
+
+
+namespace {
+
+
+constexpr unsigned height{70u};
+
+b2Color const red{1.0f, 0.0f, 0.0f};
+b2Color const blue{0.0f, 0.0f, 1.0f};
+
+
+unsigned failures{0u};
+
+
+void
+check(bool const condition, std::string const& what)
+{
+	if (!condition)
+	{
+		std::cerr << "FAILED: " << what << std::endl;
+		++failures;
+	}
+}
+
+
+/** A pixel's bytes, in R, G, B, A order. */
+std::uint32_t
+rgba(unsigned const r, unsigned const g, unsigned const b, unsigned const a)
+{
+	std::uint32_t pixel;
+	unsigned char const bytes[4] = {
+		static_cast<unsigned char>(r),
+		static_cast<unsigned char>(g),
+		static_cast<unsigned char>(b),
+		static_cast<unsigned char>(a)
+	};
+	std::copy(bytes, bytes + 4, reinterpret_cast<unsigned char*>(&pixel));
+	return pixel;
+}
+
+
+/** Add a rectangle spanning the image's height, from @p left to @p right. */
+void
+addColumns(
+	b2draw::PrimitiveRenderer& renderer,
+	float32 const left,
+	float32 const right,
+	b2Color const& colour
+)
+{
+	b2Vec2 const corners[4] = {
+		{left, 0.0f},
+		{right, 0.0f},
+		{right, float32(height)},
+		{left, float32(height)}
+	};
+	renderer.addPolygon(corners, 4, colour);
+}
+
+
+/** Draw columns up to each edge of an image @p width pixels wide. */
+void
+checkWidth(unsigned const width, unsigned const threads)
+{
+	std::string const name{
+		"width " + std::to_string(width) + ", " + std::to_string(threads) +
+		" thread(s)"};
+	b2draw::SoftwareRasteriser rasteriser{width, height, threads};
+	check(rasteriser.stride() >= width, name + ": stride");
+
+	// One pixel per world unit, with pixel centres at half units.
+	rasteriser.setView(
+		b2Vec2{0.0f, 0.0f}, b2Vec2{float32(width), float32(height)});
+	rasteriser.clear();
+
+	// Red from the second column to the second last, then blue over the
+	// last column, right up to the image's edge.
+	b2draw::PrimitiveRenderer fills;
+	addColumns(fills, 1.0f, float32(width) - 1.0f, red);
+	addColumns(fills, float32(width) - 1.0f, float32(width), blue);
+	rasteriser.draw(GL_TRIANGLE_FAN, fills.view());
+
+	auto const none = rgba(0u, 0u, 0u, 0u);
+	unsigned wrong{0u};
+	for (unsigned y = 0; y < height; ++y)
+	{
+		for (unsigned x = 0; x < width; ++x)
+		{
+			auto const expected =
+				x + 1u == width ? rgba(0u, 0u, 255u, 255u)
+				: x >= 1u ? rgba(255u, 0u, 0u, 255u)
+				: none;
+			if (rasteriser.pixel(x, y) != expected) {
+				++wrong;
+			}
+		}
+	}
+	check(wrong == 0u, name + ": " + std::to_string(wrong) + " wrong pixels");
+
+	// A line down the last column is drawn to the edge too.
+	rasteriser.clear();
+	b2draw::PrimitiveRenderer lines;
+	float32 const x{float32(width) - 0.5f};
+	lines.addSegment(
+		b2Vec2{x, 0.5f}, b2Vec2{x, float32(height) - 0.5f}, red);
+	rasteriser.draw(GL_LINE_STRIP, lines.view());
+	unsigned drawn{0u};
+	unsigned stray{0u};
+	for (unsigned row = 0; row < height; ++row)
+	{
+		for (unsigned column = 0; column < width; ++column)
+		{
+			bool const lit{rasteriser.pixel(column, row) != none};
+			if (column + 1u == width) {
+				drawn += lit;
+			}
+			else {
+				stray += lit;
+			}
+		}
+	}
+	check(drawn >= height - 2u, name + ": last column line drawn");
+	check(stray == 0u, name + ": line kept to its column");
+}
+
+
+} // namespace
+
+
+int
+main()
+{
+	for (unsigned const width: {1u, 2u, 3u, 5u, 6u, 7u, 63u, 65u, 130u, 131u})
+	{
+		checkWidth(width, 1u);
+		checkWidth(width, 0u);
+	}
+
+	if (failures)
+	{
+		std::cerr << failures << " check(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+// Checks that refresh intervals leave a DebugDraw's flags as they were set.
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "b2draw/DebugDraw.h"
+
+
+namespace {
+
+
+constexpr unsigned aabbInterval{3u};
+
+/** The sections GetFrame puts main outlines and retained AABBs in. */
+constexpr std::size_t lineSection{0u};
+constexpr std::size_t aabbSection{5u};
+
+b2Color const aabbColour{0.9f, 0.3f, 0.9f};
+b2Color const bodyColour{0.9f, 0.7f, 0.7f};
+
+
+unsigned failures{0u};
+
+
+void
+check(bool const condition, std::string const& what)
+{
+	if (!condition)
+	{
+		std::cerr << "FAILED: " << what << std::endl;
+		++failures;
+	}
+}
+
+
+/** Draw as a world would with @p debugDraw's flags, then publish. */
+void
+drawAndPublish(b2draw::DebugDraw& debugDraw)
+{
+	b2Vec2 const square[4] = {{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f},
+		{0.0f, 1.0f}};
+	if (debugDraw.GetFlags() & b2Draw::e_shapeBit) {
+		debugDraw.DrawPolygon(square, 4, bodyColour);
+	}
+	if (debugDraw.GetFlags() & b2Draw::e_aabbBit) {
+		debugDraw.DrawPolygon(square, 4, aabbColour);
+	}
+	debugDraw.Publish();
+}
+
+
+/** Clear and draw a frame, checking Clear kept the flags. */
+void
+drawFrame(b2draw::DebugDraw& debugDraw, std::string const& name)
+{
+	auto const flags = debugDraw.GetFlags();
+	debugDraw.Clear();
+	check(debugDraw.GetFlags() == flags, name + ": flags kept by Clear");
+	drawAndPublish(debugDraw);
+}
+
+
+} // namespace
+
+
+int
+main()
+{
+	b2draw::DebugDraw debugDraw;
+	uint32 const flags{b2Draw::e_shapeBit | b2Draw::e_aabbBit};
+	debugDraw.SetFlags(flags);
+	debugDraw.SetRefreshInterval(b2Draw::e_aabbBit, aabbInterval);
+
+	// Frames between refreshes keep the flags, and the last AABBs.
+	for (unsigned i = 0; i < 2u * aabbInterval; ++i)
+	{
+		std::string const name{"frame " + std::to_string(i)};
+		drawFrame(debugDraw, name);
+		auto const frame = debugDraw.GetFrame();
+		check(frame.flags == flags, name + ": recorded flags");
+		check(
+			frame.sections[lineSection].primitives.polygonCount == 1u,
+			name + ": only the body outline in the main section");
+		check(
+			frame.sections[aabbSection].primitives.polygonCount == 1u,
+			name + ": the retained AABB");
+	}
+
+	// Turning a layer off between Clear and publishing isn't undone by the
+	// next Clear, whether or not the layer was due.
+	for (unsigned i = 0; i < aabbInterval; ++i)
+	{
+		std::string const name{"SetFlags at phase " + std::to_string(i)};
+		debugDraw.SetFlags(flags);
+		for (unsigned j = 0; j <= i; ++j)
+		{
+			drawFrame(debugDraw, name);
+		}
+		debugDraw.Clear();
+		debugDraw.SetFlags(b2Draw::e_shapeBit);
+		drawAndPublish(debugDraw);
+		drawFrame(debugDraw, name + ", next frame");
+		check(debugDraw.GetFlags() == b2Draw::e_shapeBit, name + ": flags");
+		auto const frame = debugDraw.GetFrame();
+		check(frame.flags == b2Draw::e_shapeBit, name + ": recorded flags");
+		check(
+			frame.sections[aabbSection].primitives.polygonCount == 0u,
+			name + ": no AABBs");
+	}
+
+	// Without an interval, AABBs are drawn with everything else.
+	debugDraw.SetFlags(flags);
+	debugDraw.SetRefreshInterval(b2Draw::e_aabbBit, 1u);
+	drawFrame(debugDraw, "no interval");
+	check(
+		debugDraw.GetFrame().sections[lineSection].primitives.polygonCount ==
+			2u,
+		"no interval: AABBs with the outlines");
+
+	if (failures)
+	{
+		std::cerr << failures << " check(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
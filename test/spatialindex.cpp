@@ -0,0 +1,167 @@
+// Checks SpatialIndex queries against a brute-force search.
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "b2draw/SpatialIndex.h"
+
+
+namespace {
+
+
+using Bounds = b2draw::SpatialIndex::Bounds;
+
+
+constexpr std::size_t sentinel{~std::size_t{0}};
+
+
+unsigned failures{0u};
+
+
+void
+check(bool const condition, std::string const& what)
+{
+	if (!condition)
+	{
+		std::cerr << "FAILED: " << what << std::endl;
+		++failures;
+	}
+}
+
+
+/** Mostly small boxes, with a few spanning much of the world. */
+std::vector<Bounds>
+randomBoxes(std::mt19937& random, std::size_t const count)
+{
+	std::uniform_real_distribution<float> position{-500.0f, 500.0f};
+	std::uniform_real_distribution<float> size{0.0f, 4.0f};
+	std::vector<Bounds> boxes;
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		b2Vec2 const lower{position(random), position(random)};
+		float32 const scale{i % 97u == 0u ? 100.0f : 1.0f};
+		boxes.push_back(Bounds{
+			lower,
+			lower + scale * b2Vec2{size(random), size(random)}});
+	}
+	return boxes;
+}
+
+
+std::vector<std::size_t>
+bruteForce(std::vector<Bounds> const& boxes, Bounds const& bounds)
+{
+	std::vector<std::size_t> indices;
+	for (std::size_t i = 0; i < boxes.size(); ++i)
+	{
+		auto const& box = boxes[i];
+		if (
+			box.lower.x <= bounds.upper.x &&
+			box.lower.y <= bounds.upper.y &&
+			box.upper.x >= bounds.lower.x &&
+			box.upper.y >= bounds.lower.y
+		)
+		{
+			indices.push_back(i);
+		}
+	}
+	return indices;
+}
+
+
+/** Query, checking results are appended, in order, once each. */
+void
+compare(
+	b2draw::SpatialIndex const& index,
+	std::vector<Bounds> const& boxes,
+	Bounds const& bounds,
+	std::string const& name
+)
+{
+	std::vector<std::size_t> indices{sentinel};
+	index.query(bounds, indices);
+	check(indices.front() == sentinel, name + ": appended");
+	indices.erase(indices.begin());
+	check(indices == bruteForce(boxes, bounds), name + ": boxes found");
+}
+
+
+} // namespace
+
+
+int
+main()
+{
+	std::mt19937 random{4321u};
+	std::uniform_real_distribution<float> position{-600.0f, 600.0f};
+	std::uniform_real_distribution<float> size{0.0f, 50.0f};
+
+	b2draw::SpatialIndex index;
+	std::vector<std::size_t> none;
+	index.query(Bounds{{-1.0f, -1.0f}, {1.0f, 1.0f}}, none);
+	check(none.empty(), "empty index: nothing found");
+
+	// Rebuild at several sizes, reusing the index.
+	for (std::size_t const count: {1000u, 10u, 1u, 5000u})
+	{
+		auto const boxes = randomBoxes(random, count);
+		index.build(boxes.data(), boxes.size());
+		std::string const name{std::to_string(count) + " boxes"};
+		check(index.size() == count, name + ": size");
+		check(index.cellCount() <= 4u * count, name + ": cells bounded");
+
+		for (unsigned i = 0; i < 200u; ++i)
+		{
+			b2Vec2 const lower{position(random), position(random)};
+			compare(
+				index,
+				boxes,
+				Bounds{lower, lower + b2Vec2{size(random), size(random)}},
+				name + ", query " + std::to_string(i));
+		}
+
+		// Everything, a point on a box's corner, and nothing at all.
+		compare(
+			index, boxes, Bounds{{-1.0e4f, -1.0e4f}, {1.0e4f, 1.0e4f}},
+			name + ", everything");
+		compare(
+			index, boxes, Bounds{boxes[0].upper, boxes[0].upper},
+			name + ", corner");
+		compare(
+			index, boxes, Bounds{{2000.0f, 2000.0f}, {2001.0f, 2001.0f}},
+			name + ", outside");
+	}
+
+	// Boxes with non-finite corners are never found.
+	float32 const nan{std::numeric_limits<float32>::quiet_NaN()};
+	float32 const infinity{std::numeric_limits<float32>::infinity()};
+	std::vector<Bounds> const boxes{
+		Bounds{{0.0f, 0.0f}, {1.0f, 1.0f}},
+		Bounds{{nan, 0.0f}, {1.0f, 1.0f}},
+		Bounds{{0.0f, 0.0f}, {infinity, 1.0f}},
+		Bounds{{2.0f, 2.0f}, {3.0f, 3.0f}}
+	};
+	index.build(boxes.data(), boxes.size());
+	std::vector<std::size_t> found;
+	index.query(Bounds{{-10.0f, -10.0f}, {10.0f, 10.0f}}, found);
+	check(
+		found == std::vector<std::size_t>{0u, 3u},
+		"non-finite boxes skipped");
+
+	index.clear();
+	check(index.size() == 0u && index.cellCount() == 0u, "cleared");
+	found.clear();
+	index.query(Bounds{{-10.0f, -10.0f}, {10.0f, 10.0f}}, found);
+	check(found.empty(), "cleared: nothing found");
+
+	if (failures)
+	{
+		std::cerr << failures << " check(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
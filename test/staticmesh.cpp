@@ -0,0 +1,203 @@
+// Checks StaticMesh welding and internal edge dropping.
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "b2draw/StaticMesh.h"
+
+
+namespace {
+
+
+b2Color const lineColour{0.5f, 0.9f, 0.5f};
+b2Color const fillColour{0.5f, 0.9f, 0.5f, 0.5f};
+b2Color const otherColour{0.9f, 0.7f, 0.7f};
+
+
+unsigned failures{0u};
+
+
+void
+check(bool const condition, std::string const& what)
+{
+	if (!condition)
+	{
+		std::cerr << "FAILED: " << what << std::endl;
+		++failures;
+	}
+}
+
+
+/** Add a unit square with its lower left corner at @p corner. */
+void
+addSquare(
+	b2draw::PrimitiveRenderer& renderer,
+	b2Vec2 const& corner,
+	b2Color const& colour
+)
+{
+	b2Vec2 const square[4] = {
+		corner,
+		corner + b2Vec2{1.0f, 0.0f},
+		corner + b2Vec2{1.0f, 1.0f},
+		corner + b2Vec2{0.0f, 1.0f}
+	};
+	renderer.addPolygon(square, 4, colour);
+}
+
+
+b2draw::FrameView
+frameOf(
+	b2draw::PrimitiveRenderer const& lines,
+	b2draw::PrimitiveRenderer const& fills
+)
+{
+	b2draw::FrameView frame;
+	frame.flags = b2Draw::e_shapeBit;
+	frame.sectionCount = 2u;
+	frame.sections[0] = b2draw::FrameSection{GL_LINE_LOOP, lines.view()};
+	frame.sections[1] = b2draw::FrameSection{GL_TRIANGLE_FAN, fills.view()};
+	return frame;
+}
+
+
+/** The line edges of a mesh, lowest index first and sorted. */
+std::vector<std::pair<GLuint, GLuint>>
+edgesOf(b2draw::StaticMesh::Geometry const& geometry)
+{
+	std::vector<std::pair<GLuint, GLuint>> edges;
+	for (std::size_t i = 0; i + 1 < geometry.lineIndexCount; i += 2)
+	{
+		auto const a = geometry.indices[i];
+		auto const b = geometry.indices[i + 1];
+		edges.emplace_back(std::min(a, b), std::max(a, b));
+	}
+	std::sort(edges.begin(), edges.end());
+	return edges;
+}
+
+
+/** Whether an edge joins vertices at two positions. */
+bool
+hasEdge(
+	b2draw::StaticMesh::Geometry const& geometry,
+	b2Vec2 const& a,
+	b2Vec2 const& b
+)
+{
+	auto const at = [&geometry](GLuint const index, b2Vec2 const& position) {
+		return (geometry.vertices[index].first - position).Length() < 0.01f;
+	};
+	for (auto const& edge: edgesOf(geometry))
+	{
+		if (
+			(at(edge.first, a) && at(edge.second, b)) ||
+			(at(edge.first, b) && at(edge.second, a))
+		)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+} // namespace
+
+
+int
+main()
+{
+	// Two abutting squares, one slightly off, outlined and filled.
+	{
+		b2draw::PrimitiveRenderer lines;
+		b2draw::PrimitiveRenderer fills;
+		addSquare(lines, b2Vec2{0.0f, 0.0f}, lineColour);
+		addSquare(lines, b2Vec2{1.0001f, 0.0f}, lineColour);
+		addSquare(fills, b2Vec2{0.0f, 0.0f}, fillColour);
+		addSquare(fills, b2Vec2{1.0001f, 0.0f}, fillColour);
+
+		auto const geometry = b2draw::StaticMesh::weld(frameOf(lines, fills));
+		auto const& stats = geometry.stats;
+		check(stats.inputVertices == 16u, "abutting: input vertices");
+
+		// Outline and fill vertices differ in colour, so weld apart.
+		check(stats.vertices == 12u, "abutting: welded vertices");
+		check(geometry.vertices.size() == 12u, "abutting: vertex array");
+		check(stats.edges == 6u, "abutting: outline edges kept");
+		check(stats.droppedEdges == 2u, "abutting: shared edge dropped");
+		check(
+			!hasEdge(geometry, b2Vec2{1.0f, 0.0f}, b2Vec2{1.0f, 1.0f}),
+			"abutting: no internal edge");
+		check(
+			hasEdge(geometry, b2Vec2{0.0f, 0.0f}, b2Vec2{1.0f, 0.0f}) &&
+			hasEdge(geometry, b2Vec2{1.0f, 0.0f}, b2Vec2{2.0f, 0.0f}),
+			"abutting: outer edges");
+		check(stats.triangles == 4u, "abutting: triangles");
+		check(
+			geometry.indices.size() ==
+				geometry.lineIndexCount + 3u * stats.triangles,
+			"abutting: triangle indices after lines");
+	}
+
+	// Beyond the welding distance, both copies of the edge are kept.
+	{
+		b2draw::PrimitiveRenderer lines;
+		b2draw::PrimitiveRenderer fills;
+		addSquare(lines, b2Vec2{0.0f, 0.0f}, lineColour);
+		addSquare(lines, b2Vec2{1.01f, 0.0f}, lineColour);
+
+		auto const geometry = b2draw::StaticMesh::weld(frameOf(lines, fills));
+		check(geometry.stats.vertices == 8u, "apart: vertices");
+		check(geometry.stats.edges == 8u, "apart: edges");
+		check(geometry.stats.droppedEdges == 0u, "apart: none dropped");
+	}
+
+	// Edges shared by squares of different colours aren't internal.
+	{
+		b2draw::PrimitiveRenderer lines;
+		b2draw::PrimitiveRenderer fills;
+		addSquare(lines, b2Vec2{0.0f, 0.0f}, lineColour);
+		addSquare(lines, b2Vec2{1.0f, 0.0f}, otherColour);
+
+		auto const geometry = b2draw::StaticMesh::weld(frameOf(lines, fills));
+		check(geometry.stats.edges == 8u, "colours: edges");
+	}
+
+	// An edge shared by three loops is kept once, as is a repeated one.
+	{
+		b2draw::PrimitiveRenderer lines;
+		b2draw::PrimitiveRenderer fills;
+		addSquare(lines, b2Vec2{0.0f, 0.0f}, lineColour);
+		addSquare(lines, b2Vec2{0.0f, 0.0f}, lineColour);
+		addSquare(lines, b2Vec2{0.0f, 0.0f}, lineColour);
+
+		auto const geometry = b2draw::StaticMesh::weld(frameOf(lines, fills));
+		check(geometry.stats.vertices == 4u, "repeated: vertices");
+		check(geometry.stats.edges == 4u, "repeated: edges");
+		check(geometry.stats.droppedEdges == 8u, "repeated: dropped");
+	}
+
+	// Fans collapsed by welding leave no triangles.
+	{
+		b2draw::PrimitiveRenderer lines;
+		b2draw::PrimitiveRenderer fills;
+		b2Vec2 const sliver[3] = {
+			{0.0f, 0.0f}, {0.0001f, 0.0f}, {0.0f, 0.0001f}};
+		fills.addPolygon(sliver, 3, fillColour);
+
+		auto const geometry = b2draw::StaticMesh::weld(frameOf(lines, fills));
+		check(geometry.stats.vertices == 1u, "collapsed: vertices");
+		check(geometry.stats.triangles == 0u, "collapsed: triangles");
+	}
+
+	if (failures)
+	{
+		std::cerr << failures << " check(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}